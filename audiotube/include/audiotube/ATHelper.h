@@ -22,4 +22,5 @@
 namespace AudioTube {
     int safe_stoi(const std::string &str);
     std::vector<std::string> splitString(const std::string &s, char delim);
+    std::string trimmed(const std::string &s);
 }  // namespace AudioTube
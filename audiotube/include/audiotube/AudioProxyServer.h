@@ -0,0 +1,117 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <optional>
+#include <list>
+#include <unordered_map>
+
+#include "_NetworkHelper.h"
+#include "VideoMetadata.h"
+#include "Singleflight.h"
+#include "ChunkCache.h"
+
+namespace AudioTube {
+
+// Serves audio streams on a stable local URL, http://127.0.0.1:<port>/<videoId>, with Range support.
+// Streams are resolved through NetworkFetcher and fetched upstream by fixed-size chunks : concurrent clients asking
+// for the same chunk share a single upstream request, and chunks are served from / written to an optional ChunkCache.
+class AudioProxyServer : public NetworkHelper {
+ public:
+    struct Settings {
+        unsigned short port = 0;                 // 0 for any free port
+        ChunkCache* cache = nullptr;             // optional, must outlive the server
+        uint64_t chunkSize = 1024 * 1024;        // ignored if cache is set, its own chunk size is used
+        Deadline::Timeouts timeouts;             // of each upstream request
+        size_t maxUpstreams = 64;                // resolved videos kept, least recently used ones not being served are forgotten beyond
+    };
+
+    AudioProxyServer();
+    explicit AudioProxyServer(const Settings &settings);
+    virtual ~AudioProxyServer();
+
+    unsigned short port() const;
+    std::string urlOf(const std::string &videoId) const;
+
+    // RFC 7233 single range "bytes=first-last", "bytes=first-" or "bytes=-suffixLength"; empty if unsatisfiable or malformed
+    static std::optional<ByteRange> parseRange(const std::string &rangeHeader, uint64_t totalSize);
+
+ protected:
+    // resolved stream of a video
+    struct _Upstream {
+        std::mutex mutex;
+        std::unique_ptr<VideoMetadata> metadata;  // none if not located through NetworkFetcher
+        std::string url;
+        int itag = 0;
+        uint64_t totalSize = 0;
+        std::string contentType;
+    };
+
+    struct _Source {
+        std::string url;
+        int itag = 0;
+    };
+
+    // stream to proxy for a video, located through NetworkFetcher; called with upstream mutex held
+    virtual _Source _locate(const std::string &videoId, _Upstream &upstream, bool forceRefresh);
+
+ private:
+
+    struct _Session {
+        std::shared_ptr<tcp::socket> socket;
+        std::thread thread;
+        std::shared_ptr<std::atomic<bool>> done;
+    };
+
+    Settings _settings;
+    std::atomic<bool> _running { true };
+
+    asio::io_context _ioContext;
+    tcp::acceptor _acceptor;
+    std::thread _acceptThread;
+
+    std::mutex _sessionsMutex;
+    std::list<_Session> _sessions;
+
+    struct _Resolved {
+        std::shared_ptr<_Upstream> upstream;
+        std::chrono::steady_clock::time_point lastUsed;
+    };
+
+    std::mutex _upstreamsMutex;
+    std::unordered_map<std::string, _Resolved> _upstreams;
+    Singleflight<std::string, std::string> _inflightChunks;
+
+    void _acceptLoop();
+    void _joinFinishedSessions();
+    void _serve(std::shared_ptr<tcp::socket> socket);
+
+    std::shared_ptr<_Upstream> _resolve(const std::string &videoId, bool forceRefresh);
+    void _evictUpstreams();  // requires upstreams lock
+    std::string _chunk(const std::string &videoId, std::shared_ptr<_Upstream> upstream, uint64_t chunkIndex);
+    std::string _fetchChunk(const std::string &videoId, std::shared_ptr<_Upstream> upstream, uint64_t chunkIndex);
+    uint64_t _chunkSize() const;
+
+    static void _replyError(tcp::socket &socket, unsigned int statusCode, const std::string &reason);
+};
+
+}  // namespace AudioTube
@@ -0,0 +1,129 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <cstdint>
+#include <unordered_map>
+
+#include "MappedFile.h"
+
+namespace AudioTube {
+
+// On-disk cache of fixed-size stream chunks, keyed by video id, itag and chunk index.
+// Chunks live in slots of memory-mapped segment files; least recently used ones are evicted to stay within disk budget.
+// Index is persisted on flush() and destruction, so cached chunks survive restarts. It is removed before any slot it references
+// gets reused, so that after a crash, chunks are either the ones of the last flush or none at all, never wrong ones.
+class ChunkCache {
+ public:
+    struct Settings {
+        std::string directory;
+        uint64_t chunkSize = 1024 * 1024;
+        uint64_t diskBudget = 512ull * 1024 * 1024;
+        unsigned int chunksPerSegment = 64;
+    };
+
+    struct Key {
+        std::string videoId;
+        int itag = 0;
+        uint64_t chunkIndex = 0;
+    };
+
+    struct Stats {
+        size_t chunks = 0;
+        size_t capacity = 0;         // in chunks
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+    };
+
+    // read-only chunk, straight from the mapping; the chunk cannot be evicted while a view on it exists, which must not outlive the cache
+    class View {
+     public:
+        View(View &&other) noexcept;
+        View& operator=(View &&other) noexcept;
+        View(const View&) = delete;
+        View& operator=(const View&) = delete;
+        ~View();
+
+        const char* data() const;
+        size_t size() const;
+
+     private:
+        friend class ChunkCache;
+        View(ChunkCache* cache, const std::string &key, std::shared_ptr<MappedFile> segment, const char* data, size_t size);
+
+        ChunkCache* _cache = nullptr;
+        std::string _key;
+        std::shared_ptr<MappedFile> _segment;
+        const char* _data = nullptr;
+        size_t _size = 0;
+    };
+
+    explicit ChunkCache(const Settings &settings);
+    ~ChunkCache();
+
+    uint64_t chunkSize() const;
+
+    std::optional<View> get(const Key &key);
+    bool contains(const Key &key);
+
+    // false if chunk is too big, or if every slot is in use
+    bool put(const Key &key, const char* data, size_t size);
+
+    void flush();
+    Stats stats();
+
+ private:
+    struct _Entry {
+        uint32_t slot = 0;
+        uint32_t size = 0;
+        unsigned int pins = 0;
+        bool ready = false;                       // fully written
+        std::list<std::string>::iterator lru;
+    };
+
+    Settings _settings;
+    uint32_t _capacity = 0;
+
+    std::mutex _mutex;
+    std::unordered_map<std::string, _Entry> _entries;
+    std::list<std::string> _lru;  // most recent first
+    std::vector<uint32_t> _freeSlots;
+    std::vector<std::shared_ptr<MappedFile>> _segments;
+    Stats _stats;
+    bool _indexOnDisk = false;  // persisted index might reference slots still in use
+
+    static std::string _keyOf(const Key &key);
+    std::string _indexPath() const;
+
+    void _loadIndex();
+    void _saveIndex();
+    bool _removeIndex();
+
+    // require lock
+    std::shared_ptr<MappedFile> _segmentOf(uint32_t slot);
+    char* _slotData(uint32_t slot);
+    std::optional<uint32_t> _takeSlot();
+
+    void _unpin(const std::string &key);
+};
+
+}  // namespace AudioTube
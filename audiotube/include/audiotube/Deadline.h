@@ -0,0 +1,110 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <stdexcept>
+
+namespace AudioTube {
+
+class DeadlineExceededError : public std::runtime_error {
+ public:
+    using std::runtime_error::runtime_error;
+};
+
+class CancelledError : public std::runtime_error {
+ public:
+    using std::runtime_error::runtime_error;
+};
+
+// Token handed to requests, cancelled once its source is
+class CancellationToken {
+ public:
+    CancellationToken();  // never cancelled
+    bool isCancelled() const;
+
+ private:
+    friend class CancellationSource;
+    CancellationToken(const std::shared_ptr<std::atomic<unsigned int>> &generation, unsigned int issuedAt);
+
+    std::shared_ptr<std::atomic<unsigned int>> _generation;
+    unsigned int _issuedAt = 0;
+};
+
+// Cancelling a source cancels all the tokens it issued before, not the ones issued after
+class CancellationSource {
+ public:
+    CancellationSource();
+
+    CancellationToken token() const;
+    void cancel();
+
+ private:
+    std::shared_ptr<std::atomic<unsigned int>> _generation;
+};
+
+// Time budget of a whole pipeline (total), and of each phase of the requests made within it
+class Deadline {
+ public:
+    using Clock = std::chrono::steady_clock;
+
+    enum Phase {
+        Connect,
+        TLS,
+        FirstByte
+    };
+
+    struct Timeouts {
+        std::chrono::milliseconds connect { 5000 };      // DNS + TCP
+        std::chrono::milliseconds tls { 5000 };          // handshake
+        std::chrono::milliseconds firstByte { 10000 };   // request sent until status line received
+        std::chrono::milliseconds total { 0 };           // whole pipeline, <= 0 for unlimited
+    };
+
+    Deadline();
+    explicit Deadline(const Timeouts &timeouts, const CancellationToken &token = CancellationToken());
+
+    // limit of a phase starting now, never beyond total
+    Clock::time_point phaseLimit(const Phase &phase) const;
+    Clock::time_point expiresAt() const;
+
+    bool isCancelled() const;
+    bool isExpired() const;
+    bool isOver() const;  // cancelled or expired
+    void throwIfOver(const std::string &what) const;
+
+    // waits for a work run by someone else, checking in slices whether we are over
+    template<typename T>
+    void wait(const std::shared_future<T> &future, const std::string &what) const {
+        while (future.wait_for(_waitSlice) != std::future_status::ready) {
+            this->throwIfOver(what);
+        }
+    }
+
+    const CancellationToken& token() const;
+
+ private:
+    static constexpr std::chrono::milliseconds _waitSlice { 50 };
+
+    Timeouts _timeouts;
+    Clock::time_point _expiresAt;
+    CancellationToken _token;
+};
+
+}  // namespace AudioTube
@@ -0,0 +1,46 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+namespace AudioTube {
+
+// Low-level EBML (RFC 8794) decoding, shared by WebM parsers
+class EbmlReader {
+ public:
+    struct Header {
+        uint32_t id = 0;        // including its length marker bits
+        uint64_t size = 0;
+        bool unknownSize = false;
+        size_t length = 0;      // of id + size
+    };
+
+    // value and length of a variable size integer; empty if incomplete, throws std::runtime_error if invalid
+    static std::optional<std::pair<uint64_t, size_t>> readVint(const char* data, size_t size, bool keepMarker);
+    static std::optional<Header> readHeader(const char* data, size_t size);
+
+    static uint64_t readUInt(std::string_view body);
+    static double readFloat(std::string_view body);
+
+    // iterates over complete children of a master element body, stops at the first truncated one
+    static void forEachChild(std::string_view body, const std::function<void(uint32_t id, std::string_view childBody)> &onChild);
+};
+
+}  // namespace AudioTube
@@ -0,0 +1,64 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <optional>
+
+#include "_NetworkHelper.h"
+
+namespace AudioTube {
+
+// A GET response whose body is read on demand, over a connection kept open for as long as needed
+class HTTPStream : public NetworkHelper {
+ public:
+    // connects, sends request and reads response head, following redirects
+    static std::unique_ptr<HTTPStream> open(const std::string &url, const Deadline &deadline = Deadline(),
+                                            const std::vector<std::string> &extraHeaders = std::vector<std::string>());
+    ~HTTPStream();
+
+    // status and headers, body is left empty
+    const NetworkHelper::Response& head() const;
+
+    // last URL reached, after redirects
+    std::string url() const;
+
+    // reads at least 1 byte up to maxBytes, 0 means end of stream; throws std::runtime_error if connection drops before
+    size_t read(char* out, size_t maxBytes, const Deadline &deadline = Deadline());
+    bool atEnd() const;
+
+ private:
+    explicit HTTPStream(const std::string &url);
+
+    std::string _url;
+    asio::io_context _ioContext;
+    ssl::context _sslContext { ssl::context::sslv23 };
+    std::unique_ptr<tcp::socket> _socket;
+    std::unique_ptr<ssl::stream<tcp::socket>> _sslStream;
+    asio::streambuf _buffer;
+    NetworkHelper::Response _head;
+    bool _atEnd = false;
+    std::optional<uint64_t> _bodySize;  // from Content-Length, if any
+    uint64_t _received = 0;
+
+    void _open(const Deadline &deadline, const std::vector<std::string> &extraHeaders);
+
+    template<typename Stream>
+    void _fill(Stream &stream, const Deadline &deadline);
+};
+
+}  // namespace AudioTube
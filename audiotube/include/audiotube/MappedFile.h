@@ -0,0 +1,57 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#ifdef _WIN32
+    #include <windows.h>
+#endif
+
+#include <string>
+#include <cstddef>
+
+namespace AudioTube {
+
+// Whole file mapped read-write in memory, created or grown to the requested size
+class MappedFile {
+ public:
+    MappedFile(const std::string &path, size_t size);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    char* data();
+    const char* data() const;
+    size_t size() const;
+
+    // writes dirty pages back to disk
+    void flush();
+
+ private:
+    std::string _path;
+    size_t _size = 0;
+    char* _data = nullptr;
+
+#ifdef _WIN32
+    HANDLE _file = INVALID_HANDLE_VALUE;
+    HANDLE _mapping = nullptr;
+#else
+    int _fd = -1;
+#endif
+
+    void _close();
+};
+
+}  // namespace AudioTube
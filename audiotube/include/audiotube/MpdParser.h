@@ -0,0 +1,96 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <optional>
+
+#include "_NetworkHelper.h"
+
+namespace AudioTube {
+
+// Incremental pull parser of DASH MPD manifests, only keeping audio representations.
+// Bytes can be fed as they are downloaded; markup split across feeds is carried over.
+class MpdParser {
+ public:
+    struct Representation {
+        std::string id;
+        std::string mimeType;
+        std::string codecs;
+        unsigned int bandwidth = 0;
+        unsigned int audioSamplingRate = 0;
+        std::string baseUrl;
+
+        // SegmentBase, whole stream at baseUrl
+        std::optional<NetworkHelper::ByteRange> initRange;
+        std::optional<NetworkHelper::ByteRange> indexRange;
+
+        // SegmentList, absolute urls
+        std::string initializationUrl;
+        std::vector<std::string> segmentUrls;
+    };
+
+    void feed(const char* data, size_t size);
+    void feed(const std::string_view &data);
+
+    // audio representations, in document order
+    const std::vector<Representation>& representations() const;
+
+    // representations seen, audio or not
+    size_t representationsCount() const;
+
+    // closing MPD tag reached
+    bool isComplete() const;
+
+ private:
+    using _Attributes = std::vector<std::pair<std::string_view, std::string_view>>;
+
+    std::string _pending;
+    std::string _text;
+    bool _inBaseUrl = false;
+    bool _inSegmentBase = false;
+    bool _inSegmentList = false;
+    bool _inAdaptationSet = false;
+    bool _inRepresentation = false;
+    bool _complete = false;
+
+    // inherited by nested elements when they start
+    Representation _period;
+    Representation _adaptationSet;
+    std::string _adaptationContentType;
+    Representation _representation;
+
+    size_t _representationsCount = 0;
+    std::vector<Representation> _representations;
+
+    Representation* _scope();
+
+    void _onMarkup(const std::string_view &markup);
+    void _onStart(const std::string_view &name, const _Attributes &attributes);
+    void _onEnd(const std::string_view &name);
+
+    // length of the markup starting at view, if complete
+    static std::optional<size_t> _markupEnd(const std::string_view &view);
+    static std::string_view _localName(const std::string_view &name);
+    static std::string_view _attribute(const _Attributes &attributes, const std::string_view &name);
+    static std::string _unescaped(const std::string_view &value);
+    static std::string _resolved(const std::string &base, const std::string &url);
+    static unsigned int _uintFrom(const std::string_view &value);
+};
+
+}  // namespace AudioTube
@@ -16,23 +16,82 @@
 
 #include <vector>
 #include <string>
+#include <mutex>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <optional>
+#include <unordered_map>
 
 #include "_NetworkHelper.h"
 #include "_DebugHelper.h"
 
 #include "VideoMetadata.h"
 #include "VideoInfos.h"
+#include "UnavailabilityCache.h"
+#include "WebmSeekIndex.h"
+#include "StreamProber.h"
 
 namespace AudioTube {
 
 class NetworkFetcher : public NetworkHelper {
  public:
     static promise::Promise fromPlaylistUrl(const std::string &url);
-    static promise::Promise refreshMetadata(VideoMetadata* toRefresh, bool force = false);
-    static bool isStreamAvailable(VideoMetadata* toCheck);
+    // settled before returning; if the same video is being refreshed elsewhere, waits for it and copies its outcome
+    static promise::Promise refreshMetadata(VideoMetadata* toRefresh, bool force = false, const Deadline::Timeouts &timeouts = refreshTimeouts());
+    // same, but not counted in pendingRefreshes(), for background work yielding to foreground refreshes
+    static promise::Promise refreshMetadataInBackground(VideoMetadata* toRefresh, const Deadline::Timeouts &timeouts = refreshTimeouts());
+
+    // default phase timeouts, whole refresh pipeline bounded to a minute
+    static Deadline::Timeouts refreshTimeouts();
+
+    // unless trustManifest is false, a stream whose size is given by a still valid manifest is deemed available without any request;
+    // others are probed with a 1 byte Range GET over pooled connections, concurrency at a time for batches
+    static bool isStreamAvailable(VideoMetadata* toCheck, bool trustManifest = true, const Deadline::Timeouts &timeouts = Deadline::Timeouts());
+    static std::vector<bool> areStreamsAvailable(const std::vector<VideoMetadata*> &toCheck, bool trustManifest = true, unsigned int concurrency = 4,
+                                                    const Deadline::Timeouts &timeouts = Deadline::Timeouts());
+
+    // Cues of the prefered stream, through a Range request on its init and index ranges
+    static WebmSeekIndex fetchSeekIndex(VideoMetadata* metadata, const Deadline::Timeouts &timeouts = Deadline::Timeouts());
+
+    // once refreshed, start fetching that many bytes of the prefered stream into metadata's prefetch buffer; 0 disables
+    static void setPrefetchSize(size_t bytes);
+
+    // foreground refreshes started and not settled yet, followers of an in-flight refresh excluded
+    static unsigned int pendingRefreshes();
+
+ protected:
+    // whether a previously successful run allows to only refresh streams; failure state is the one before refresh began
+    static bool _canRefreshStreamsOnly(VideoMetadata* metadata, bool failedBefore);
 
  private:
-    static promise::Promise _refreshMetadata(VideoMetadata* metadata);
+    static inline std::atomic<size_t> _prefetchSize { 0 };
+    static inline std::atomic<unsigned int> _pendingRefreshes { 0 };
+    static inline StreamProber _prober;
+    static void _startPrefetch(VideoMetadata* metadata);
+
+    // outcome of a refresh, copied by followers of the same video id in their own thread; null if it failed
+    struct _Refreshed {
+        PlayerConfig playerConfig;
+        StreamsManifest audioStreams;
+    };
+    using _SharedRefresh = std::shared_future<std::shared_ptr<const _Refreshed>>;
+    struct _InflightRefresh {
+        std::promise<std::shared_ptr<const _Refreshed>> leader;
+        _SharedRefresh shared;
+    };
+    static inline std::mutex _inflightMutex;
+    static inline std::unordered_map<PlayerConfig::VideoId, _InflightRefresh> _inflightRefreshes;
+
+    // nothing if metadata leads the refresh of its video id, the in-flight refresh to follow otherwise
+    static std::optional<_SharedRefresh> _followInflightRefresh(VideoMetadata* metadata);
+    static void _awaitInflightRefresh(VideoMetadata* follower, const _SharedRefresh &inflight, const Deadline &deadline, promise::Defer d);
+    static void _settleInflightRefresh(VideoMetadata* leader, bool succeeded);
+
+    static promise::Promise _refresh(VideoMetadata* toRefresh, bool force, const Deadline::Timeouts &timeouts, bool background);
+    static promise::Promise _refreshMetadata(VideoMetadata* metadata, const Deadline &deadline, bool failedBefore);
+    static promise::Promise _refreshAllMetadata(VideoMetadata* metadata, const Deadline &deadline);
+    static promise::Promise _refreshStreamsOnly(VideoMetadata* metadata, const Deadline &deadline);
 
     static std::vector<std::string> _extractVideoIdsFromHTTPRequest(const DownloadedUtf8 &requestData);
     static std::vector<VideoMetadata*> _videoIdsToMetadataList(const std::vector<std::string> &videoIds);
@@ -0,0 +1,73 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#ifdef AUDIOTUBE_WITH_OPUS
+
+#include <opus.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+#include "SpscRingBuffer.h"
+
+namespace AudioTube {
+
+// Decodes Opus packets (eg. from WebmDemuxer) to interleaved 48kHz float PCM, pulled by an audio thread from a lock-free ring.
+// decode() is to be called from a single producer thread, pull() from a single consumer thread.
+class OpusDecodeStage {
+ public:
+    static constexpr int SampleRate = 48000;
+
+    // from OpusHead (CodecPrivate of the WebM track); only mono and stereo streams (mapping family 0) are supported
+    OpusDecodeStage(const std::string &opusHead, size_t ringFrames = SampleRate);
+    ~OpusDecodeStage();
+
+    OpusDecodeStage(const OpusDecodeStage&) = delete;
+    OpusDecodeStage& operator=(const OpusDecodeStage&) = delete;
+
+    int channels() const;
+
+    // producer : true if any packet fits in ring, wait for consumer otherwise
+    bool canAccept() const;
+    // producer : decodes a packet into the ring, which must be able to accept it; throws std::runtime_error on decoding error
+    void decode(std::string_view packet);
+    // producer : after a seek, forget previous packets and drop the pre-roll (SeekPreRoll of the WebM track, 80ms as usually muxed)
+    void resetDecoder(uint64_t seekPreRollNs = 80000000);
+
+    // consumer : up to frames interleaved frames, never blocks nor allocates
+    size_t pull(float* out, size_t frames);
+    size_t bufferedFrames() const;
+
+ private:
+    static constexpr int _maxPacketFrames = SampleRate * 120 / 1000;  // 120ms
+
+    int _channels = 0;
+    int _preSkip = 0;            // frames to drop at start
+    int _toSkip = 0;             // frames still to drop, after start or seek
+    OpusDecoder* _decoder = nullptr;
+
+    std::vector<float> _scratch;
+    SpscRingBuffer<float> _ring;
+
+    // needed before ring allocation
+    static int _channelsOf(const std::string &opusHead);
+};
+
+}  // namespace AudioTube
+
+#endif
@@ -0,0 +1,59 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <string_view>
+#include <array>
+
+namespace AudioTube {
+
+// Finds every anchor needed from a downloaded page or player source in a single pass.
+// Bytes are dispatched through a first-byte table, so only anchor candidates are compared.
+class PageScanner {
+ public:
+    enum Anchor : unsigned int {
+        PlayerSourcePath = 1 << 0,       // src of the player_ias <script>
+        InitialPlayerResponse = 1 << 1,  // ytInitialPlayerResponse JSON object
+        EmbedPlayerConfig = 1 << 2,      // PLAYER_CONFIG JSON object
+        SignatureTimestamp = 1 << 3,     // digits after signatureTimestamp
+        AllAnchors = 0xF
+    };
+
+    // first occurrences, as views into the scanned document; empty if not found
+    struct Anchors {
+        std::string_view playerSourcePath;
+        std::string_view initialPlayerResponse;
+        std::string_view embedPlayerConfig;
+        std::string_view signatureTimestamp;
+    };
+
+    // stops as soon as every wanted anchor is found
+    static Anchors scan(const std::string_view &document, unsigned int wanted = AllAnchors);
+
+    // position of the brace closing the JSON object opened at "opening", skipping strings; npos if unbalanced
+    static size_t closingBrace(const std::string_view &document, size_t opening);
+
+ private:
+    static constexpr std::array<unsigned char, 256> _firstBytes();
+
+    // each returns where scanning resumes if the anchor is there, npos otherwise
+    static size_t _scriptSrc(const std::string_view &document, size_t pos, std::string_view* found);
+    static size_t _assignedObject(const std::string_view &document, size_t pos, const std::string_view &name, char assignment, bool quoted, std::string_view* found);
+    static size_t _timestamp(const std::string_view &document, size_t pos, std::string_view* found);
+
+    static size_t _skipSpaces(const std::string_view &document, size_t pos);
+};
+
+}  // namespace AudioTube
@@ -20,6 +20,9 @@
 #include "_NetworkHelper.h"
 #include "SignatureDecipherer.h"
 #include "StreamsManifest.h"
+#include "UnavailabilityCache.h"
+#include "PlayerResponse.h"
+#include "PageScanner.h"
 
 #include <nlohmann/json.hpp>
 
@@ -35,8 +38,8 @@ class PlayerConfig : public NetworkHelper {
 
     using VideoId = std::string;
 
-    static promise::Promise from_EmbedPage(const PlayerConfig::VideoId &videoId);
-    static promise::Promise from_WatchPage(const PlayerConfig::VideoId &videoId, StreamsManifest* streamsManifest);
+    static promise::Promise from_EmbedPage(const PlayerConfig::VideoId &videoId, const Deadline &deadline = Deadline());
+    static promise::Promise from_WatchPage(const PlayerConfig::VideoId &videoId, StreamsManifest* streamsManifest, const Deadline &deadline = Deadline());
 
     PlayerConfig();
 
@@ -57,17 +60,17 @@ class PlayerConfig : public NetworkHelper {
     int _duration = 0;
     std::string _sts;
 
-    static promise::Promise _downloadRaw_VideoEmbedPageHtml(const PlayerConfig::VideoId &videoId);
-    static promise::Promise _downloadRaw_WatchPageHtml(const PlayerConfig::VideoId &videoId);
+    static promise::Promise _downloadRaw_VideoEmbedPageHtml(const PlayerConfig::VideoId &videoId, const Deadline &deadline);
+    static promise::Promise _downloadRaw_WatchPageHtml(const PlayerConfig::VideoId &videoId, const Deadline &deadline);
 
-    promise::Promise _downloadAndfillFrom_PlayerSource(const std::string &playerSourceUrl);
+    promise::Promise _downloadAndfillFrom_PlayerSource(const std::string &playerSourceUrl, const Deadline &deadline);
 
-    promise::Promise _fillFrom_WatchPageHtml(const DownloadedUtf8 &dl, StreamsManifest* streamsManifest);
-    promise::Promise _fillFrom_VideoEmbedPageHtml(const DownloadedUtf8 &dl);
+    promise::Promise _fillFrom_WatchPageHtml(const DownloadedUtf8 &dl, StreamsManifest* streamsManifest, const Deadline &deadline);
+    promise::Promise _fillFrom_VideoEmbedPageHtml(const DownloadedUtf8 &dl, const Deadline &deadline);
     promise::Promise _fillFrom_PlayerSource(const DownloadedUtf8 &dl, const std::string &playerSourceUrl);
 
-    static nlohmann::json _extractPlayerConfigFromRawSource(const DownloadedUtf8 &rawSource, const jp::Regex &regexToJSONStart);
-    static std::string _extractPlayerSourceURLFromRawSource(const DownloadedUtf8 &rawSource);
+    static PlayerResponse _extractPlayerResponse(const PageScanner::Anchors &anchors);
+    static std::string _extractPlayerSourceURL(const PageScanner::Anchors &anchors);
 
     // extraction helpers
     static std::string _playerSourceUrl(const nlohmann::json &playerConfig);
@@ -0,0 +1,78 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <cstdint>
+
+#include "_NetworkHelper.h"
+
+namespace AudioTube {
+
+// What is used of a player response, whichever JSON backend parsed it
+struct PlayerResponse {
+    struct Format {
+        int itag = 0;
+        std::string mimeType;
+        uint64_t bitrate = 0;
+        std::string url;
+        std::string cipher;  // "cipher" query, else "signatureCipher" one, when url is not given
+        uint64_t contentLength = 0;
+        uint64_t approxDurationMs = 0;
+        unsigned int audioSampleRate = 0;
+        std::optional<NetworkHelper::ByteRange> initRange;
+        std::optional<NetworkHelper::ByteRange> indexRange;
+    };
+
+    bool hasVideoDetails = false;
+    std::string title;
+    std::string lengthSeconds;
+    bool isLiveContent = false;
+
+    std::string playabilityStatus;
+    std::optional<std::string> playabilityReason;
+
+    bool hasStreamingData = false;
+    std::string expiresInSeconds;
+    std::string dashManifestUrl;
+    std::vector<Format> audioFormats;
+};
+
+class PlayerResponseParser {
+ public:
+    enum class Backend {
+        Nlohmann,
+        Simdjson
+    };
+
+    // simdjson when built with AUDIOTUBE_WITH_SIMDJSON
+    static Backend defaultBackend();
+    static bool isAvailable(Backend backend);
+
+    // throws on malformed documents, or if backend is not built in
+    static PlayerResponse parse(const std::string_view &json, Backend backend = defaultBackend());
+
+ private:
+    static PlayerResponse _parseWithNlohmann(const std::string_view &json);
+    static PlayerResponse _parseWithSimdjson(const std::string_view &json);
+
+    static bool _isAudio(const std::string_view &mimeType);
+    static uint64_t _numberFrom(const std::string_view &value);
+};
+
+}  // namespace AudioTube
@@ -0,0 +1,49 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <map>
+#include <functional>
+
+#include <nlohmann/json.hpp>
+
+namespace AudioTube {
+
+// Builds a DOM of only the parts of a JSON document described by a schema, through nlohmann's SAX interface;
+// anything else is skipped as it is read, without being materialised
+class PlayerResponseExtractor {
+ public:
+    struct Schema {
+        bool whole = false;                                      // keep value and everything below it
+        std::map<std::string, Schema> fields;                    // otherwise, these fields of an object only
+        std::function<bool(const nlohmann::json&)> itemFilter;   // for arrays, items are kept only if true
+    };
+
+    // videoDetails, playabilityStatus and, from streamingData, expiresInSeconds, dashManifestUrl and audio adaptiveFormats
+    static const Schema& playerResponseSchema();
+
+    // throws on malformed documents
+    static nlohmann::json extract(const std::string_view &json, const Schema &schema = playerResponseSchema());
+
+    // field of an object without copying it, null if missing
+    static const nlohmann::json& field(const nlohmann::json &object, const std::string &key);
+
+ private:
+    class _Handler;
+};
+
+}  // namespace AudioTube
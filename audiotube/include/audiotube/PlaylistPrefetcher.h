@@ -0,0 +1,83 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <unordered_set>
+
+#include "VideoMetadata.h"
+
+namespace AudioTube {
+
+// Resolves and warms the tracks following the one being played, so moving to the next one needs no request.
+// Work happens on a dedicated thread, one track at a time, and yields while NetworkFetcher has foreground refreshes pending.
+class PlaylistPrefetcher {
+ public:
+    struct Settings {
+        size_t lookAhead = 2;                                   // upcoming tracks to warm
+        size_t bytesPerTrack = 256 * 1024;                      // prefetched from each upcoming track
+        size_t memoryBudget = 1024 * 1024;                      // cap of all prefetch buffers of upcoming tracks, reduces look-ahead if needed
+        std::chrono::milliseconds yieldInterval { 100 };       // polling delay while foreground work is pending
+        std::chrono::seconds recheckInterval { 30 };           // wake up to re-resolve expired upcoming tracks
+    };
+
+    PlaylistPrefetcher();
+    explicit PlaylistPrefetcher(const Settings &settings);
+    ~PlaylistPrefetcher();
+
+    // metadata must outlive the prefetcher, or be replaced by another playlist first : once this returns,
+    // previous playlist is released and never touched again, waiting for the track being warmed if any
+    void setPlaylist(const std::vector<VideoMetadata*> &playlist);
+
+    // track being played; prefetch buffer of current track is left to consumer, the ones out of window are released
+    void setCurrent(size_t index);
+
+    // upcoming tracks actually warmed, given memory budget
+    size_t effectiveLookAhead() const;
+
+ private:
+    Settings _settings;
+
+    std::mutex _mutex;
+    std::condition_variable _changed;
+    std::thread _worker;
+
+    // held by worker while it touches metadata, taken before _mutex
+    std::mutex _workMutex;
+
+    std::vector<VideoMetadata*> _playlist;
+    size_t _current = 0;
+    bool _dirty = false;
+    bool _stopRequested = false;
+
+    // requires work lock
+    std::unordered_set<VideoMetadata*> _warmed;
+
+    void _run();
+    std::vector<VideoMetadata*> _window();
+    VideoMetadata* _currentMetadata();
+    void _releaseOutOf(const std::vector<VideoMetadata*> &window, VideoMetadata* current);
+    bool _waitForegroundIdle();
+    void _warm(VideoMetadata* metadata, size_t* budgetLeft);
+
+    // requires lock
+    bool _interrupted() const;
+};
+
+}  // namespace AudioTube
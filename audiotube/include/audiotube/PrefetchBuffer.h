@@ -0,0 +1,85 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "HTTPStream.h"
+#include "Deadline.h"
+
+namespace AudioTube {
+
+// Fetches the beginning of a stream in the background into a fixed-size ring, to cut time-to-first-audio.
+// Consumer either reads from it directly, or takes over both the buffered bytes and the live connection.
+class PrefetchBuffer {
+ public:
+    struct Handoff {
+        std::string url;                          // last URL reached, after redirects
+        uint64_t offset = 0;                      // position of bytes within stream
+        std::vector<char> bytes;                  // buffered, not yet read
+        std::unique_ptr<HTTPStream> connection;   // continues right after bytes, empty if prefetching failed or stalled; at end of stream, reads 0 right away
+    };
+
+    PrefetchBuffer();
+    ~PrefetchBuffer();
+
+    // replaces any previous prefetch
+    void start(const std::string &url, size_t capacity, const Deadline::Timeouts &timeouts = Deadline::Timeouts());
+    void stop();
+    bool isStarted();
+
+    // waits for prefetched bytes, 0 means end of stream
+    size_t read(char* out, size_t maxBytes, const CancellationToken &token = CancellationToken());
+
+    // stops prefetching without closing the connection, unless the read in progress does not complete within grace
+    Handoff takeOver(std::chrono::milliseconds grace = std::chrono::milliseconds(500));
+
+    size_t buffered();
+    size_t capacity();  // 0 if not started
+
+ private:
+    std::mutex _mutex;
+    std::condition_variable _changed;
+    std::thread _worker;
+    CancellationSource _cancellation;
+
+    std::string _url;
+    std::vector<char> _ring;
+    size_t _readPos = 0;
+    size_t _size = 0;
+    uint64_t _consumed = 0;
+    std::unique_ptr<HTTPStream> _connection;
+
+    bool _started = false;
+    bool _stopRequested = false;
+    bool _finished = false;
+    bool _reading = false;  // worker waits for upstream, opening included
+    std::string _error;
+
+    void _run(const Deadline::Timeouts &timeouts, const CancellationToken &token);
+    void _join();
+
+    // requires lock
+    void _push(const char* data, size_t count);
+    size_t _pop(char* out, size_t maxBytes);
+};
+
+}  // namespace AudioTube
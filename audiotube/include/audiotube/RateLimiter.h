@@ -0,0 +1,85 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+
+#include "Deadline.h"
+
+namespace AudioTube {
+
+// Per-host token bucket, paused when upstream asks us to slow down (429 / Retry-After)
+class RateLimiter {
+ public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Settings {
+        double requestsPerSecond = 5;                         // sustained rate, per host
+        double burst = 10;                                    // bucket capacity
+        std::chrono::milliseconds backoffBase { 500 };        // first retry delay
+        std::chrono::milliseconds backoffCap { 30000 };       // max retry delay
+        unsigned int maxRetries = 4;                          // throttled retries before giving up
+    };
+
+    struct Metrics {
+        std::string host;
+        double availableTokens = 0;
+        unsigned int requests = 0;
+        unsigned int throttled = 0;
+        unsigned int retries = 0;
+        std::chrono::milliseconds blockedFor { 0 };          // remaining penalty, if any
+    };
+
+    RateLimiter();
+
+    void setSettings(const Settings &settings);
+    Settings settings();
+
+    // blocks until a request to this host is allowed, or deadline is over
+    void acquire(const std::string &host, const Deadline &deadline = Deadline());
+
+    // upstream throttled us, pause host for the given delay
+    void penalize(const std::string &host, const std::chrono::milliseconds &delay);
+    void countRetry(const std::string &host);
+
+    // decorrelated jitter exponential backoff, from the previous delay
+    std::chrono::milliseconds nextBackoff(const std::chrono::milliseconds &previous);
+
+    std::vector<Metrics> metrics();
+
+ private:
+    struct _Bucket {
+        double tokens = 0;
+        Clock::time_point refilledAt;
+        Clock::time_point blockedUntil;
+        unsigned int requests = 0;
+        unsigned int throttled = 0;
+        unsigned int retries = 0;
+    };
+
+    Settings _settings;
+    std::mutex _mutex;
+    std::unordered_map<std::string, _Bucket> _buckets;
+    std::mt19937 _rng;
+
+    _Bucket& _bucketOf(const std::string &host, const Clock::time_point &now);
+};
+
+}  // namespace AudioTube
@@ -0,0 +1,90 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+
+#include "_NetworkHelper.h"
+#include "VideoMetadata.h"
+
+namespace AudioTube {
+
+// Keeps tracked metadata warm by refreshing them a little before their prefered stream expires.
+// Refreshes happen on a dedicated thread, one at a time, so callbacks of tracked metadata are fired from it.
+// Manifests of tracked metadata are only read from that thread too : refreshing them elsewhere meanwhile is up to the caller to avoid.
+class RefreshScheduler {
+ public:
+    // Careful, order is important ! (higher is refreshed first)
+    enum Priority {
+        Background,
+        Normal,
+        Urgent
+    };
+
+    struct Settings {
+        std::chrono::seconds refreshMargin { 300 };        // refresh this long before the prefered stream expires
+        std::chrono::milliseconds minInterval { 500 };     // minimum delay between 2 refreshes
+        std::chrono::milliseconds maxJitter { 30000 };     // random advance applied to each due date
+        std::chrono::seconds retryAfterFailure { 120 };    // delay before retrying a failed refresh
+    };
+
+    RefreshScheduler();
+    explicit RefreshScheduler(const Settings &settings);
+    ~RefreshScheduler();
+
+    void track(VideoMetadata* metadata, Priority priority = Priority::Normal);
+    void untrack(VideoMetadata* metadata);
+    void setPriority(VideoMetadata* metadata, Priority priority);
+    size_t trackedCount();
+
+ protected:
+    using Clock = std::chrono::steady_clock;
+
+    // when metadata should be refreshed next, jitter drawn from settings
+    Clock::time_point _dueDateOf(VideoMetadata* metadata);
+
+ private:
+
+    struct _Entry {
+        Priority priority = Priority::Normal;
+        Clock::time_point dueAt;
+    };
+
+    Settings _settings;
+
+    asio::io_context _ioContext;
+    asio::executor_work_guard<asio::io_context::executor_type> _workGuard;
+    asio::steady_timer _timer;
+    std::thread _worker;
+
+    std::mutex _mutex;
+    std::condition_variable _refreshDone;
+    std::unordered_map<VideoMetadata*, _Entry> _entries;
+    VideoMetadata* _refreshing = nullptr;
+    Clock::time_point _lastRefreshAt;
+    std::mt19937 _rng;
+
+    VideoMetadata* _nextDue(const Clock::time_point &now, Clock::time_point* nextDueAt);
+
+    void _rearm();
+    void _onTimer(const asio::error_code &ec);
+};
+
+}  // namespace AudioTube
@@ -15,8 +15,9 @@
 #pragma once
 
 #include <string>
-#include <map>
-#include <regex>
+#include <string_view>
+#include <vector>
+#include <utility>
 
 #include "jpcre2.hpp"
 
@@ -28,80 +29,55 @@ namespace AudioTube {
 
 class Regexes {
  public:
-    // 1# <itag>, 2# <codec>, 3# <bitrate>, 4# <url>
-    static inline jp::Regex DASHManifestExtractor {
-        R"|(<Representation id="(.*?)" codecs="(.*?)"[\s\S]*?bandwidth="(.*?)"[\s\S]*?<BaseURL>(.*?)<\/BaseURL)|"
+    // fixed patterns, compiled at build time when AUDIOTUBE_WITH_CTRE is set; groups of every match, in order
+
+    // <videoId>
+    static std::vector<std::string> findYoutubeIds(const std::string &subject);
+    // <videoId>
+    static std::vector<std::string> findHTTPRequestYTVideoIds(const std::string &subject);
+    // <functionName>
+    static std::vector<std::string> Decipherer_findCalledFunctions(const std::string &subject);
+    // <functionName>, <arg>
+    static std::vector<std::pair<std::string, std::string>> Decipherer_findFuncAndArguments(const std::string &subject);
+    // <functionName>, operation it performs; over the body of the helper object, in a single pass
+    static std::vector<std::pair<std::string, CipherOperation>> Decipherer_findHelperOperations(const std::string &subject);
+
+    // #1 <functionName>
+    static inline jp::Regex Decipherer_findFunctionName {
+        R"|((\w+)=function\(\w+\)\{(\w+)=\2\.split\(\x22{2}\);.*?return\s+\2\.join\(\x22{2}\)\})|"
     };
 
+ private:
+#ifndef AUDIOTUBE_WITH_CTRE
     // #1 <videoId>
-    static inline jp::Regex YoutubeIdFinder {
+    static inline jp::Regex _YoutubeIdFinder {
         R"|((?:youtube\.com|youtu.be).*?(?:v=|embed\/)([\w\-]+))|"
     };
 
     // #1 <videoId>
-    static inline jp::Regex HTTPRequestYTVideoIdExtractor {
+    static inline jp::Regex _HTTPRequestYTVideoIdExtractor {
         R"|(watch\?v=(.*?)&amp;)|"
     };
 
-    // https://stackoverflow.com/questions/546433/regular-expression-to-match-balanced-parentheses
-    static inline jp::Regex BalancedBraces {
-        R"|(\{(?:[^}{]*(?R)?)*+\})|"
-    };
-
-    static inline jp::Regex FindScriptSrc {
-        R"|(<script.*?src="(.*?)".*?>)|"
-    };
-
-    static inline jp::Regex PlayerConfigExtractorFromEmbed_JSONStart {
-        R"|(['""]PLAYER_CONFIG['""]\s*:\s*(.*))|"
-    };
-
-    // #1 <playerConfig>
-    static inline jp::Regex PlayerConfigExtractorFromWatchPage_JSONStart {
-        R"|(var\s+ytInitialPlayerResponse\s*=\s*(\{.*\}))|"
-    };
-
-    // #1 <sts>
-    static inline jp::Regex STSFinder {
-        R"|((?<=signatureTimestamp[=\:])\d+)|"
+    // #1 <functionName>
+    static inline jp::Regex _Decipherer_findCalledFunction {
+        R"|(\w+\.(\w+)\()|"
     };
 
     // #1 <functionName>, #2 <arg>
-    static inline jp::Regex Decipherer_findFuncAndArgument {
+    static inline jp::Regex _Decipherer_findFuncAndArgument {
         R"|(\.(\w+)\(\w+,(\d+)\))|"
     };
 
-    // #1 <functionName>
-    static inline jp::Regex Decipherer_findFunctionName {
-        R"|((\w+)=function\(\w+\)\{(\w+)=\2\.split\(\x22{2}\);.*?return\s+\2\.join\(\x22{2}\)\})|"
-    };
-
-    // #1 <functionName>
-    static inline jp::Regex Decipherer_findCalledFunction {
-        R"|(\w+\.(\w+)\()|"
-    };
-
-    // Careful, order is important !
-    static std::map<CipherOperation, jp::Regex> Decipherer_DecipheringOps(const std::string &obfuscatedDecipheringFunctionName);
-    static jp::Regex Decipherer_findJSDecipheringOperations(const std::string &obfuscatedDecipheringFunctionName);
-    static std::string escapeForRegex(const std::string &toEscapeForRegex);
-
- private:
-    static inline std::regex _specialChars { R"([-[\]{}()*+?.,\^$|#\s])" };
-
-    // #1 <functionBody>
-    static constexpr auto _Decipherer_JSDecipheringOperations {
-        R"|(%1=function\(\w+\)\{(.*?)\})|"
+    // #1 <functionName>, then #2 Slice, #3 Swap or #4 Reverse
+    static inline jp::Regex _Decipherer_findHelperOperations {
+        R"|((\w+):function\(\w+(?:,\w+)?\)\{(?:(?:return\s+)?\w+\.(splice|slice)\(|(var\s+c=)|\w+\.(reverse)\())|"
     };
 
-    // Careful, order is important !
-    static inline std::map<CipherOperation, std::string> _cipherOperationRegexBase {
-        { CipherOperation::Slice, R"|(%1:\bfunction\b\([a],b\).(\breturn\b)?.?\w+\.)|" },
-        { CipherOperation::Swap, R"|(%1:\bfunction\b\(\w+\,\w\).\bvar\b.\bc=a\b)|" },
-        { CipherOperation::Reverse, R"|(%1:\bfunction\b\(\w+\))|" }
-    };
+    static jp::VecNum _allMatches(const jp::Regex &regex, const std::string &subject);
+#endif
 
-    static std::string _Decipherer_generateRegex(std::string rawRegexAsString, const std::string &obfuscatedDecipheringFunctionName);
+    static CipherOperation _operationOf(const std::string_view &slice, const std::string_view &swap, const std::string_view &reverse);
 };
 
 }  // namespace AudioTube
@@ -0,0 +1,88 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+#include "_NetworkHelper.h"
+#include "Deadline.h"
+#include "ChunkCache.h"
+
+namespace AudioTube {
+
+// Downloads a stream as byte ranges fetched over concurrent connections, written in place into a preallocated destination.
+// Completed segments are remembered, so calling download again after a failure only fetches the missing ones.
+class SegmentedDownloader : public NetworkHelper {
+ public:
+    struct Settings {
+        unsigned int connections = 4;
+        uint64_t segmentSize = 1024 * 1024;
+        unsigned int attemptsPerSegment = 3;
+        Deadline::Timeouts timeouts { std::chrono::milliseconds(5000), std::chrono::milliseconds(5000), std::chrono::milliseconds(10000), std::chrono::milliseconds(0) };
+    };
+
+    struct Progress {
+        uint64_t totalSize = 0;
+        uint64_t downloadedBytes = 0;
+        size_t segmentsDone = 0;
+        size_t segmentsCount = 0;
+    };
+
+    explicit SegmentedDownloader(const std::string &url);
+    SegmentedDownloader(const std::string &url, const Settings &settings);
+
+    // skips size probing, eg. when known from manifest
+    void setTotalSize(uint64_t totalSize);
+    uint64_t totalSize(const Deadline &deadline = Deadline());
+
+    // segments are read from and written to cache, segment size becomes the cache chunk size
+    void setCache(ChunkCache* cache, const std::string &videoId, int itag);
+
+    // into memory, resized to total size
+    void downloadTo(std::vector<char>* buffer, const CancellationToken &token = CancellationToken());
+
+    // into a file, preallocated to total size; done segments are tracked in a "<path>.parts" sidecar file to resume across runs
+    void downloadTo(const std::string &filePath, const CancellationToken &token = CancellationToken());
+
+    Progress progress();
+    bool isComplete();
+
+ private:
+    using SegmentWriter = std::function<void(uint64_t offset, const std::string &data)>;
+
+    std::string _url;
+    Settings _settings;
+
+    std::mutex _mutex;
+    uint64_t _totalSize = 0;
+    std::vector<bool> _segmentsDone;
+    std::atomic<uint64_t> _downloadedBytes { 0 };
+
+    ChunkCache* _cache = nullptr;
+    std::string _videoId;
+    int _itag = 0;
+
+    ByteRange _rangeOf(size_t segmentIndex) const;
+    void _prepareSegments(const CancellationToken &token);
+    void _downloadSegments(const SegmentWriter &writer, const std::function<void(size_t)> &onSegmentDone, const CancellationToken &token);
+    std::string _downloadSegment(size_t segmentIndex, const CancellationToken &token);
+};
+
+}  // namespace AudioTube
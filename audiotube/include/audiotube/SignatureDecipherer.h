@@ -18,6 +18,7 @@
 #include "CipherOperation.h"
 #include "_DebugHelper.h"
 #include "ATHelper.h"
+#include "Singleflight.h"
 
 #include <queue>
 #include <utility>
@@ -25,6 +26,7 @@
 #include <set>
 #include <unordered_map>
 #include <string>
+#include <mutex>
 
 namespace AudioTube {
 
@@ -47,6 +49,8 @@ class SignatureDecipherer {
 
     YTDecipheringOperations _operations;
     static inline std::unordered_map<std::string, SignatureDecipherer*> _cache;
+    static inline std::mutex _cacheMutex;
+    static inline Singleflight<std::string, SignatureDecipherer*> _inflightCreations;
 
     static YTClientMethod _findObfuscatedDecipheringFunctionName(const std::string &ytPlayerSourceCode);
     static std::vector<std::string>
@@ -55,6 +59,10 @@ class SignatureDecipherer {
         _findObfuscatedDecipheringOperationsFunctionName(const std::string &ytPlayerSourceCode, const std::vector<std::string> &javascriptDecipheringOperations);
     static YTDecipheringOperations
         _buildOperations(const std::unordered_map<CipherOperation, YTClientMethod> &functionNamesByOperation, const std::vector<std::string> &javascriptOperations);
+
+    // position right after "<name><suffix>" where name is a whole identifier, npos if not found
+    static size_t _findDeclaration(const std::string &ytPlayerSourceCode, const std::string &name, const std::string &suffix);
+    static bool _isIdentifierChar(char c);
 };
 
 }  // namespace AudioTube
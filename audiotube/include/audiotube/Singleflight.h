@@ -0,0 +1,67 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <functional>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+
+#include "Deadline.h"
+
+namespace AudioTube {
+
+// Deduplicates identical concurrent works : while a work is in-flight for a key, other callers asking for the same key
+// wait for it and share its result (or exception) instead of running it again.
+template<typename Key, typename Result>
+class Singleflight {
+ public:
+    // followers stop waiting once their own deadline is over, throwing CancelledError or DeadlineExceededError
+    Result run(const Key &key, const std::function<Result()> &work, const Deadline &deadline = Deadline()) {
+        std::unique_lock<std::mutex> lock(this->_mutex);
+
+        // already in-flight, wait for it
+        if (auto found = this->_inflight.find(key); found != this->_inflight.end()) {
+            auto shared = found->second;
+            lock.unlock();
+            deadline.wait(shared, "Singleflight : Waiting for in-flight work");
+            return shared.get();
+        }
+
+        // lead
+        std::promise<Result> leader;
+        auto shared = leader.get_future().share();
+        this->_inflight.emplace(key, shared);
+        lock.unlock();
+
+        try {
+            leader.set_value(work());
+        } catch(...) {
+            leader.set_exception(std::current_exception());
+        }
+
+        lock.lock();
+        this->_inflight.erase(key);
+        lock.unlock();
+
+        return shared.get();
+    }
+
+ private:
+    std::mutex _mutex;
+    std::unordered_map<Key, std::shared_future<Result>> _inflight;
+};
+
+}  // namespace AudioTube
@@ -0,0 +1,87 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <algorithm>
+
+namespace AudioTube {
+
+// Lock-free ring buffer for exactly one producer thread and one consumer thread.
+// Neither side allocates nor blocks; each only writes its own index, the other one is read with acquire semantics.
+template<typename T>
+class SpscRingBuffer {
+ public:
+    explicit SpscRingBuffer(size_t capacity) : _capacity(capacity + 1), _buffer(new T[capacity + 1]) {}
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    size_t capacity() const {
+        return this->_capacity - 1;
+    }
+
+    // producer side
+    size_t writable() const {
+        auto write = this->_write.load(std::memory_order_relaxed);
+        auto read = this->_read.load(std::memory_order_acquire);
+        return (read + this->_capacity - write - 1) % this->_capacity;
+    }
+
+    size_t write(const T* items, size_t count) {
+        auto write = this->_write.load(std::memory_order_relaxed);
+        count = std::min(count, this->writable());
+
+        // at most 2 contiguous parts
+        auto firstPart = std::min(count, this->_capacity - write);
+        std::copy(items, items + firstPart, this->_buffer.get() + write);
+        std::copy(items + firstPart, items + count, this->_buffer.get());
+
+        this->_write.store((write + count) % this->_capacity, std::memory_order_release);
+        return count;
+    }
+
+    // consumer side
+    size_t readable() const {
+        auto read = this->_read.load(std::memory_order_relaxed);
+        auto write = this->_write.load(std::memory_order_acquire);
+        return (write + this->_capacity - read) % this->_capacity;
+    }
+
+    size_t read(T* items, size_t count) {
+        auto read = this->_read.load(std::memory_order_relaxed);
+        count = std::min(count, this->readable());
+
+        auto firstPart = std::min(count, this->_capacity - read);
+        std::copy(this->_buffer.get() + read, this->_buffer.get() + read + firstPart, items);
+        std::copy(this->_buffer.get(), this->_buffer.get() + (count - firstPart), items + firstPart);
+
+        this->_read.store((read + count) % this->_capacity, std::memory_order_release);
+        return count;
+    }
+
+ private:
+    // one slot is kept free to tell full from empty
+    const size_t _capacity;
+    std::unique_ptr<T[]> _buffer;
+
+    // on their own cache lines, to prevent false sharing between producer and consumer
+    alignas(64) std::atomic<size_t> _write { 0 };
+    alignas(64) std::atomic<size_t> _read { 0 };
+};
+
+}  // namespace AudioTube
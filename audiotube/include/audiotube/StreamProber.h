@@ -0,0 +1,79 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "_NetworkHelper.h"
+
+namespace AudioTube {
+
+// Checks that stream URLs answer, through "Range: bytes=0-0" GETs over kept-alive connections reused across probes
+class StreamProber : public NetworkHelper {
+ public:
+    struct Result {
+        bool available = false;
+        unsigned int statusCode = 0;
+        uint64_t totalSize = 0;
+        std::string url;  // last URL reached, after redirects
+    };
+
+    StreamProber();
+    explicit StreamProber(size_t maxIdlePerHost);
+    ~StreamProber();
+
+    // thread-safe; network failures are reported as unavailable
+    Result probe(const std::string &url, const Deadline &deadline = Deadline());
+
+    // probes all urls, at most concurrency at a time; results are in urls order
+    std::vector<Result> probeAll(const std::vector<std::string> &urls, unsigned int concurrency = 4,
+                                    const Deadline::Timeouts &timeouts = Deadline::Timeouts());
+
+    // idle connections kept, all hosts included
+    size_t idleConnections() const;
+
+ private:
+    struct _Connection {
+        asio::io_context ioContext;
+        std::unique_ptr<tcp::socket> socket;
+        std::unique_ptr<ssl::stream<tcp::socket>> sslStream;
+        bool reused = false;
+    };
+
+    // bodies longer than this are not drained, connection is closed instead
+    static constexpr uint64_t _maxDrainedBody = 64 * 1024;
+
+    size_t _maxIdlePerHost;
+    ssl::context _sslContext { ssl::context::sslv23 };
+
+    mutable std::mutex _mutex;
+    std::multimap<std::string, std::unique_ptr<_Connection>> _idle;
+
+    static std::string _poolKey(const UrlParser &url);
+    std::unique_ptr<_Connection> _acquire(const UrlParser &url, const Deadline &deadline);
+    void _release(const UrlParser &url, std::unique_ptr<_Connection> connection);
+
+    // single request over connection; reusable tells if the connection can serve another request
+    NetworkHelper::Response _request(_Connection* connection, const UrlParser &url, const Deadline &deadline, bool* reusable);
+
+    template<typename Stream>
+    NetworkHelper::Response _exchangeKeepAlive(_Connection* connection, Stream &stream, const UrlParser &url, const Deadline &deadline, bool* reusable);
+};
+
+}  // namespace AudioTube
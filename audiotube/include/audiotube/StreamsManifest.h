@@ -18,19 +18,22 @@
 #include <functional>
 #include <utility>
 #include <string>
+#include <string_view>
 #include <map>
 #include <unordered_map>
 #include <chrono>
 #include <ctime>
 #include <vector>
-
-#include <nlohmann/json.hpp>
+#include <optional>
+#include <cstdint>
 
 #include "ATHelper.h"
 #include "_NetworkHelper.h"
 #include "_DebugHelper.h"
 #include "SignatureDecipherer.h"
 #include "Regexes.h"
+#include "MpdParser.h"
+#include "PlayerResponse.h"
 
 namespace AudioTube {
 
@@ -50,34 +53,83 @@ class StreamsManifest : public NetworkHelper {
     using RawDASHManifest = std::string;
     using RawPlayerConfigStreams = std::string;
     using AudioStreamUrl = std::string;
-    using RawPlayerResponseStreams = nlohmann::json;
+    using PlayerResponseFormats = std::vector<AudioTube::PlayerResponse::Format>;
     using ITag = int;
 
-    using AudioStreamUrlByBitrate = std::map<double, std::pair<ITag, AudioStreamUrl>>;
-    using AudioStreamsPackage = std::map<AudioStreamsSource, AudioStreamUrlByBitrate>;
+    // everything known about a single audio stream; 0 or empty when not given by the source
+    struct StreamDescriptor {
+        ITag itag = 0;
+        AudioStreamUrl url;
+        std::string mime;
+        std::string codec;
+        unsigned int bitrate = 0;
+        uint64_t contentLength = 0;
+        uint64_t approxDurationMs = 0;
+        unsigned int audioSampleRate = 0;
+        // from the "expire" parameter of the signed url, -1 if none
+        std::time_t expiresAt = -1;
+        // initialization and index (Cues) byte ranges, for seeking
+        std::optional<NetworkHelper::ByteRange> initRange;
+        std::optional<NetworkHelper::ByteRange> indexRange;
+        // DASH SegmentList, initialization segment first; empty when the whole stream is at url
+        std::vector<std::string> segmentUrls;
+    };
+
+    // asc-ordered by bitrate
+    using StreamDescriptors = std::vector<StreamDescriptor>;
+    using AudioStreamsPackage = std::map<AudioStreamsSource, StreamDescriptors>;
+
+    // which stream to pick from the prefered source; bitrates in bits per second, 0 meaning no bound
+    struct SelectionPolicy {
+        unsigned int minBitrate = 0;
+        unsigned int maxBitrate = 0;
+        std::string codec;
+        bool highest = true;
+
+        static SelectionPolicy best();
+        static SelectionPolicy highestUpTo(unsigned int maxBitrate, const std::string &codec = std::string());
+        static SelectionPolicy smallestAtLeast(unsigned int minBitrate, const std::string &codec = std::string());
+    };
 
     StreamsManifest();
 
     // TODO(amphaal) add deciphering
     void feedRaw_DASH(const RawDASHManifest &raw, const SignatureDecipherer* decipherer);
+    // downloads and parses DASH manifest at once, as bytes come
+    promise::Promise promise_feedDASH(const std::string &dashManifestUrl, const SignatureDecipherer* decipherer, const Deadline &deadline);
     void feedRaw_PlayerConfig(const RawPlayerConfigStreams &raw, const SignatureDecipherer* decipherer);
-    void feedRaw_PlayerResponse(const RawPlayerResponseStreams &raw, const SignatureDecipherer* decipherer);
+    void feedRaw_PlayerResponse(const PlayerResponseFormats &formats, const SignatureDecipherer* decipherer);
+
+    void reset();
 
-    void setRequestedAt(const std::time_t &requestedAt);
+    // from now, for streams whose url does not tell when it expires
     void setSecondsUntilExpiration(const unsigned int secsUntilExp);
 
-    std::pair<StreamsManifest::AudioStreamsSource, AudioStreamUrlByBitrate> preferedStreamSource() const;
+    // segmented streams are never picked, consumers expect the whole stream at url
+    std::pair<StreamsManifest::AudioStreamsSource, const StreamDescriptors*> preferedStreamSource() const;
+    const StreamDescriptor* select(const SelectionPolicy &policy) const;
+    const StreamDescriptor& preferedStream() const;
     std::string preferedUrl() const;
+
+    // expiration of the prefered stream, which is the one played; -1 if unknown
     bool isExpired() const;
+    std::time_t validUntil() const;
+    std::time_t validUntil(const StreamDescriptor &stream) const;
 
  private:
-    std::time_t _requestedAt = -1;
-    std::time_t _validUntil = -1;
+    std::time_t _fallbackValidUntil = -1;
 
     AudioStreamsPackage _package;
 
+    void _store(AudioStreamsSource source, StreamDescriptors streams);
+    void _feedDASH(const MpdParser &parser, const SignatureDecipherer* decipherer);
+
+    static bool _isWholeStream(const StreamDescriptor &stream);
     static bool _isCodecAllowed(const std::string &codec);
     static bool _isMimeAllowed(const std::string &mime);
+    static uint64_t _numberFrom(const std::string_view &value);
+    static void _splitMimeType(const std::string &mimeType, std::string* mime, std::string* codec);
+    static std::time_t _expiryFrom(const std::string &url);
 
     static std::string _decipheredUrl(const SignatureDecipherer* decipherer, const std::string &cipheredUrl, std::string signature, std::string sigKey = std::string());
 };
@@ -0,0 +1,70 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <string>
+#include <stdexcept>
+#include <mutex>
+#include <chrono>
+#include <optional>
+#include <unordered_map>
+
+namespace AudioTube {
+
+// thrown when Youtube explicitly tells a video cannot be played, which is unlikely to change soon
+class UnavailableVideoError : public std::logic_error {
+ public:
+    enum Reason {
+        Unplayable,
+        LiveContent
+    };
+
+    UnavailableVideoError(const Reason &reason, const std::string &what);
+    Reason reason() const;
+
+ private:
+    Reason _reason;
+};
+
+// negative cache of unavailable videos, keyed by video id, with exponentially growing TTL
+class UnavailabilityCache {
+ public:
+    using VideoId = std::string;
+    using Clock = std::chrono::system_clock;
+
+    struct Entry {
+        UnavailableVideoError::Reason reason;
+        std::string message;
+        unsigned int failures = 0;
+        Clock::time_point retryAfter;
+    };
+
+    static void remember(const VideoId &videoId, const UnavailableVideoError &error);
+    static void forget(const VideoId &videoId);
+    static void clear();
+
+    // returns the cached failure if still considered unavailable
+    static std::optional<Entry> find(const VideoId &videoId);
+
+    static void setBackoff(const std::chrono::seconds &baseTTL, const std::chrono::seconds &maxTTL);
+
+ private:
+    static inline std::mutex _mutex;
+    static inline std::unordered_map<VideoId, Entry> _entries;
+    static inline std::chrono::seconds _baseTTL { 600 };
+    static inline std::chrono::seconds _maxTTL { 86400 };
+};
+
+}  // namespace AudioTube
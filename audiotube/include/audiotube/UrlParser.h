@@ -26,6 +26,8 @@ class UrlParser {
  public:
     explicit UrlParser(std::string_view rawUrlView);
     std::string host() const;
+    std::string hostName() const;  // host without port
+    std::string service() const;   // port if any, scheme otherwise
     std::string scheme() const;
     std::string pathAndQuery() const;
     bool isValid() const;
@@ -60,6 +62,29 @@ class UrlQuery {
     std::string_view _wholeQuery;
 };
 
+// Walks a "key=value&key=value" query in place, without copying; values are only decoded when asked to
+class QueryTokenizer {
+ public:
+    struct Field {
+        std::string_view key;
+        std::string_view value;
+
+        std::string decoded() const;
+    };
+
+    explicit QueryTokenizer(const std::string_view &query, char separator = '&');
+
+    // false once every field has been read
+    bool next(Field* field);
+
+    // form-encoded : percent sequences, and '+' as space
+    static std::string decode(const std::string_view &value);
+
+ private:
+    std::string_view _remaining;
+    char _separator;
+};
+
 // https://www.codeguru.com/cpp/cpp/algorithms/strings/article.php/c12759/URI-Encoding-and-Decoding.htm
 class Url {
  public:
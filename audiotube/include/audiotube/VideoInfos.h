@@ -23,16 +23,25 @@
 #include "PlayerConfig.h"
 #include "SignatureDecipherer.h"
 #include "StreamsManifest.h"
+#include "PlayerResponse.h"
 
 namespace AudioTube {
 
 class VideoInfos : public NetworkHelper {
  public:
-    static promise::Promise fillStreamsManifest(const PlayerConfig::VideoId &videoId, PlayerConfig* playerConfig, StreamsManifest* manifest);
+    static promise::Promise fillStreamsManifest(const PlayerConfig::VideoId &videoId, PlayerConfig* playerConfig, StreamsManifest* manifest, const Deadline &deadline = Deadline());
+
+    // only fetch fresh streaming data, reusing title, duration, STS and decipherer of an already resolved player config
+    static promise::Promise refreshStreamsManifest(const PlayerConfig::VideoId &videoId, const PlayerConfig* playerConfig, StreamsManifest* manifest, const Deadline &deadline = Deadline());
 
  private:
-    static promise::Promise _downloadRaw_VideoInfos(const PlayerConfig::VideoId &videoId, const std::string &sts);
-    static promise::Promise _fillFrom_VideoInfos(const DownloadedUtf8 &dl, StreamsManifest* manifest, PlayerConfig *playerConfig);
+    static promise::Promise _downloadRaw_VideoInfos(const PlayerConfig::VideoId &videoId, const std::string &sts, const Deadline &deadline);
+    static promise::Promise _fillFrom_VideoInfos(const DownloadedUtf8 &dl, StreamsManifest* manifest, PlayerConfig *playerConfig, const Deadline &deadline);
+    static promise::Promise _fillStreamsFrom_VideoInfos(const DownloadedUtf8 &dl, StreamsManifest* manifest, const SignatureDecipherer* decipherer, const Deadline &deadline);
+
+    static PlayerResponse _playablePlayerResponse(const UrlQuery &videoInfos);
+    static std::string _fillFrom_StreamingData(const UrlQuery &videoInfos, const PlayerResponse &playerResponse, StreamsManifest* manifest, const SignatureDecipherer* decipherer);
+    static promise::Promise _mayFetchRaw_DASH(const std::string &dashManifestUrl, StreamsManifest* manifest, const SignatureDecipherer* decipherer, const Deadline &deadline);
 
     static std::string _percentEncodeUrl(const std::string &rawUrl);
     static std::string _percentDecodeUrl(const std::string &encodedUrl);
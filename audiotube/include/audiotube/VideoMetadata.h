@@ -13,10 +13,13 @@
 // GNU General Public License for more details.
 #pragma once
 
+#include <memory>
 #include <string>
 
 #include "PlayerConfig.h"
 #include "StreamsManifest.h"
+#include "Deadline.h"
+#include "PrefetchBuffer.h"
 
 namespace AudioTube {
 
@@ -41,9 +44,16 @@ class VideoMetadata {
 
     void setPlayerConfig(const PlayerConfig &playerConfig);
 
+    // aborts any pending refresh of this metadata, eg. when skipped by the user
+    void cancelPendingRefresh();
+    CancellationToken cancellationToken() const;
+
     StreamsManifest* audioStreams();
     PlayerConfig* playerConfig();
 
+    // beginning of the prefered stream, if prefetching is enabled on NetworkFetcher; shared between copies
+    PrefetchBuffer* prefetch();
+
     // callbacks
     void setOnMetadataFetching(const std::function<void()> &cb);
     void setOnMetadataRefreshed(const std::function<void()> &cb);
@@ -62,6 +72,8 @@ class VideoMetadata {
 
     PlayerConfig _playerConfig;
     StreamsManifest _audioStreams;
+    CancellationSource _cancellation;
+    std::shared_ptr<PrefetchBuffer> _prefetch = std::make_shared<PrefetchBuffer>();
 
     std::function<void()> _omf_callback;
     std::function<void()> _omr_callback;
@@ -0,0 +1,122 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <optional>
+
+#include "EbmlReader.h"
+
+namespace AudioTube {
+
+// Incremental WebM (Matroska subset) demuxer : feed it bytes as they are downloaded, it emits the frames of the Opus track.
+// Emitted packets point into the fed buffer, and are only valid during the callback. Bytes are only copied when
+// an element straddles two fed chunks.
+class WebmDemuxer {
+ public:
+    struct Track {
+        uint64_t number = 0;
+        uint64_t type = 0;                // 2 for audio
+        std::string codecId;              // "A_OPUS"
+        std::string codecPrivate;         // OpusHead
+        double samplingFrequency = 0;
+        uint64_t channels = 0;
+        uint64_t codecDelayNs = 0;
+        uint64_t seekPreRollNs = 0;
+    };
+
+    struct Packet {
+        std::string_view data;
+        uint64_t track = 0;
+        int64_t timestampNs = 0;
+        bool keyframe = false;
+    };
+
+    using PacketCallback = std::function<void(const Packet &packet)>;
+
+    explicit WebmDemuxer(const PacketCallback &onPacket);
+
+    // throws std::runtime_error on malformed input
+    void feed(const char* data, size_t size);
+
+    const std::vector<Track>& tracks() const;
+    const Track* opusTrack() const;
+    uint64_t timecodeScale() const;
+    std::optional<double> durationSeconds() const;
+
+    // absolute position in fed stream
+    uint64_t position() const;
+
+    // next fed bytes start at that absolute position, on an element boundary (eg. a Cluster found by WebmSeekIndex); tracks are kept
+    void seek(uint64_t position);
+
+    // duration of an Opus packet from its TOC byte (RFC 6716 3.1), 0 if malformed
+    static int64_t opusPacketDurationNs(std::string_view packet);
+
+ private:
+    // Careful, ids include their length marker bits
+    enum _ElementId : uint32_t {
+        EBML = 0x1A45DFA3,
+        Segment = 0x18538067,
+        Info = 0x1549A966,
+        TimecodeScale = 0x2AD7B1,
+        Duration = 0x4489,
+        Tracks = 0x1654AE6B,
+        TrackEntry = 0xAE,
+        TrackNumber = 0xD7,
+        TrackType = 0x83,
+        CodecID = 0x86,
+        CodecPrivate = 0x63A2,
+        CodecDelay = 0x56AA,
+        SeekPreRoll = 0x56BB,
+        Audio = 0xE1,
+        SamplingFrequency = 0xB5,
+        Channels = 0x9F,
+        Cluster = 0x1F43B675,
+        Timecode = 0xE7,
+        SimpleBlock = 0xA3,
+        BlockGroup = 0xA0,
+        Block = 0xA1
+    };
+
+    static constexpr uint64_t _maxLeafSize = 16 * 1024 * 1024;
+
+    PacketCallback _onPacket;
+
+    std::vector<Track> _tracks;
+    uint64_t _timecodeScale = 1000000;
+    std::optional<double> _duration;
+    uint64_t _clusterTimecode = 0;
+
+    uint64_t _position = 0;
+    uint64_t _skip = 0;
+    std::string _carry;     // element straddling fed chunks
+    uint64_t _carryNeed = 0;  // total length of carried element, 0 while its header is incomplete
+    std::vector<size_t> _laceSizes;
+
+    static bool _isMaster(uint32_t id);
+    static bool _isHandledLeaf(uint32_t id);
+
+    // handles an element whose header is known; returns false if its body must be fed whole to _onLeaf
+    bool _onHeader(const EbmlReader::Header &header);
+    void _onLeaf(uint32_t id, std::string_view body);
+    void _onBlock(std::string_view body, bool isSimpleBlock);
+};
+
+}  // namespace AudioTube
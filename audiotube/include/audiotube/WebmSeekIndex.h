@@ -0,0 +1,71 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+#include "_NetworkHelper.h"
+#include "EbmlReader.h"
+
+namespace AudioTube {
+
+// Time to byte index of a WebM stream, built from its Cues element
+class WebmSeekIndex : public NetworkHelper {
+ public:
+    struct SeekPoint {
+        double seconds = 0;         // cluster start, packets before requested time are to be dropped by consumer
+        uint64_t byteOffset = 0;    // absolute, of the cluster
+    };
+
+    // fetches init and index ranges (in a single request if they are close enough), then parses them
+    static WebmSeekIndex fetch(const std::string &url, const ByteRange &initRange, const ByteRange &indexRange, const Deadline &deadline = Deadline());
+
+    // init is the beginning of the stream (EBML header up to Tracks), cues the whole Cues element
+    static WebmSeekIndex parse(std::string_view init, std::string_view cues);
+
+    // cluster containing time, or first one if before
+    SeekPoint seekPointFor(double seconds) const;
+    uint64_t byteOffsetFor(double seconds) const;
+
+    const std::vector<SeekPoint>& seekPoints() const;
+    uint64_t segmentDataStart() const;
+
+ private:
+    enum _ElementId : uint32_t {
+        EBML = 0x1A45DFA3,
+        Segment = 0x18538067,
+        Info = 0x1549A966,
+        TimecodeScale = 0x2AD7B1,
+        Cues = 0x1C53BB6B,
+        CuePoint = 0xBB,
+        CueTime = 0xB3,
+        CueTrackPositions = 0xB7,
+        CueClusterPosition = 0xF1
+    };
+
+    static constexpr uint64_t _maxRangesGap = 64 * 1024;
+
+    uint64_t _segmentDataStart = 0;
+    uint64_t _timecodeScale = 1000000;
+    std::vector<SeekPoint> _seekPoints;
+
+    void _parseInit(std::string_view init);
+    void _parseCues(std::string_view cues);
+};
+
+}  // namespace AudioTube
@@ -20,7 +20,13 @@
 #endif
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <cstdint>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
 
 #define PROMISE_HEADER_ONLY 1
 #define PROMISE_HEADONLY 1
@@ -33,6 +39,10 @@
 #include <asio/ssl/rfc2818_verification.hpp>
 
 #include "UrlParser.h"
+#include "ATHelper.h"
+#include "Singleflight.h"
+#include "RateLimiter.h"
+#include "Deadline.h"
 
 using asio::ip::tcp;
 namespace ssl = asio::ssl;
@@ -48,10 +58,96 @@ class NetworkHelper {
         unsigned int statusCode = 0;
         std::string redirectUrl;
     };
+    // inclusive
+    struct ByteRange {
+        uint64_t first = 0;
+        uint64_t last = 0;
+    };
     using DownloadedUtf8 = std::string;
-    static promise::Promise promise_dl_HTTPS(const std::string &downloadUrl, bool head = false);
-    static NetworkHelper::Response downloadHTTPS(const std::string &downloadUrl, bool head = false);
+    static promise::Promise promise_dl_HTTPS(const std::string &downloadUrl, bool head = false, const Deadline &deadline = Deadline());
+    static NetworkHelper::Response downloadHTTPS(const std::string &downloadUrl, bool head = false, const Deadline &deadline = Deadline(),
+                                                    const std::vector<std::string> &extraHeaders = std::vector<std::string>());
+
+    // GET a byte range, following redirects; redirectUrl of the response is the last URL reached, if any
+    static NetworkHelper::Response downloadRange(const std::string &downloadUrl, const ByteRange &range, const Deadline &deadline = Deadline());
+
+    // first value of a header, case insensitive, empty if missing
+    static std::string headerValue(const NetworkHelper::Response &response, const std::string_view &headerName);
+
+    // total size from "Content-Range: bytes <first>-<last>/<total>", 0 if unknown
+    static uint64_t contentRangeTotal(const NetworkHelper::Response &response);
+
+    // "<first>-<last>", as found in manifests
+    static std::optional<ByteRange> byteRangeFrom(const std::string_view &range);
     static constexpr std::string_view LocationTag = "Location: ";
+    static constexpr unsigned int MaxRedirects = 5;
+
+    // shared by every download, per host
+    static RateLimiter& rateLimiter();
+
+ protected:
+    static inline RateLimiter _rateLimiter;
+
+    static constexpr auto _cancellationPollInterval = std::chrono::milliseconds(50);
+
+    // completion state of an async operation, awaited through _await()
+    struct _PendingOp {
+        bool done = false;
+        asio::error_code ec;
+
+        auto handler() {
+            return [this](const asio::error_code &ec, auto&&...) {
+                this->done = true;
+                this->ec = ec;
+            };
+        }
+    };
+
+    // runs I/O until operation completes; if deadline, limit or cancellation comes first, aborts it and throws
+    static void _await(asio::io_context &ioContext, _PendingOp* op, const Deadline::Clock::time_point &limit,
+                        const Deadline &deadline, const std::string &what, const std::function<void()> &abort);
+
+    // closing the socket aborts any pending operation on it
+    template<typename Stream>
+    static std::function<void()> _closer(Stream &stream) {
+        return [&stream]() {
+            asio::error_code ignored;
+            stream.lowest_layer().close(ignored);
+        };
+    }
+
+    // resolves and connects to the host of url
+    static tcp::socket _connect(asio::io_context &io_context, const UrlParser &url, const Deadline &deadline);
+    static void _handshake(asio::io_context &io_context, ssl::stream<tcp::socket> &ssl_sock, const std::string &serverName, const Deadline &deadline);
+
+    // RFC 8305 "Happy Eyeballs" : races connections to resolved endpoints, alternating address families with staggered starts
+    static constexpr auto _connectionAttemptDelay = std::chrono::milliseconds(250);
+    static std::vector<tcp::endpoint> _connectionOrder(const std::vector<tcp::endpoint> &resolved);
+    static tcp::socket _raceConnect(asio::io_context &ioContext, const std::vector<tcp::endpoint> &resolved,
+                                    const Deadline::Clock::time_point &limit, const Deadline &deadline, const std::string &serverName);
+
+    // request / response head over an established (TLS or plain) stream; body bytes already received are left in response buffer
+    // keepAlive asks for a persistent HTTP/1.1 connection instead of closing it after response
+    template<typename Stream>
+    static void _sendRequest(asio::io_context &io_context, Stream &stream, const UrlParser &url,
+                                bool head, const Deadline &deadline, const std::vector<std::string> &extraHeaders, bool keepAlive = false);
+    template<typename Stream>
+    static NetworkHelper::Response _readHead(asio::io_context &io_context, Stream &stream, asio::streambuf &response,
+                                                const std::string &serverName, const Deadline &deadline);
+
+    // 429 / 503, and how long upstream asked to wait before retrying, 0 if not said
+    static bool _isThrottled(const NetworkHelper::Response &response);
+    static std::chrono::milliseconds _retryAfter(const NetworkHelper::Response &response);
+
+ private:
+    static inline Singleflight<std::string, NetworkHelper::Response> _inflightDownloads;
+
+    static NetworkHelper::Response _downloadHTTPS_once(const std::string &downloadUrl, bool head, const Deadline &deadline, const std::vector<std::string> &extraHeaders);
+
+    // sends request and reads whole response
+    template<typename Stream>
+    static NetworkHelper::Response _exchange(asio::io_context &io_context, Stream &stream, const UrlParser &url,
+                                                bool head, const Deadline &deadline, const std::vector<std::string> &extraHeaders);
 };
 
 }  // namespace AudioTube
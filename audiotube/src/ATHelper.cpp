@@ -31,3 +31,11 @@ std::vector<std::string> AudioTube::splitString(const std::string &s, char delim
 
     return result;
 }
+
+std::string AudioTube::trimmed(const std::string &s) {
+    auto whitespaces = " \t\r\n";
+    auto first = s.find_first_not_of(whitespaces);
+    if (first == std::string::npos) return std::string();
+    auto last = s.find_last_not_of(whitespaces);
+    return s.substr(first, last - first + 1);
+}
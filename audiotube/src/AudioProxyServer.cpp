@@ -0,0 +1,379 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <sstream>
+
+#include "AudioProxyServer.h"
+#include "NetworkFetcher.h"
+
+AudioTube::AudioProxyServer::AudioProxyServer() : AudioProxyServer(Settings()) {}
+
+AudioTube::AudioProxyServer::AudioProxyServer(const Settings &settings) :
+    _settings(settings),
+    _acceptor(_ioContext, tcp::endpoint(asio::ip::address_v4::loopback(), settings.port)) {
+    this->_acceptThread = std::thread(&AudioProxyServer::_acceptLoop, this);
+    spdlog::debug("AudioProxyServer : Listening on port {}", this->port());
+}
+
+AudioTube::AudioProxyServer::~AudioProxyServer() {
+    this->_running = false;
+
+    // wake up accept, acceptor is only closed once its thread is done with it
+    asio::error_code ignored;
+    {
+        asio::io_context ioContext;
+        tcp::socket waker(ioContext);
+        waker.connect(this->_acceptor.local_endpoint(), ignored);
+        if (this->_acceptThread.joinable()) this->_acceptThread.join();
+    }
+    this->_acceptor.close(ignored);
+
+    // interrupt clients, waking up blocked reads and writes; sockets are only closed once their thread is done with them
+    std::lock_guard<std::mutex> lock(this->_sessionsMutex);
+    for (auto &session : this->_sessions) {
+        session.socket->shutdown(tcp::socket::shutdown_both, ignored);
+    }
+    for (auto &session : this->_sessions) {
+        if (session.thread.joinable()) session.thread.join();
+    }
+}
+
+unsigned short AudioTube::AudioProxyServer::port() const {
+    return this->_acceptor.local_endpoint().port();
+}
+
+std::string AudioTube::AudioProxyServer::urlOf(const std::string &videoId) const {
+    return "http://127.0.0.1:" + std::to_string(this->port()) + "/" + videoId;
+}
+
+void AudioTube::AudioProxyServer::_acceptLoop() {
+    while (this->_running) {
+        auto socket = std::make_shared<tcp::socket>(this->_ioContext);
+
+        asio::error_code ec;
+        this->_acceptor.accept(*socket, ec);
+        if (!this->_running) return;
+        if (ec) continue;
+
+        this->_joinFinishedSessions();
+
+        // one thread per client, most of its time is spent waiting for upstream or client
+        auto done = std::make_shared<std::atomic<bool>>(false);
+        std::lock_guard<std::mutex> lock(this->_sessionsMutex);
+        this->_sessions.push_back({
+            socket,
+            std::thread([this, socket, done]() {
+                this->_serve(socket);
+                *done = true;
+            }),
+            done
+        });
+    }
+}
+
+void AudioTube::AudioProxyServer::_joinFinishedSessions() {
+    std::lock_guard<std::mutex> lock(this->_sessionsMutex);
+
+    for (auto it = this->_sessions.begin(); it != this->_sessions.end();) {
+        if (!*it->done) {
+            it++;
+            continue;
+        }
+
+        it->thread.join();
+        it = this->_sessions.erase(it);
+    }
+}
+
+uint64_t AudioTube::AudioProxyServer::_chunkSize() const {
+    return this->_settings.cache ? this->_settings.cache->chunkSize() : this->_settings.chunkSize;
+}
+
+std::optional<AudioTube::NetworkHelper::ByteRange> AudioTube::AudioProxyServer::parseRange(const std::string &rangeHeader, uint64_t totalSize) {
+    static constexpr std::string_view unit = "bytes=";
+
+    auto value = trimmed(rangeHeader);
+    if (!totalSize || value.compare(0, unit.size(), unit) != 0) return std::nullopt;
+
+    // multiple ranges are not supported
+    auto spec = value.substr(unit.size());
+    auto dash = spec.find('-');
+    if (dash == std::string::npos || spec.find(',') != std::string::npos) return std::nullopt;
+
+    auto toNumber = [](const std::string &str, uint64_t* out) {
+        if (str.empty()) return false;
+        auto result = std::from_chars(str.data(), str.data() + str.size(), *out);
+        return result.ec == std::errc() && result.ptr == str.data() + str.size();
+    };
+
+    auto firstStr = spec.substr(0, dash);
+    auto lastStr = spec.substr(dash + 1);
+    ByteRange range;
+
+    // last N bytes
+    if (firstStr.empty()) {
+        uint64_t suffixLength = 0;
+        if (!toNumber(lastStr, &suffixLength) || !suffixLength) return std::nullopt;
+        range.first = totalSize - std::min(suffixLength, totalSize);
+        range.last = totalSize - 1;
+        return range;
+    }
+
+    if (!toNumber(firstStr, &range.first) || range.first >= totalSize) return std::nullopt;
+
+    // open-ended
+    if (lastStr.empty()) {
+        range.last = totalSize - 1;
+        return range;
+    }
+
+    if (!toNumber(lastStr, &range.last) || range.last < range.first) return std::nullopt;
+    range.last = std::min(range.last, totalSize - 1);
+    return range;
+}
+
+void AudioTube::AudioProxyServer::_replyError(tcp::socket &socket, unsigned int statusCode, const std::string &reason) {
+    auto head = "HTTP/1.1 " + std::to_string(statusCode) + " " + reason + "\r\n"
+              + "Content-Length: 0\r\n"
+              + "Connection: close\r\n\r\n";
+
+    asio::error_code ignored;
+    asio::write(socket, asio::buffer(head), ignored);
+}
+
+void AudioTube::AudioProxyServer::_serve(std::shared_ptr<tcp::socket> socket) {
+    asio::error_code ec;
+    asio::streambuf request;
+    asio::read_until(*socket, request, "\r\n\r\n", ec);
+    if (ec) return;
+
+    // request line
+    std::istream request_stream(&request);
+    std::string method, target, line;
+    request_stream >> method >> target;
+    std::getline(request_stream, line);
+
+    // headers, only Range matters
+    std::string rangeHeader;
+    static constexpr std::string_view rangeTag = "range:";
+    while (std::getline(request_stream, line) && line != "\r") {
+        if (line.size() < rangeTag.size()) continue;
+
+        std::string name = line.substr(0, rangeTag.size());
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        if (name == rangeTag) rangeHeader = trimmed(line.substr(rangeTag.size()));
+    }
+
+    auto head = method == "HEAD";
+    if (!head && method != "GET") return _replyError(*socket, 405, "Method Not Allowed");
+
+    // "/<videoId>", query ignored
+    if (target.empty() || target[0] != '/') return _replyError(*socket, 404, "Not Found");
+    auto videoId = target.substr(1, target.find('?') - 1);
+    auto isIdChar = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_'; };
+    if (videoId.empty() || !std::all_of(videoId.begin(), videoId.end(), isIdChar)) return _replyError(*socket, 404, "Not Found");
+
+    std::shared_ptr<_Upstream> upstream;
+    uint64_t totalSize = 0;
+    std::string contentType;
+    try {
+        upstream = this->_resolve(videoId, false);
+        std::lock_guard<std::mutex> lock(upstream->mutex);
+        totalSize = upstream->totalSize;
+        contentType = upstream->contentType;
+    } catch(const std::exception &e) {
+        spdlog::warn("AudioProxyServer : {}", e.what());
+        return _replyError(*socket, 502, "Bad Gateway");
+    }
+
+    // whole stream if no range asked
+    ByteRange range { 0, totalSize - 1 };
+    if (!rangeHeader.empty()) {
+        auto asked = parseRange(rangeHeader, totalSize);
+        if (!asked) {
+            auto reply = "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Range: bytes */" + std::to_string(totalSize) + "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+            asio::write(*socket, asio::buffer(reply), ec);
+            return;
+        }
+        range = *asked;
+    }
+
+    std::ostringstream reply;
+    reply << (rangeHeader.empty() ? "HTTP/1.1 200 OK" : "HTTP/1.1 206 Partial Content") << "\r\n";
+    reply << "Content-Type: " << contentType << "\r\n";
+    reply << "Content-Length: " << (range.last - range.first + 1) << "\r\n";
+    reply << "Accept-Ranges: bytes\r\n";
+    if (!rangeHeader.empty()) reply << "Content-Range: bytes " << range.first << "-" << range.last << "/" << totalSize << "\r\n";
+    reply << "Connection: close\r\n\r\n";
+
+    asio::write(*socket, asio::buffer(reply.str()), ec);
+    if (ec || head) return;
+
+    // stream chunks covering range
+    auto chunkSize = this->_chunkSize();
+    for (auto chunkIndex = range.first / chunkSize; chunkIndex <= range.last / chunkSize; chunkIndex++) {
+        auto chunkStart = chunkIndex * chunkSize;
+        auto from = std::max(range.first, chunkStart) - chunkStart;
+
+        // straight from cache mapping
+        if (this->_settings.cache) {
+            int itag;
+            {
+                std::lock_guard<std::mutex> lock(upstream->mutex);
+                itag = upstream->itag;
+            }
+
+            if (auto cached = this->_settings.cache->get({ videoId, itag, chunkIndex })) {
+                auto to = std::min(range.last + 1, chunkStart + cached->size()) - chunkStart;
+                asio::write(*socket, asio::buffer(cached->data() + from, to - from), ec);
+                if (ec) return;
+                continue;
+            }
+        }
+
+        std::string chunk;
+        try {
+            chunk = this->_chunk(videoId, upstream, chunkIndex);
+        } catch(const std::exception &e) {
+            // too late to change status, client sees a truncated body
+            spdlog::warn("AudioProxyServer : {}", e.what());
+            return;
+        }
+
+        auto to = std::min(range.last + 1, chunkStart + chunk.size()) - chunkStart;
+        asio::write(*socket, asio::buffer(chunk.data() + from, to - from), ec);
+        if (ec) return;
+    }
+
+    socket->shutdown(tcp::socket::shutdown_both, ec);
+}
+
+std::shared_ptr<AudioTube::AudioProxyServer::_Upstream> AudioTube::AudioProxyServer::_resolve(const std::string &videoId, bool forceRefresh) {
+    std::shared_ptr<_Upstream> upstream;
+    {
+        std::lock_guard<std::mutex> lock(this->_upstreamsMutex);
+        auto &found = this->_upstreams[videoId];
+        if (!found.upstream) found.upstream = std::make_shared<_Upstream>();
+        found.lastUsed = std::chrono::steady_clock::now();
+        upstream = found.upstream;
+
+        this->_evictUpstreams();
+    }
+
+    std::lock_guard<std::mutex> lock(upstream->mutex);
+    auto isExpired = upstream->metadata && upstream->metadata->audioStreams()->isExpired();
+    if (!forceRefresh && upstream->totalSize && !isExpired) return upstream;
+
+    auto source = this->_locate(videoId, *upstream, forceRefresh);
+
+    // probe size, and skip redirects for next requests
+    auto probe = downloadRange(source.url, { 0, 0 }, Deadline(this->_settings.timeouts));
+    auto totalSize = contentRangeTotal(probe);
+    if (probe.statusCode != 206 || !totalSize) {
+        throw std::runtime_error("AudioProxyServer : Cannot determine size of [" + videoId + "] stream");
+    }
+
+    auto contentType = headerValue(probe, "Content-Type");
+
+    upstream->url = probe.redirectUrl.empty() ? source.url : probe.redirectUrl;
+    upstream->itag = source.itag;
+    upstream->totalSize = totalSize;
+    upstream->contentType = contentType.empty() ? "application/octet-stream" : contentType;
+
+    spdlog::debug("AudioProxyServer : [{}] resolved, itag {}, {} bytes", videoId, upstream->itag, totalSize);
+
+    return upstream;
+}
+
+void AudioTube::AudioProxyServer::_evictUpstreams() {
+    while (this->_upstreams.size() > this->_settings.maxUpstreams) {
+        // least recently used, not being served
+        auto oldest = this->_upstreams.end();
+        for (auto it = this->_upstreams.begin(); it != this->_upstreams.end(); it++) {
+            if (it->second.upstream.use_count() > 1) continue;
+            if (oldest == this->_upstreams.end() || it->second.lastUsed < oldest->second.lastUsed) oldest = it;
+        }
+
+        if (oldest == this->_upstreams.end()) return;
+        spdlog::debug("AudioProxyServer : Forgetting [{}]", oldest->first);
+        this->_upstreams.erase(oldest);
+    }
+}
+
+AudioTube::AudioProxyServer::_Source AudioTube::AudioProxyServer::_locate(const std::string &videoId, _Upstream &upstream, bool forceRefresh) {
+    if (!upstream.metadata) upstream.metadata.reset(VideoMetadata::fromVideoId(videoId));
+    auto metadata = upstream.metadata.get();
+
+    // settled on return, even when following an in-flight refresh of the same video
+    NetworkFetcher::refreshMetadata(metadata, forceRefresh, this->_settings.timeouts);
+    if (!metadata->ranOnce() || metadata->hasFailed()) {
+        throw std::runtime_error("AudioProxyServer : Cannot resolve [" + videoId + "]");
+    }
+
+    auto best = metadata->audioStreams()->preferedStream();
+    return { best.url, best.itag };
+}
+
+std::string AudioTube::AudioProxyServer::_chunk(const std::string &videoId, std::shared_ptr<_Upstream> upstream, uint64_t chunkIndex) {
+    int itag;
+    {
+        std::lock_guard<std::mutex> lock(upstream->mutex);
+        itag = upstream->itag;
+    }
+
+    // clients asking for the same chunk at the same time share the upstream request
+    auto key = videoId + "/" + std::to_string(itag) + "/" + std::to_string(chunkIndex);
+    return this->_inflightChunks.run(key, [=]() {
+        return this->_fetchChunk(videoId, upstream, chunkIndex);
+    });
+}
+
+std::string AudioTube::AudioProxyServer::_fetchChunk(const std::string &videoId, std::shared_ptr<_Upstream> upstream, uint64_t chunkIndex) {
+    for (unsigned int attempt = 0;; attempt++) {
+        std::string url;
+        int itag;
+        ByteRange range;
+        {
+            std::lock_guard<std::mutex> lock(upstream->mutex);
+            url = upstream->url;
+            itag = upstream->itag;
+            range.first = chunkIndex * this->_chunkSize();
+            range.last = std::min(range.first + this->_chunkSize(), upstream->totalSize) - 1;
+        }
+
+        auto response = downloadRange(url, range, Deadline(this->_settings.timeouts));
+
+        if (response.statusCode == 206 && response.messageBody.size() == range.last - range.first + 1) {
+            if (this->_settings.cache) {
+                this->_settings.cache->put({ videoId, itag, chunkIndex }, response.messageBody.data(), response.messageBody.size());
+            }
+            return response.messageBody;
+        }
+
+        // URL expired or revoked, resolve again once
+        auto isStale = response.statusCode == 403 || response.statusCode == 404 || response.statusCode == 410;
+        if (attempt == 0 && isStale) {
+            spdlog::debug("AudioProxyServer : Upstream URL of [{}] is stale ({}), resolving again...", videoId, response.statusCode);
+            this->_resolve(videoId, true);
+            continue;
+        }
+
+        throw std::runtime_error("AudioProxyServer : Cannot fetch chunk " + std::to_string(chunkIndex) + " of [" + videoId + "], status " + std::to_string(response.statusCode));
+    }
+}
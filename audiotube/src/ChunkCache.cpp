@@ -0,0 +1,299 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include "ChunkCache.h"
+
+AudioTube::ChunkCache::View::View(ChunkCache* cache, const std::string &key, std::shared_ptr<MappedFile> segment, const char* data, size_t size) :
+    _cache(cache), _key(key), _segment(segment), _data(data), _size(size) {}
+
+AudioTube::ChunkCache::View::View(View &&other) noexcept :
+    _cache(other._cache), _key(std::move(other._key)), _segment(std::move(other._segment)), _data(other._data), _size(other._size) {
+    other._cache = nullptr;
+}
+
+AudioTube::ChunkCache::View& AudioTube::ChunkCache::View::operator=(View &&other) noexcept {
+    if (this == &other) return *this;
+    if (this->_cache) this->_cache->_unpin(this->_key);
+
+    this->_cache = other._cache;
+    this->_key = std::move(other._key);
+    this->_segment = std::move(other._segment);
+    this->_data = other._data;
+    this->_size = other._size;
+    other._cache = nullptr;
+
+    return *this;
+}
+
+AudioTube::ChunkCache::View::~View() {
+    if (this->_cache) this->_cache->_unpin(this->_key);
+}
+
+const char* AudioTube::ChunkCache::View::data() const {
+    return this->_data;
+}
+
+size_t AudioTube::ChunkCache::View::size() const {
+    return this->_size;
+}
+
+AudioTube::ChunkCache::ChunkCache(const Settings &settings) : _settings(settings) {
+    if (!this->_settings.chunkSize || !this->_settings.chunksPerSegment) throw std::logic_error("ChunkCache : Chunk size and chunks per segment must not be 0");
+
+    std::filesystem::create_directories(this->_settings.directory);
+
+    this->_capacity = static_cast<uint32_t>(this->_settings.diskBudget / this->_settings.chunkSize);
+    this->_stats.capacity = this->_capacity;
+
+    this->_loadIndex();
+
+    std::vector<bool> used(this->_capacity, false);
+    for (const auto &[key, entry] : this->_entries) used[entry.slot] = true;
+
+    // free slots, last ones first so that lowest are taken first
+    for (auto slot = this->_capacity; slot-- > 0;) {
+        if (!used[slot]) this->_freeSlots.push_back(slot);
+    }
+}
+
+AudioTube::ChunkCache::~ChunkCache() {
+    this->flush();
+}
+
+uint64_t AudioTube::ChunkCache::chunkSize() const {
+    return this->_settings.chunkSize;
+}
+
+std::string AudioTube::ChunkCache::_keyOf(const Key &key) {
+    return key.videoId + "/" + std::to_string(key.itag) + "/" + std::to_string(key.chunkIndex);
+}
+
+std::string AudioTube::ChunkCache::_indexPath() const {
+    return (std::filesystem::path(this->_settings.directory) / "index").string();
+}
+
+std::shared_ptr<AudioTube::MappedFile> AudioTube::ChunkCache::_segmentOf(uint32_t slot) {
+    auto segmentIndex = slot / this->_settings.chunksPerSegment;
+    if (segmentIndex >= this->_segments.size()) this->_segments.resize(segmentIndex + 1);
+
+    // mapped lazily
+    auto &segment = this->_segments[segmentIndex];
+    if (!segment) {
+        auto path = (std::filesystem::path(this->_settings.directory) / ("segment_" + std::to_string(segmentIndex))).string();
+        segment = std::make_shared<MappedFile>(path, this->_settings.chunkSize * this->_settings.chunksPerSegment);
+    }
+
+    return segment;
+}
+
+char* AudioTube::ChunkCache::_slotData(uint32_t slot) {
+    return this->_segmentOf(slot)->data() + (slot % this->_settings.chunksPerSegment) * this->_settings.chunkSize;
+}
+
+std::optional<uint32_t> AudioTube::ChunkCache::_takeSlot() {
+    if (!this->_freeSlots.empty()) {
+        auto slot = this->_freeSlots.back();
+        this->_freeSlots.pop_back();
+        return slot;
+    }
+
+    // evict least recently used, unless in use
+    for (auto it = this->_lru.rbegin(); it != this->_lru.rend(); it++) {
+        auto found = this->_entries.find(*it);
+        if (found->second.pins) continue;
+
+        // persisted index must not outlive the chunk it references
+        if (!this->_removeIndex()) return std::nullopt;
+
+        auto slot = found->second.slot;
+        this->_lru.erase(std::next(it).base());
+        this->_entries.erase(found);
+        this->_stats.evictions++;
+
+        return slot;
+    }
+
+    return std::nullopt;
+}
+
+std::optional<AudioTube::ChunkCache::View> AudioTube::ChunkCache::get(const Key &key) {
+    auto keyStr = _keyOf(key);
+    std::lock_guard<std::mutex> lock(this->_mutex);
+
+    auto found = this->_entries.find(keyStr);
+    if (found == this->_entries.end() || !found->second.ready) {
+        this->_stats.misses++;
+        return std::nullopt;
+    }
+
+    // most recent
+    auto &entry = found->second;
+    this->_lru.splice(this->_lru.begin(), this->_lru, entry.lru);
+    entry.pins++;
+    this->_stats.hits++;
+
+    return View(this, keyStr, this->_segmentOf(entry.slot), this->_slotData(entry.slot), entry.size);
+}
+
+bool AudioTube::ChunkCache::contains(const Key &key) {
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    auto found = this->_entries.find(_keyOf(key));
+    return found != this->_entries.end() && found->second.ready;
+}
+
+bool AudioTube::ChunkCache::put(const Key &key, const char* data, size_t size) {
+    if (size > this->_settings.chunkSize) return false;
+
+    auto keyStr = _keyOf(key);
+    char* destination = nullptr;
+    std::shared_ptr<MappedFile> segment;
+
+    // reserve slot
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+
+        // already there (or being written), chunks never change
+        if (this->_entries.count(keyStr)) return true;
+
+        auto slot = this->_takeSlot();
+        if (!slot) return false;
+
+        this->_lru.push_front(keyStr);
+
+        _Entry entry;
+        entry.slot = *slot;
+        entry.size = static_cast<uint32_t>(size);
+        entry.pins = 1;
+        entry.lru = this->_lru.begin();
+        this->_entries.emplace(keyStr, entry);
+
+        segment = this->_segmentOf(*slot);
+        destination = this->_slotData(*slot);
+    }
+
+    // copy without holding lock, slot is pinned meanwhile
+    std::memcpy(destination, data, size);
+
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    auto &entry = this->_entries.at(keyStr);
+    entry.ready = true;
+    entry.pins--;
+
+    return true;
+}
+
+void AudioTube::ChunkCache::_unpin(const std::string &key) {
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    auto found = this->_entries.find(key);
+    if (found != this->_entries.end() && found->second.pins) found->second.pins--;
+}
+
+AudioTube::ChunkCache::Stats AudioTube::ChunkCache::stats() {
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    auto out = this->_stats;
+    out.chunks = std::count_if(this->_entries.begin(), this->_entries.end(), [](const auto &entry) { return entry.second.ready; });
+    return out;
+}
+
+void AudioTube::ChunkCache::flush() {
+    std::lock_guard<std::mutex> lock(this->_mutex);
+
+    // data first, so that index never references unwritten chunks
+    for (auto &segment : this->_segments) {
+        if (segment) segment->flush();
+    }
+
+    this->_saveIndex();
+}
+
+void AudioTube::ChunkCache::_saveIndex() {
+    auto path = this->_indexPath();
+    auto tmpPath = path + ".tmp";
+
+    {
+        std::ofstream fh(tmpPath, std::ios::trunc);
+        fh << "chunkcache 1 " << this->_settings.chunkSize << " " << this->_settings.chunksPerSegment << "\n";
+
+        // least recent first, so that loading in order restores recency
+        for (auto it = this->_lru.rbegin(); it != this->_lru.rend(); it++) {
+            const auto &entry = this->_entries.at(*it);
+            if (!entry.ready) continue;
+            fh << *it << " " << entry.slot << " " << entry.size << "\n";
+        }
+
+        if (!fh) {
+            spdlog::warn("ChunkCache : Cannot write index [{}]", tmpPath);
+            return;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    if (!ec) this->_indexOnDisk = true;
+}
+
+bool AudioTube::ChunkCache::_removeIndex() {
+    if (!this->_indexOnDisk) return true;
+
+    std::error_code ec;
+    std::filesystem::remove(this->_indexPath(), ec);
+    if (ec) {
+        spdlog::warn("ChunkCache : Cannot remove index of [{}]", this->_settings.directory);
+        return false;
+    }
+
+    this->_indexOnDisk = false;
+    return true;
+}
+
+void AudioTube::ChunkCache::_loadIndex() {
+    std::ifstream fh(this->_indexPath());
+    if (!fh) return;
+
+    // layout changed, start over
+    std::string magic;
+    unsigned int version = 0, chunksPerSegment = 0;
+    uint64_t chunkSize = 0;
+    fh >> magic >> version >> chunkSize >> chunksPerSegment;
+    if (magic != "chunkcache" || version != 1 || chunkSize != this->_settings.chunkSize || chunksPerSegment != this->_settings.chunksPerSegment) {
+        spdlog::debug("ChunkCache : Index of [{}] does not match settings, discarding it", this->_settings.directory);
+        return;
+    }
+
+    this->_indexOnDisk = true;
+
+    std::string key;
+    _Entry entry;
+    std::vector<bool> used(this->_capacity, false);
+    while (fh >> key >> entry.slot >> entry.size) {
+        // budget might have shrunk
+        if (entry.slot >= this->_capacity || used[entry.slot] || entry.size > chunkSize || this->_entries.count(key)) continue;
+        used[entry.slot] = true;
+
+        this->_lru.push_front(key);
+        entry.lru = this->_lru.begin();
+        entry.ready = true;
+        this->_entries.emplace(key, entry);
+    }
+
+    spdlog::debug("ChunkCache : {} chunks found in [{}]", this->_entries.size(), this->_settings.directory);
+}
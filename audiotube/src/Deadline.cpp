@@ -0,0 +1,85 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "Deadline.h"
+
+AudioTube::CancellationToken::CancellationToken() {}
+
+AudioTube::CancellationToken::CancellationToken(const std::shared_ptr<std::atomic<unsigned int>> &generation, unsigned int issuedAt) :
+    _generation(generation), _issuedAt(issuedAt) {}
+
+bool AudioTube::CancellationToken::isCancelled() const {
+    if (!this->_generation) return false;
+    return this->_generation->load() != this->_issuedAt;
+}
+
+AudioTube::CancellationSource::CancellationSource() : _generation(std::make_shared<std::atomic<unsigned int>>(0)) {}
+
+AudioTube::CancellationToken AudioTube::CancellationSource::token() const {
+    return CancellationToken(this->_generation, this->_generation->load());
+}
+
+void AudioTube::CancellationSource::cancel() {
+    this->_generation->fetch_add(1);
+}
+
+AudioTube::Deadline::Deadline() : Deadline(Timeouts()) {}
+
+AudioTube::Deadline::Deadline(const Timeouts &timeouts, const CancellationToken &token) : _timeouts(timeouts), _token(token) {
+    this->_expiresAt = timeouts.total.count() > 0 ?
+        Clock::now() + timeouts.total :
+        Clock::time_point::max();
+}
+
+AudioTube::Deadline::Clock::time_point AudioTube::Deadline::phaseLimit(const Phase &phase) const {
+    std::chrono::milliseconds timeout;
+    switch (phase) {
+        case Phase::Connect:
+            timeout = this->_timeouts.connect;
+            break;
+        case Phase::TLS:
+            timeout = this->_timeouts.tls;
+            break;
+        case Phase::FirstByte:
+            timeout = this->_timeouts.firstByte;
+            break;
+    }
+
+    return std::min(Clock::now() + timeout, this->_expiresAt);
+}
+
+AudioTube::Deadline::Clock::time_point AudioTube::Deadline::expiresAt() const {
+    return this->_expiresAt;
+}
+
+bool AudioTube::Deadline::isCancelled() const {
+    return this->_token.isCancelled();
+}
+
+bool AudioTube::Deadline::isExpired() const {
+    return Clock::now() >= this->_expiresAt;
+}
+
+bool AudioTube::Deadline::isOver() const {
+    return this->isCancelled() || this->isExpired();
+}
+
+void AudioTube::Deadline::throwIfOver(const std::string &what) const {
+    if (this->isCancelled()) throw CancelledError(what + " cancelled");
+    if (this->isExpired()) throw DeadlineExceededError(what + " timed out");
+}
+
+const AudioTube::CancellationToken& AudioTube::Deadline::token() const {
+    return this->_token;
+}
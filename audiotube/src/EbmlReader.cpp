@@ -0,0 +1,90 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include <cstring>
+#include <stdexcept>
+
+#include "EbmlReader.h"
+
+std::optional<std::pair<uint64_t, size_t>> AudioTube::EbmlReader::readVint(const char* data, size_t size, bool keepMarker) {
+    if (!size) return std::nullopt;
+
+    auto first = static_cast<uint8_t>(data[0]);
+    if (!first) throw std::runtime_error("EbmlReader : Invalid EBML variable size integer");
+
+    // length is given by leading zeros
+    size_t length = 1;
+    while (!(first & (0x80 >> (length - 1)))) length++;
+    if (size < length) return std::nullopt;
+
+    uint64_t value = keepMarker ? first : (first & (0xFF >> length));
+    for (size_t i = 1; i < length; i++) {
+        value = (value << 8) | static_cast<uint8_t>(data[i]);
+    }
+
+    return std::make_pair(value, length);
+}
+
+std::optional<AudioTube::EbmlReader::Header> AudioTube::EbmlReader::readHeader(const char* data, size_t size) {
+    auto id = readVint(data, size, true);
+    if (!id) return std::nullopt;
+    if (id->second > 4) throw std::runtime_error("EbmlReader : Invalid EBML element id");
+
+    auto elementSize = readVint(data + id->second, size - id->second, false);
+    if (!elementSize) return std::nullopt;
+
+    Header header;
+    header.id = static_cast<uint32_t>(id->first);
+    header.size = elementSize->first;
+    header.unknownSize = elementSize->first == (1ull << (7 * elementSize->second)) - 1;
+    header.length = id->second + elementSize->second;
+    return header;
+}
+
+uint64_t AudioTube::EbmlReader::readUInt(std::string_view body) {
+    uint64_t value = 0;
+    for (auto c : body) value = (value << 8) | static_cast<uint8_t>(c);
+    return value;
+}
+
+double AudioTube::EbmlReader::readFloat(std::string_view body) {
+    auto bits = readUInt(body);
+
+    if (body.size() == 4) {
+        auto bits32 = static_cast<uint32_t>(bits);
+        float value;
+        std::memcpy(&value, &bits32, sizeof(value));
+        return value;
+    }
+
+    if (body.size() == 8) {
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    return 0;
+}
+
+void AudioTube::EbmlReader::forEachChild(std::string_view body, const std::function<void(uint32_t id, std::string_view childBody)> &onChild) {
+    size_t offset = 0;
+
+    while (offset < body.size()) {
+        auto header = readHeader(body.data() + offset, body.size() - offset);
+        if (!header || header->unknownSize || header->size > body.size() - offset - header->length) return;
+
+        onChild(header->id, body.substr(offset + header->length, header->size));
+        offset += header->length + header->size;
+    }
+}
@@ -0,0 +1,128 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <charconv>
+
+#include "HTTPStream.h"
+
+AudioTube::HTTPStream::HTTPStream(const std::string &url) : _url(url) {}
+
+AudioTube::HTTPStream::~HTTPStream() {
+    asio::error_code ignored;
+    if (this->_sslStream) this->_sslStream->lowest_layer().close(ignored);
+    if (this->_socket) this->_socket->close(ignored);
+}
+
+std::unique_ptr<AudioTube::HTTPStream> AudioTube::HTTPStream::open(const std::string &url, const Deadline &deadline, const std::vector<std::string> &extraHeaders) {
+    auto currentUrl = url;
+
+    for (unsigned int redirects = 0; redirects <= MaxRedirects; redirects++) {
+        _rateLimiter.acquire(UrlParser(currentUrl).host(), deadline);
+
+        std::unique_ptr<HTTPStream> stream(new HTTPStream(currentUrl));
+        stream->_open(deadline, extraHeaders);
+
+        if (stream->_head.redirectUrl.empty()) return stream;
+        currentUrl = stream->_head.redirectUrl;
+    }
+
+    throw std::runtime_error("HTTPStream : Too many redirects for [" + url + "]");
+}
+
+void AudioTube::HTTPStream::_open(const Deadline &deadline, const std::vector<std::string> &extraHeaders) {
+    UrlParser url_decomposer(this->_url);
+    auto socket = _connect(this->_ioContext, url_decomposer, deadline);
+
+    spdlog::debug("HTTPStream : Opening [{}]...", this->_url);
+
+    // plain HTTP, eg. local servers
+    if (url_decomposer.scheme() == "http") {
+        this->_socket = std::make_unique<tcp::socket>(std::move(socket));
+        _sendRequest(this->_ioContext, *this->_socket, url_decomposer, false, deadline, extraHeaders);
+        this->_head = _readHead(this->_ioContext, *this->_socket, this->_buffer, url_decomposer.host(), deadline);
+    } else {
+        this->_sslContext.set_default_verify_paths();
+        this->_sslStream = std::make_unique<ssl::stream<tcp::socket>>(this->_ioContext, this->_sslContext);
+        this->_sslStream->next_layer() = std::move(socket);
+        _handshake(this->_ioContext, *this->_sslStream, url_decomposer.hostName(), deadline);
+
+        _sendRequest(this->_ioContext, *this->_sslStream, url_decomposer, false, deadline, extraHeaders);
+        this->_head = _readHead(this->_ioContext, *this->_sslStream, this->_buffer, url_decomposer.host(), deadline);
+    }
+
+    // to tell a complete body from a dropped connection
+    auto contentLength = headerValue(this->_head, "Content-Length");
+    uint64_t bodySize = 0;
+    auto parsed = std::from_chars(contentLength.data(), contentLength.data() + contentLength.size(), bodySize);
+    if (!contentLength.empty() && parsed.ec == std::errc()) this->_bodySize = bodySize;
+}
+
+const AudioTube::NetworkHelper::Response& AudioTube::HTTPStream::head() const {
+    return this->_head;
+}
+
+std::string AudioTube::HTTPStream::url() const {
+    return this->_url;
+}
+
+bool AudioTube::HTTPStream::atEnd() const {
+    return this->_atEnd && !this->_buffer.size();
+}
+
+template<typename Stream>
+void AudioTube::HTTPStream::_fill(Stream &stream, const Deadline &deadline) {
+    _PendingOp reading;
+    asio::async_read(stream, this->_buffer, asio::transfer_at_least(1), reading.handler());
+    _await(this->_ioContext, &reading, deadline.expiresAt(), deadline, "Reading [" + this->_url + "]", _closer(stream));
+
+    if (!reading.ec) return;
+
+    // EOF, or truncated TLS stream when server does not bother to shutdown properly
+    auto closed = reading.ec == asio::error::eof || reading.ec == ssl::error::stream_truncated;
+    if (!closed) {
+        throw std::runtime_error("HTTPStream : Reading [" + this->_url + "] failed : " + reading.ec.message());
+    }
+
+    // ...which is only fine once whole body is received
+    auto received = this->_received + this->_buffer.size();
+    if (this->_bodySize && received < *this->_bodySize) {
+        throw std::runtime_error("HTTPStream : [" + this->_url + "] truncated, " + std::to_string(received) + " bytes out of " + std::to_string(*this->_bodySize));
+    }
+
+    this->_atEnd = true;
+}
+
+size_t AudioTube::HTTPStream::read(char* out, size_t maxBytes, const Deadline &deadline) {
+    // whole body received, no need to wait for connection to close
+    if (this->_bodySize && this->_received >= *this->_bodySize) this->_atEnd = true;
+
+    // bytes received along with headers first
+    if (!this->_buffer.size() && !this->_atEnd) {
+        if (this->_sslStream) {
+            this->_fill(*this->_sslStream, deadline);
+        } else {
+            this->_fill(*this->_socket, deadline);
+        }
+    }
+
+    auto count = std::min(maxBytes, this->_buffer.size());
+    asio::buffer_copy(asio::buffer(out, count), this->_buffer.data());
+    this->_buffer.consume(count);
+    this->_received += count;
+
+    return count;
+}
@@ -0,0 +1,115 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "MappedFile.h"
+
+#include <stdexcept>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+AudioTube::MappedFile::MappedFile(const std::string &path, size_t size) : _path(path), _size(size) {
+    this->_file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (this->_file == INVALID_HANDLE_VALUE) throw std::runtime_error("MappedFile : Cannot open [" + path + "]");
+
+    // mapping grows the file if needed
+    LARGE_INTEGER mappingSize;
+    mappingSize.QuadPart = static_cast<LONGLONG>(size);
+    this->_mapping = CreateFileMappingA(this->_file, nullptr, PAGE_READWRITE, mappingSize.HighPart, mappingSize.LowPart, nullptr);
+    if (!this->_mapping) {
+        this->_close();
+        throw std::runtime_error("MappedFile : Cannot map [" + path + "]");
+    }
+
+    this->_data = static_cast<char*>(MapViewOfFile(this->_mapping, FILE_MAP_ALL_ACCESS, 0, 0, size));
+    if (!this->_data) {
+        this->_close();
+        throw std::runtime_error("MappedFile : Cannot map view of [" + path + "]");
+    }
+}
+
+void AudioTube::MappedFile::flush() {
+    if (!this->_data) return;
+    FlushViewOfFile(this->_data, this->_size);
+    FlushFileBuffers(this->_file);
+}
+
+void AudioTube::MappedFile::_close() {
+    if (this->_data) UnmapViewOfFile(this->_data);
+    if (this->_mapping) CloseHandle(this->_mapping);
+    if (this->_file != INVALID_HANDLE_VALUE) CloseHandle(this->_file);
+
+    this->_data = nullptr;
+    this->_mapping = nullptr;
+    this->_file = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+AudioTube::MappedFile::MappedFile(const std::string &path, size_t size) : _path(path), _size(size) {
+    this->_fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (this->_fd < 0) throw std::runtime_error("MappedFile : Cannot open [" + path + "]");
+
+    // grow, never shrink
+    struct stat fileStat;
+    if (::fstat(this->_fd, &fileStat) != 0 || (static_cast<size_t>(fileStat.st_size) < size && ::ftruncate(this->_fd, size) != 0)) {
+        this->_close();
+        throw std::runtime_error("MappedFile : Cannot resize [" + path + "]");
+    }
+
+    auto mapped = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, this->_fd, 0);
+    if (mapped == MAP_FAILED) {
+        this->_close();
+        throw std::runtime_error("MappedFile : Cannot map [" + path + "]");
+    }
+
+    this->_data = static_cast<char*>(mapped);
+}
+
+void AudioTube::MappedFile::flush() {
+    if (!this->_data) return;
+    ::msync(this->_data, this->_size, MS_SYNC);
+}
+
+void AudioTube::MappedFile::_close() {
+    if (this->_data) ::munmap(this->_data, this->_size);
+    if (this->_fd >= 0) ::close(this->_fd);
+
+    this->_data = nullptr;
+    this->_fd = -1;
+}
+
+#endif
+
+AudioTube::MappedFile::~MappedFile() {
+    this->_close();
+}
+
+char* AudioTube::MappedFile::data() {
+    return this->_data;
+}
+
+const char* AudioTube::MappedFile::data() const {
+    return this->_data;
+}
+
+size_t AudioTube::MappedFile::size() const {
+    return this->_size;
+}
@@ -0,0 +1,288 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include <charconv>
+
+#include "MpdParser.h"
+
+void AudioTube::MpdParser::feed(const std::string_view &data) {
+    this->feed(data.data(), data.size());
+}
+
+void AudioTube::MpdParser::feed(const char* data, size_t size) {
+    this->_pending.append(data, size);
+    std::string_view pending(this->_pending);
+
+    size_t consumed = 0;
+    while (consumed < pending.size()) {
+        // text, only kept within BaseURL
+        if (pending[consumed] != '<') {
+            auto markupStart = pending.find('<', consumed);
+            auto textEnd = markupStart == std::string_view::npos ? pending.size() : markupStart;
+            if (this->_inBaseUrl) this->_text.append(pending.substr(consumed, textEnd - consumed));
+            consumed = textEnd;
+            continue;
+        }
+
+        // wait for the rest of the markup
+        auto markupLength = _markupEnd(pending.substr(consumed));
+        if (!markupLength) break;
+
+        this->_onMarkup(pending.substr(consumed, *markupLength));
+        consumed += *markupLength;
+    }
+
+    this->_pending.erase(0, consumed);
+}
+
+const std::vector<AudioTube::MpdParser::Representation>& AudioTube::MpdParser::representations() const {
+    return this->_representations;
+}
+
+size_t AudioTube::MpdParser::representationsCount() const {
+    return this->_representationsCount;
+}
+
+bool AudioTube::MpdParser::isComplete() const {
+    return this->_complete;
+}
+
+AudioTube::MpdParser::Representation* AudioTube::MpdParser::_scope() {
+    if (this->_inRepresentation) return &this->_representation;
+    if (this->_inAdaptationSet) return &this->_adaptationSet;
+    return &this->_period;
+}
+
+std::optional<size_t> AudioTube::MpdParser::_markupEnd(const std::string_view &view) {
+    auto endOf = [&view](const std::string_view &closing) -> std::optional<size_t> {
+        auto found = view.find(closing);
+        if (found == std::string_view::npos) return std::nullopt;
+        return found + closing.size();
+    };
+
+    if (view.substr(0, 4) == "<!--") return endOf("-->");
+    if (view.substr(0, 9) == "<![CDATA[") return endOf("]]>");
+    if (view.substr(0, 2) == "<?") return endOf("?>");
+
+    // tag, whose attributes might contain '>'
+    char quote = 0;
+    for (size_t i = 1; i < view.size(); i++) {
+        auto c = view[i];
+        if (quote) {
+            if (c == quote) quote = 0;
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '>') {
+            return i + 1;
+        }
+    }
+
+    return std::nullopt;
+}
+
+void AudioTube::MpdParser::_onMarkup(const std::string_view &markup) {
+    if (markup.substr(0, 9) == "<![CDATA[") {
+        if (this->_inBaseUrl) this->_text.append(markup.substr(9, markup.size() - 12));
+        return;
+    }
+
+    // comments, processing instructions, doctype
+    if (markup[1] == '!' || markup[1] == '?') return;
+
+    if (markup[1] == '/') {
+        auto name = markup.substr(2, markup.size() - 3);
+        auto nameEnd = name.find_first_of(" \t\r\n");
+        this->_onEnd(_localName(name.substr(0, nameEnd)));
+        return;
+    }
+
+    auto selfClosing = markup[markup.size() - 2] == '/';
+    auto inner = markup.substr(1, markup.size() - (selfClosing ? 3 : 2));
+
+    auto nameEnd = inner.find_first_of(" \t\r\n");
+    auto name = _localName(inner.substr(0, nameEnd));
+
+    // name="value" pairs, pointing into markup
+    _Attributes attributes;
+    auto rest = nameEnd == std::string_view::npos ? std::string_view() : inner.substr(nameEnd);
+    while (true) {
+        auto keyStart = rest.find_first_not_of(" \t\r\n");
+        if (keyStart == std::string_view::npos) break;
+
+        auto equal = rest.find('=', keyStart);
+        if (equal == std::string_view::npos) break;
+
+        auto quoteStart = rest.find_first_of("\"'", equal);
+        if (quoteStart == std::string_view::npos) break;
+
+        auto quoteEnd = rest.find(rest[quoteStart], quoteStart + 1);
+        if (quoteEnd == std::string_view::npos) break;
+
+        auto key = rest.substr(keyStart, equal - keyStart);
+        key = key.substr(0, key.find_first_of(" \t\r\n"));
+
+        attributes.emplace_back(_localName(key), rest.substr(quoteStart + 1, quoteEnd - quoteStart - 1));
+        rest = rest.substr(quoteEnd + 1);
+    }
+
+    this->_onStart(name, attributes);
+    if (selfClosing) this->_onEnd(name);
+}
+
+void AudioTube::MpdParser::_onStart(const std::string_view &name, const _Attributes &attributes) {
+    // common to AdaptationSet and Representation
+    auto fillFrom = [&attributes](Representation* target) {
+        auto mimeType = _attribute(attributes, "mimeType");
+        if (!mimeType.empty()) target->mimeType = _unescaped(mimeType);
+
+        auto codecs = _attribute(attributes, "codecs");
+        if (!codecs.empty()) target->codecs = _unescaped(codecs);
+
+        auto samplingRate = _attribute(attributes, "audioSamplingRate");
+        if (!samplingRate.empty()) target->audioSamplingRate = _uintFrom(samplingRate);
+    };
+
+    if (name == "AdaptationSet") {
+        this->_inAdaptationSet = true;
+        this->_adaptationSet = this->_period;
+        this->_adaptationContentType = _unescaped(_attribute(attributes, "contentType"));
+        fillFrom(&this->_adaptationSet);
+
+    } else if (name == "Representation") {
+        this->_inRepresentation = true;
+        this->_representation = this->_inAdaptationSet ? this->_adaptationSet : this->_period;
+        this->_representation.id = _unescaped(_attribute(attributes, "id"));
+        this->_representation.bandwidth = _uintFrom(_attribute(attributes, "bandwidth"));
+        fillFrom(&this->_representation);
+
+    } else if (name == "BaseURL") {
+        this->_inBaseUrl = true;
+        this->_text.clear();
+
+    } else if (name == "SegmentBase") {
+        this->_inSegmentBase = true;
+        this->_scope()->indexRange = NetworkHelper::byteRangeFrom(_attribute(attributes, "indexRange"));
+
+    } else if (name == "SegmentList") {
+        this->_inSegmentList = true;
+        this->_scope()->segmentUrls.clear();
+
+    } else if (name == "Initialization") {
+        if (this->_inSegmentBase) this->_scope()->initRange = NetworkHelper::byteRangeFrom(_attribute(attributes, "range"));
+        if (this->_inSegmentList) this->_scope()->initializationUrl = _unescaped(_attribute(attributes, "sourceURL"));
+
+    } else if (name == "SegmentURL") {
+        if (this->_inSegmentList) this->_scope()->segmentUrls.push_back(_unescaped(_attribute(attributes, "media")));
+    }
+}
+
+void AudioTube::MpdParser::_onEnd(const std::string_view &name) {
+    if (name == "BaseURL") {
+        this->_inBaseUrl = false;
+        auto scope = this->_scope();
+        scope->baseUrl = _resolved(scope->baseUrl, trimmed(_unescaped(this->_text)));
+
+    } else if (name == "SegmentBase") {
+        this->_inSegmentBase = false;
+
+    } else if (name == "SegmentList") {
+        this->_inSegmentList = false;
+
+    } else if (name == "Representation") {
+        this->_inRepresentation = false;
+        this->_representationsCount++;
+
+        // either typed by itself or by its set
+        auto &representation = this->_representation;
+        auto isAudio = representation.mimeType.rfind("audio/", 0) == 0
+                        || (this->_inAdaptationSet && this->_adaptationContentType == "audio");
+        if (!isAudio) return;
+
+        // segments are relative to BaseURL, once known
+        if (!representation.initializationUrl.empty()) {
+            representation.initializationUrl = _resolved(representation.baseUrl, representation.initializationUrl);
+        }
+        for (auto &segmentUrl : representation.segmentUrls) {
+            segmentUrl = _resolved(representation.baseUrl, segmentUrl);
+        }
+
+        this->_representations.push_back(std::move(representation));
+
+    } else if (name == "AdaptationSet") {
+        this->_inAdaptationSet = false;
+
+    } else if (name == "MPD") {
+        this->_complete = true;
+    }
+}
+
+std::string_view AudioTube::MpdParser::_localName(const std::string_view &name) {
+    auto colon = name.find(':');
+    return colon == std::string_view::npos ? name : name.substr(colon + 1);
+}
+
+std::string_view AudioTube::MpdParser::_attribute(const _Attributes &attributes, const std::string_view &name) {
+    for (const auto &[key, value] : attributes) {
+        if (key == name) return value;
+    }
+    return std::string_view();
+}
+
+std::string AudioTube::MpdParser::_unescaped(const std::string_view &value) {
+    if (value.find('&') == std::string_view::npos) return std::string { value };
+
+    static const std::pair<std::string_view, char> entities[] {
+        { "&amp;", '&' }, { "&lt;", '<' }, { "&gt;", '>' }, { "&quot;", '"' }, { "&apos;", '\'' }
+    };
+
+    std::string out;
+    out.reserve(value.size());
+
+    for (size_t i = 0; i < value.size(); i++) {
+        auto replaced = false;
+        if (value[i] == '&') {
+            for (const auto &[entity, c] : entities) {
+                if (value.substr(i, entity.size()) != entity) continue;
+                out += c;
+                i += entity.size() - 1;
+                replaced = true;
+                break;
+            }
+        }
+        if (!replaced) out += value[i];
+    }
+
+    return out;
+}
+
+std::string AudioTube::MpdParser::_resolved(const std::string &base, const std::string &url) {
+    if (base.empty() || url.find("://") != std::string::npos) return url;
+
+    // absolute path, from host of base
+    if (!url.empty() && url[0] == '/') {
+        auto schemeEnd = base.find("://");
+        auto hostEnd = schemeEnd == std::string::npos ? std::string::npos : base.find('/', schemeEnd + 3);
+        return base.substr(0, hostEnd) + url;
+    }
+
+    // relative to the "directory" of base
+    auto lastSlash = base.rfind('/');
+    return base.substr(0, lastSlash == std::string::npos ? 0 : lastSlash + 1) + url;
+}
+
+unsigned int AudioTube::MpdParser::_uintFrom(const std::string_view &value) {
+    unsigned int out = 0;
+    auto result = std::from_chars(value.data(), value.data() + value.size(), out);
+    return result.ec == std::errc() ? out : 0;
+}
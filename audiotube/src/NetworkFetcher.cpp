@@ -22,30 +22,80 @@ promise::Promise AudioTube::NetworkFetcher::fromPlaylistUrl(const std::string &u
             .then(&_videoIdsToMetadataList);
 }
 
-promise::Promise AudioTube::NetworkFetcher::refreshMetadata(VideoMetadata* toRefresh, bool force) {
+promise::Promise AudioTube::NetworkFetcher::refreshMetadata(VideoMetadata* toRefresh, bool force, const Deadline::Timeouts &timeouts) {
+    return _refresh(toRefresh, force, timeouts, false);
+}
+
+promise::Promise AudioTube::NetworkFetcher::refreshMetadataInBackground(VideoMetadata* toRefresh, const Deadline::Timeouts &timeouts) {
+    return _refresh(toRefresh, false, timeouts, true);
+}
+
+AudioTube::Deadline::Timeouts AudioTube::NetworkFetcher::refreshTimeouts() {
+    Deadline::Timeouts timeouts;
+    timeouts.total = std::chrono::seconds(60);
+    return timeouts;
+}
+
+promise::Promise AudioTube::NetworkFetcher::_refresh(VideoMetadata* toRefresh, bool force, const Deadline::Timeouts &timeouts, bool background) {
     // check if soft refresh...
     if (!force && !toRefresh->audioStreams()->isExpired()) return promise::resolve(toRefresh);
 
+    // known as unavailable, do not bother asking again for now
+    if (auto unavailable = UnavailabilityCache::find(toRefresh->id())) {
+        spdlog::debug("AudioTube : [{}] skipped, still unavailable : {}", toRefresh->id(), unavailable->message);
+        return promise::newPromise([=](promise::Defer d) {
+            toRefresh->setFailure(true);
+            toRefresh->setRanOnce();
+            d.reject(UnavailableVideoError(unavailable->reason, unavailable->message));
+        });
+    }
+
     // if not, reset failure flag and emit event
+    auto failedBefore = toRefresh->hasFailed();
     toRefresh->setFailure(false);
     toRefresh->OnMetadataFetching();
 
+    // bound whole pipeline in time, and allow to cancel it through metadata
+    Deadline deadline(timeouts, toRefresh->cancellationToken());
+
     // workflow...
     return promise::newPromise([=](promise::Defer d) {
+        // same video is already being refreshed, share its outcome
+        if (auto inflight = _followInflightRefresh(toRefresh)) {
+            _awaitInflightRefresh(toRefresh, *inflight, deadline, d);
+            return;
+        }
+        if (!background) _pendingRefreshes++;
+
         // on error default behavior
         auto whenFailed = [=]() {
            toRefresh->setFailure(true);
            toRefresh->setRanOnce();
+           if (!background) _pendingRefreshes--;
+           _settleInflightRefresh(toRefresh, false);
            d.reject();
         };
 
-        _refreshMetadata(toRefresh)
+        _refreshMetadata(toRefresh, deadline, failedBefore)
         .then([=]() {
             // success !
+            UnavailabilityCache::forget(toRefresh->id());
             toRefresh->setRanOnce();
+            if (!background) _pendingRefreshes--;
+            _settleInflightRefresh(toRefresh, true);
+            _startPrefetch(toRefresh);
             toRefresh->OnMetadataRefreshed();
             d.resolve(toRefresh);
         })
+        .fail([=](const UnavailableVideoError &exception) {
+            spdlog::warn("AudioTube : {}", exception.what());
+            UnavailabilityCache::remember(toRefresh->id(), exception);
+            whenFailed();
+        })
+        .fail([=](const CancelledError &exception) {
+            spdlog::debug("AudioTube : {}", exception.what());
+            whenFailed();
+        })
         .fail([=](const std::runtime_error &exception) {
             spdlog::warn("AudioTube : {}", exception.what());
             whenFailed();
@@ -65,30 +115,178 @@ promise::Promise AudioTube::NetworkFetcher::refreshMetadata(VideoMetadata* toRef
     });
 }
 
-bool AudioTube::NetworkFetcher::isStreamAvailable(VideoMetadata* toCheck) {
-    auto bestUrl = toCheck->audioStreams()->preferedUrl();
-    auto response = AudioTube::NetworkHelper::downloadHTTPS(bestUrl, true);  // download HEAD
+std::optional<AudioTube::NetworkFetcher::_SharedRefresh> AudioTube::NetworkFetcher::_followInflightRefresh(VideoMetadata* metadata) {
+    std::lock_guard<std::mutex> lock(_inflightMutex);
+
+    // if none, lead
+    auto found = _inflightRefreshes.find(metadata->id());
+    if (found == _inflightRefreshes.end()) {
+        _InflightRefresh inflight;
+        inflight.shared = inflight.leader.get_future().share();
+        _inflightRefreshes.emplace(metadata->id(), std::move(inflight));
+        return std::nullopt;
+    }
+
+    // else, follow
+    return found->second.shared;
+}
+
+void AudioTube::NetworkFetcher::_awaitInflightRefresh(VideoMetadata* follower, const _SharedRefresh &inflight, const Deadline &deadline, promise::Defer d) {
+    spdlog::debug("AudioTube : [{}] is already being refreshed, waiting for it...", follower->id());
+
+    // in caller's thread, leader never touches followers
+    std::shared_ptr<const _Refreshed> refreshed;
+    try {
+        deadline.wait(inflight, "AudioTube : Refresh of [" + follower->id() + "]");
+        refreshed = inflight.get();
+    } catch(const std::runtime_error &e) {
+        spdlog::debug("AudioTube : {}", e.what());
+    }
+
+    if (!refreshed) {
+        follower->setFailure(true);
+        follower->setRanOnce();
+        d.reject();
+        return;
+    }
+
+    follower->setPlayerConfig(refreshed->playerConfig);
+    *follower->audioStreams() = refreshed->audioStreams;
+    follower->setRanOnce();
+    _startPrefetch(follower);
+    follower->OnMetadataRefreshed();
+    d.resolve(follower);
+}
+
+void AudioTube::NetworkFetcher::_settleInflightRefresh(VideoMetadata* leader, bool succeeded) {
+    std::promise<std::shared_ptr<const _Refreshed>> outcome;
 
-    // unstack if redirects
-    while(!response.redirectUrl.empty()) {
-        response = AudioTube::NetworkHelper::downloadHTTPS(response.redirectUrl, true);
+    {
+        std::lock_guard<std::mutex> lock(_inflightMutex);
+        auto found = _inflightRefreshes.find(leader->id());
+        if (found == _inflightRefreshes.end()) return;
+        outcome = std::move(found->second.leader);
+        _inflightRefreshes.erase(found);
     }
 
-    auto isStreamAvailable = response.hasContentLengthHeader && response.statusCode == 200;
+    // snapshot, leader might be refreshed again or deleted while followers copy it
+    if (!succeeded) {
+        outcome.set_value(nullptr);
+        return;
+    }
+    outcome.set_value(std::make_shared<const _Refreshed>(_Refreshed { *leader->playerConfig(), *leader->audioStreams() }));
+}
 
-    if(isStreamAvailable) spdlog::debug("Stream Available for [{}] : [{}]", toCheck->id(), bestUrl);
+void AudioTube::NetworkFetcher::setPrefetchSize(size_t bytes) {
+    _prefetchSize = bytes;
+}
 
-    return isStreamAvailable;
+unsigned int AudioTube::NetworkFetcher::pendingRefreshes() {
+    return _pendingRefreshes;
 }
 
-promise::Promise AudioTube::NetworkFetcher::_refreshMetadata(VideoMetadata* metadata) {
-    auto videoInfoPipeline = PlayerConfig::from_EmbedPage(metadata->id())
+void AudioTube::NetworkFetcher::_startPrefetch(VideoMetadata* metadata) {
+    auto prefetchSize = _prefetchSize.load();
+    if (!prefetchSize) return;
+
+    // runs in background, failures are only logged
+    try {
+        metadata->prefetch()->start(metadata->audioStreams()->preferedUrl(), prefetchSize);
+    } catch(const std::exception &e) {
+        spdlog::debug("AudioTube : Cannot prefetch [{}] : {}", metadata->id(), e.what());
+    }
+}
+
+bool AudioTube::NetworkFetcher::isStreamAvailable(VideoMetadata* toCheck, bool trustManifest, const Deadline::Timeouts &timeouts) {
+    return areStreamsAvailable({ toCheck }, trustManifest, 1, timeouts).front();
+}
+
+std::vector<bool> AudioTube::NetworkFetcher::areStreamsAvailable(const std::vector<VideoMetadata*> &toCheck, bool trustManifest, unsigned int concurrency,
+                                                                    const Deadline::Timeouts &timeouts) {
+    std::vector<bool> out(toCheck.size(), false);
+    std::vector<std::string> toProbe;
+    std::vector<size_t> probedIndexes;
+
+    for (size_t i = 0; i < toCheck.size(); i++) {
+        auto streams = toCheck[i]->audioStreams();
+
+        try {
+            const auto &stream = streams->preferedStream();
+
+            // size given by manifest, no need to ask
+            if (trustManifest && stream.contentLength && !streams->isExpired()) {
+                spdlog::debug("Stream Available for [{}] from manifest : {} bytes", toCheck[i]->id(), stream.contentLength);
+                out[i] = true;
+                continue;
+            }
+
+            toProbe.push_back(stream.url);
+            probedIndexes.push_back(i);
+        } catch(const std::logic_error &e) {
+            spdlog::debug("No stream to check for [{}] : {}", toCheck[i]->id(), e.what());
+        }
+    }
+
+    if (toProbe.empty()) return out;
+
+    auto results = _prober.probeAll(toProbe, concurrency, timeouts);
+    for (size_t i = 0; i < results.size(); i++) {
+        auto index = probedIndexes[i];
+        out[index] = results[i].available;
+        if (results[i].available) spdlog::debug("Stream Available for [{}] : [{}]", toCheck[index]->id(), toProbe[i]);
+    }
+
+    return out;
+}
+
+AudioTube::WebmSeekIndex AudioTube::NetworkFetcher::fetchSeekIndex(VideoMetadata* metadata, const Deadline::Timeouts &timeouts) {
+    const auto &stream = metadata->audioStreams()->preferedStream();
+    if (!stream.initRange || !stream.indexRange) throw std::logic_error("AudioTube : No index range known for [" + metadata->id() + "] stream");
+
+    return WebmSeekIndex::fetch(stream.url, *stream.initRange, *stream.indexRange, Deadline(timeouts, metadata->cancellationToken()));
+}
+
+promise::Promise AudioTube::NetworkFetcher::_refreshMetadata(VideoMetadata* metadata, const Deadline &deadline, bool failedBefore) {
+    if (!_canRefreshStreamsOnly(metadata, failedBefore)) return _refreshAllMetadata(metadata, deadline);
+
+    // try lightweight streams refresh first, then whole pipeline if it failed
+    return _refreshStreamsOnly(metadata, deadline).fail([=]() {
+        deadline.throwIfOver("AudioTube : Refresh of [" + metadata->id() + "]");
+        spdlog::debug("AudioTube : Streams-only refresh of [{}] failed, falling back to full refresh...", metadata->id());
+        return _refreshAllMetadata(metadata, deadline);
+    });
+}
+
+bool AudioTube::NetworkFetcher::_canRefreshStreamsOnly(VideoMetadata* metadata, bool failedBefore) {
+    // requires a previously successful run
+    if (!metadata->ranOnce() || failedBefore) return false;
+
+    // requires STS and decipherer from an Embed-based player config
+    auto pConfig = metadata->playerConfig();
+    return pConfig->decipherer() && !pConfig->sts().empty() && !pConfig->title().empty();
+}
+
+promise::Promise AudioTube::NetworkFetcher::_refreshStreamsOnly(VideoMetadata* metadata, const Deadline &deadline) {
+    spdlog::debug("AudioTube : Refreshing streams only of [{}]...", metadata->id());
+    metadata->audioStreams()->reset();
+    return VideoInfos::refreshStreamsManifest(
+        metadata->id(),
+        metadata->playerConfig(),
+        metadata->audioStreams(),
+        deadline
+    );
+}
+
+promise::Promise AudioTube::NetworkFetcher::_refreshAllMetadata(VideoMetadata* metadata, const Deadline &deadline) {
+    auto videoInfoPipeline = PlayerConfig::from_EmbedPage(metadata->id(), deadline)
     .then([=](const PlayerConfig &pConfig) {
         metadata->setPlayerConfig(pConfig);
+        metadata->audioStreams()->reset();
         return VideoInfos::fillStreamsManifest(
             metadata->id(),
             metadata->playerConfig(),
-            metadata->audioStreams()
+            metadata->audioStreams(),
+            deadline
         );
     });
 
@@ -96,7 +294,8 @@ promise::Promise AudioTube::NetworkFetcher::_refreshMetadata(VideoMetadata* meta
     return videoInfoPipeline.fail([=](const std::string &softErr){
         spdlog::debug(softErr);
 
-        auto watchPagePipeline = PlayerConfig::from_WatchPage(metadata->id(), metadata->audioStreams())
+        metadata->audioStreams()->reset();
+        auto watchPagePipeline = PlayerConfig::from_WatchPage(metadata->id(), metadata->audioStreams(), deadline)
         .then([=](const PlayerConfig &pConfig) {
             metadata->setPlayerConfig(pConfig);
         });
@@ -107,23 +306,7 @@ promise::Promise AudioTube::NetworkFetcher::_refreshMetadata(VideoMetadata* meta
 
 std::vector<std::string> AudioTube::NetworkFetcher::_extractVideoIdsFromHTTPRequest(const DownloadedUtf8 &requestData) {
     // search...
-    jp::VecNum matches;
-    jp::RegexMatch rm;
-    rm.setRegexObject(&Regexes::HTTPRequestYTVideoIdExtractor)
-        .setSubject(&requestData)
-        .addModifier("gm")
-        .setNumberedSubstringVector(&matches)
-        .match();
-
-    // check
-    if (!matches.size()) throw std::logic_error("[DASH] No YT IDs found in HTTP request");
-
-    // iterate
-    std::vector<std::string> idsList;
-    for (auto &submatches : matches) {
-        auto videoId = submatches[1];
-        idsList.push_back(videoId);
-    }
+    auto idsList = Regexes::findHTTPRequestYTVideoIds(requestData);
 
     // if no ids
     if (!idsList.size()) throw std::logic_error("no playlist metadata container found !");
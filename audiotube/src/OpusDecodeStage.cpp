@@ -0,0 +1,96 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include <spdlog/spdlog.h>
+
+#include <stdexcept>
+
+#include "OpusDecodeStage.h"
+
+int AudioTube::OpusDecodeStage::_channelsOf(const std::string &opusHead) {
+    // RFC 7845 5.1
+    if (opusHead.size() < 19 || opusHead.compare(0, 8, "OpusHead") != 0) throw std::logic_error("OpusDecodeStage : Invalid OpusHead");
+    return static_cast<uint8_t>(opusHead[9]);
+}
+
+AudioTube::OpusDecodeStage::OpusDecodeStage(const std::string &opusHead, size_t ringFrames) :
+    _channels(_channelsOf(opusHead)),
+    _ring(std::max<size_t>(ringFrames, _maxPacketFrames) * _channels) {
+    // little endian fields
+    auto mappingFamily = static_cast<uint8_t>(opusHead[18]);
+    if (mappingFamily != 0 || this->_channels < 1 || this->_channels > 2) {
+        throw std::logic_error("OpusDecodeStage : Only mono and stereo streams are supported");
+    }
+
+    this->_preSkip = static_cast<uint8_t>(opusHead[10]) | (static_cast<uint8_t>(opusHead[11]) << 8);
+    this->_toSkip = this->_preSkip;
+    auto outputGain = static_cast<int16_t>(static_cast<uint8_t>(opusHead[16]) | (static_cast<uint8_t>(opusHead[17]) << 8));
+
+    // decoder state is kept across packets
+    int error;
+    this->_decoder = opus_decoder_create(SampleRate, this->_channels, &error);
+    if (error != OPUS_OK) throw std::runtime_error(std::string("OpusDecodeStage : ") + opus_strerror(error));
+    opus_decoder_ctl(this->_decoder, OPUS_SET_GAIN(outputGain));
+
+    this->_scratch.resize(_maxPacketFrames * this->_channels);
+}
+
+AudioTube::OpusDecodeStage::~OpusDecodeStage() {
+    if (this->_decoder) opus_decoder_destroy(this->_decoder);
+}
+
+int AudioTube::OpusDecodeStage::channels() const {
+    return this->_channels;
+}
+
+bool AudioTube::OpusDecodeStage::canAccept() const {
+    return this->_ring.writable() >= this->_scratch.size();
+}
+
+void AudioTube::OpusDecodeStage::decode(std::string_view packet) {
+    auto frames = opus_decode_float(
+        this->_decoder,
+        reinterpret_cast<const unsigned char*>(packet.data()),
+        static_cast<opus_int32>(packet.size()),
+        this->_scratch.data(),
+        _maxPacketFrames,
+        0
+    );
+    if (frames < 0) throw std::runtime_error(std::string("OpusDecodeStage : ") + opus_strerror(frames));
+
+    // encoder delay
+    auto skipped = std::min(frames, this->_toSkip);
+    this->_toSkip -= skipped;
+
+    auto samples = static_cast<size_t>(frames - skipped) * this->_channels;
+    auto written = this->_ring.write(this->_scratch.data() + skipped * this->_channels, samples);
+    if (written < samples) spdlog::warn("OpusDecodeStage : Ring full, {} frames dropped", (samples - written) / this->_channels);
+}
+
+void AudioTube::OpusDecodeStage::resetDecoder(uint64_t seekPreRollNs) {
+    opus_decoder_ctl(this->_decoder, OPUS_RESET_STATE);
+
+    // decoder converges again during pre-roll
+    this->_toSkip = static_cast<int>(seekPreRollNs * SampleRate / 1000000000);
+}
+
+size_t AudioTube::OpusDecodeStage::pull(float* out, size_t frames) {
+    // whole frames only
+    auto samples = std::min(frames * this->_channels, this->_ring.readable() / this->_channels * this->_channels);
+    return this->_ring.read(out, samples) / this->_channels;
+}
+
+size_t AudioTube::OpusDecodeStage::bufferedFrames() const {
+    return this->_ring.readable() / this->_channels;
+}
@@ -0,0 +1,154 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "PageScanner.h"
+
+constexpr std::array<unsigned char, 256> AudioTube::PageScanner::_firstBytes() {
+    std::array<unsigned char, 256> table {};
+    table['<'] = PlayerSourcePath;
+    table['y'] = InitialPlayerResponse;
+    table['P'] = EmbedPlayerConfig;
+    table['s'] = SignatureTimestamp;
+    return table;
+}
+
+AudioTube::PageScanner::Anchors AudioTube::PageScanner::scan(const std::string_view &document, unsigned int wanted) {
+    static constexpr auto firstBytes = _firstBytes();
+
+    Anchors out;
+    auto missing = wanted & AllAnchors;
+    auto data = reinterpret_cast<const unsigned char*>(document.data());
+    auto size = document.size();
+
+    size_t pos = 0;
+    while (missing && pos < size) {
+        // most bytes cannot start any anchor
+        auto candidate = firstBytes[data[pos]] & missing;
+        if (!candidate) {
+            pos++;
+            continue;
+        }
+
+        auto next = std::string_view::npos;
+        switch (candidate) {
+            case PlayerSourcePath:
+                next = _scriptSrc(document, pos, &out.playerSourcePath);
+                break;
+            case InitialPlayerResponse:
+                next = _assignedObject(document, pos, "ytInitialPlayerResponse", '=', false, &out.initialPlayerResponse);
+                break;
+            case EmbedPlayerConfig:
+                next = _assignedObject(document, pos, "PLAYER_CONFIG", ':', true, &out.embedPlayerConfig);
+                break;
+            case SignatureTimestamp:
+                next = _timestamp(document, pos, &out.signatureTimestamp);
+                break;
+        }
+
+        if (!out.playerSourcePath.empty()) missing &= ~PlayerSourcePath;
+        if (!out.initialPlayerResponse.empty()) missing &= ~InitialPlayerResponse;
+        if (!out.embedPlayerConfig.empty()) missing &= ~EmbedPlayerConfig;
+        if (!out.signatureTimestamp.empty()) missing &= ~SignatureTimestamp;
+
+        // JSON objects are jumped over as a whole
+        pos = next == std::string_view::npos ? pos + 1 : next;
+    }
+
+    return out;
+}
+
+size_t AudioTube::PageScanner::closingBrace(const std::string_view &document, size_t opening) {
+    if (opening >= document.size() || document[opening] != '{') return std::string_view::npos;
+
+    size_t depth = 0;
+    auto inString = false;
+    for (auto i = opening; i < document.size(); i++) {
+        auto c = document[i];
+
+        if (inString) {
+            if (c == '\\') i++;
+            else if (c == '"') inString = false;
+            continue;
+        }
+
+        if (c == '"') inString = true;
+        else if (c == '{') depth++;
+        else if (c == '}' && !--depth) return i;
+    }
+
+    return std::string_view::npos;
+}
+
+size_t AudioTube::PageScanner::_scriptSrc(const std::string_view &document, size_t pos, std::string_view* found) {
+    if (document.compare(pos, 7, "<script") != 0) return std::string_view::npos;
+
+    auto tagEnd = document.find('>', pos);
+    if (tagEnd == std::string_view::npos) return std::string_view::npos;
+    auto tag = document.substr(pos, tagEnd - pos);
+
+    // other scripts are skipped, tag included
+    auto src = tag.find("src=\"");
+    if (src == std::string_view::npos) return tagEnd + 1;
+    auto srcEnd = tag.find('"', src + 5);
+    if (srcEnd == std::string_view::npos) return tagEnd + 1;
+
+    auto path = tag.substr(src + 5, srcEnd - src - 5);
+    if (path.find("player_ias") != std::string_view::npos) *found = path;
+
+    return tagEnd + 1;
+}
+
+size_t AudioTube::PageScanner::_assignedObject(const std::string_view &document, size_t pos, const std::string_view &name, char assignment, bool quoted, std::string_view* found) {
+    if (document.compare(pos, name.size(), name) != 0) return std::string_view::npos;
+
+    // eg. "PLAYER_CONFIG": or 'PLAYER_CONFIG':
+    auto after = pos + name.size();
+    if (quoted) {
+        if (!pos || after >= document.size()) return std::string_view::npos;
+        auto quote = document[pos - 1];
+        if ((quote != '"' && quote != '\'') || document[after] != quote) return std::string_view::npos;
+        after++;
+    }
+
+    after = _skipSpaces(document, after);
+    if (after >= document.size() || document[after] != assignment) return std::string_view::npos;
+
+    auto opening = _skipSpaces(document, after + 1);
+    auto closing = closingBrace(document, opening);
+    if (closing == std::string_view::npos) return std::string_view::npos;
+
+    *found = document.substr(opening, closing - opening + 1);
+    return closing + 1;
+}
+
+size_t AudioTube::PageScanner::_timestamp(const std::string_view &document, size_t pos, std::string_view* found) {
+    constexpr std::string_view name = "signatureTimestamp";
+    if (document.compare(pos, name.size(), name) != 0) return std::string_view::npos;
+
+    // eg. signatureTimestamp:18970 or signatureTimestamp=18970
+    auto begin = pos + name.size() + 1;
+    if (begin >= document.size() || (document[begin - 1] != ':' && document[begin - 1] != '=')) return std::string_view::npos;
+
+    auto end = begin;
+    while (end < document.size() && document[end] >= '0' && document[end] <= '9') end++;
+    if (end == begin) return std::string_view::npos;
+
+    *found = document.substr(begin, end - begin);
+    return end;
+}
+
+size_t AudioTube::PageScanner::_skipSpaces(const std::string_view &document, size_t pos) {
+    while (pos < document.size() && (document[pos] == ' ' || document[pos] == '\t' || document[pos] == '\n' || document[pos] == '\r')) pos++;
+    return pos;
+}
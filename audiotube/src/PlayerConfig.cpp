@@ -47,109 +47,60 @@ void AudioTube::PlayerConfig::fillFromVideoInfosDetails(const std::string &title
     this->_duration = duration;
 }
 
-promise::Promise AudioTube::PlayerConfig::from_EmbedPage(const PlayerConfig::VideoId &videoId) {
+promise::Promise AudioTube::PlayerConfig::from_EmbedPage(const PlayerConfig::VideoId &videoId, const Deadline &deadline) {
     spdlog::debug("PlayerConfig : Trying from [Embed]...");
     // pipeline
-    return _downloadRaw_VideoEmbedPageHtml(videoId)
+    return _downloadRaw_VideoEmbedPageHtml(videoId, deadline)
             .then([=](const DownloadedUtf8 &dl) {
                 PlayerConfig pConfig(PlayerConfig::ContextSource::EmbedPage, videoId);
-                return pConfig._fillFrom_VideoEmbedPageHtml(dl);
+                return pConfig._fillFrom_VideoEmbedPageHtml(dl, deadline);
             });
 }
 
-promise::Promise AudioTube::PlayerConfig::from_WatchPage(const PlayerConfig::VideoId &videoId, StreamsManifest* streamsManifest) {
+promise::Promise AudioTube::PlayerConfig::from_WatchPage(const PlayerConfig::VideoId &videoId, StreamsManifest* streamsManifest, const Deadline &deadline) {
     spdlog::debug("PlayerConfig : Trying from [WatchPage]...");
-    // define requested at timestamp
-    auto now = std::chrono::system_clock::to_time_t(
-        std::chrono::system_clock::now()
-    );
-    streamsManifest->setRequestedAt(now);
 
     // pipeline
-    return _downloadRaw_WatchPageHtml(videoId)
+    return _downloadRaw_WatchPageHtml(videoId, deadline)
             .then([=](const DownloadedUtf8 &dl) {
                 PlayerConfig pConfig(PlayerConfig::ContextSource::WatchPage, videoId);
-                return pConfig._fillFrom_WatchPageHtml(dl, streamsManifest);
+                return pConfig._fillFrom_WatchPageHtml(dl, streamsManifest, deadline);
             });
 }
 
-promise::Promise AudioTube::PlayerConfig::_downloadRaw_VideoEmbedPageHtml(const PlayerConfig::VideoId &videoId) {
+promise::Promise AudioTube::PlayerConfig::_downloadRaw_VideoEmbedPageHtml(const PlayerConfig::VideoId &videoId, const Deadline &deadline) {
     auto url = std::string("https://www.youtube.com/embed/" + videoId + "?hl=en");
-    return promise_dl_HTTPS(url);
+    return promise_dl_HTTPS(url, false, deadline);
 }
 
-promise::Promise AudioTube::PlayerConfig::_downloadRaw_WatchPageHtml(const PlayerConfig::VideoId &videoId) {
+promise::Promise AudioTube::PlayerConfig::_downloadRaw_WatchPageHtml(const PlayerConfig::VideoId &videoId, const Deadline &deadline) {
     auto url = std::string("https://www.youtube.com/watch?v=" + videoId + "&bpctr=9999999999&hl=en");
-    return promise_dl_HTTPS(url);
+    return promise_dl_HTTPS(url, false, deadline);
 }
 
 
-nlohmann::json AudioTube::PlayerConfig::_extractPlayerConfigFromRawSource(const DownloadedUtf8 &rawSource, const jp::Regex &regexToJSONStart) {
-    // search
-    jp::VecNum matches;
-    jp::RegexMatch rm;
-    rm.setRegexObject(&regexToJSONStart)
-        .setSubject(&rawSource)
-        .addModifier("gm")
-        .setNumberedSubstringVector(&matches)
-        .match();
-
-    // check if first part is there
-    if (matches.size() != 1)
+AudioTube::PlayerResponse AudioTube::PlayerConfig::_extractPlayerResponse(const PageScanner::Anchors &anchors) {
+    if (anchors.initialPlayerResponse.empty())
         throw std::logic_error("Failed to extract Player Configuration from raw source");
-    auto firstPart = matches[0][1];
-
-    // get the first result of the rest
-    rm.setRegexObject(&Regexes::BalancedBraces)
-        .setSubject(&firstPart)
-        .match();
-
-    // get player config as string
-    auto &playerConfigAsStr = matches[0][0];
-    if (playerConfigAsStr.empty()) {
-        throw std::logic_error("Player response is missing !");
-    }
-
-    // try to parse
-    auto playerConfig = nlohmann::json::parse(playerConfigAsStr);
-    if (playerConfig.is_null()) {
-        throw std::logic_error("Cannot parse to JSON the Player Configuration !");
-    }
-
-    return playerConfig;
+
+    // try to parse, only keeping what is needed
+    return PlayerResponseParser::parse(anchors.initialPlayerResponse);
 }
 
 std::string AudioTube::PlayerConfig::_playerSourceUrl(const nlohmann::json &playerConfig) {
-    auto playerSourceUrlPath = playerConfig["assets"]["js"].get<std::string>();
+    auto playerSourceUrlPath = playerConfig.at("assets").at("js").get<std::string>();
     if (playerSourceUrlPath.empty()) throw std::logic_error("Player source URL is cannot be found !");
     return std::string("https://www.youtube.com") + playerSourceUrlPath;
 }
 
-std::string AudioTube::PlayerConfig::_extractPlayerSourceURLFromRawSource(const DownloadedUtf8 &rawSource) {
-    // search for <script> tags
-    jp::VecNum matches;
-    
-    jp::RegexMatch rm;
-    rm.setRegexObject(&Regexes::FindScriptSrc)
-        .setSubject(&rawSource)
-        .addModifier("gm")
-        .setNumberedSubstringVector(&matches)
-        .match();
-
-    for(auto &src : matches) {
-        // check if contains keyword
-        auto &grpMatch = src[1];
-        if(grpMatch.find("player_ias") == std::string::npos) continue;
-
-        // returns
-        return std::string("https://www.youtube.com") + grpMatch;
-    }
-
-    // if not found in regex
-    throw std::logic_error("Failed to extract PlayerSourceURL from raw source");
+std::string AudioTube::PlayerConfig::_extractPlayerSourceURL(const PageScanner::Anchors &anchors) {
+    if (anchors.playerSourcePath.empty())
+        throw std::logic_error("Failed to extract PlayerSourceURL from raw source");
+
+    return std::string("https://www.youtube.com") + std::string(anchors.playerSourcePath);
 }
 
-promise::Promise AudioTube::PlayerConfig::_downloadAndfillFrom_PlayerSource(const std::string &playerSourceUrl) {
+promise::Promise AudioTube::PlayerConfig::_downloadAndfillFrom_PlayerSource(const std::string &playerSourceUrl, const Deadline &deadline) {
     return promise::newPromise([=](promise::Defer d){
         // if cached is found, return it
         auto cachedDecipherer = SignatureDecipherer::fromCache(playerSourceUrl);
@@ -164,7 +115,7 @@ promise::Promise AudioTube::PlayerConfig::_downloadAndfillFrom_PlayerSource(cons
     .then([=](bool cachedDecipherer, bool stsNeeded) {
         // if no cached decipherer or if STS is needed
         if (!cachedDecipherer || stsNeeded) {
-            return promise_dl_HTTPS(playerSourceUrl)
+            return promise_dl_HTTPS(playerSourceUrl, false, deadline)
             .then([=](const DownloadedUtf8 &dl) {
                 // generate decipherer
                 if (!cachedDecipherer) {
@@ -185,48 +136,48 @@ promise::Promise AudioTube::PlayerConfig::_downloadAndfillFrom_PlayerSource(cons
     });
 }
 
-promise::Promise AudioTube::PlayerConfig::_fillFrom_VideoEmbedPageHtml(const DownloadedUtf8 &dl) {
+promise::Promise AudioTube::PlayerConfig::_fillFrom_VideoEmbedPageHtml(const DownloadedUtf8 &dl, const Deadline &deadline) {
     std::string playerSourceURL;
     return promise::newPromise([&playerSourceURL, dl](promise::Defer d) {
-        playerSourceURL = _extractPlayerSourceURLFromRawSource(dl);
+        playerSourceURL = _extractPlayerSourceURL(PageScanner::scan(dl, PageScanner::PlayerSourcePath));
         d.resolve();
     })
-    .then(this->_downloadAndfillFrom_PlayerSource(playerSourceURL))
+    .then(this->_downloadAndfillFrom_PlayerSource(playerSourceURL, deadline))
     .then([=]() {
         return *this;
     });
 }
 
-promise::Promise AudioTube::PlayerConfig::_fillFrom_WatchPageHtml(const DownloadedUtf8 &dl, StreamsManifest* streamsManifest) {
+promise::Promise AudioTube::PlayerConfig::_fillFrom_WatchPageHtml(const DownloadedUtf8 &dl, StreamsManifest* streamsManifest, const Deadline &deadline) {
     return promise::newPromise([=](promise::Defer d) {
+        // find player response and player source at once
+        auto anchors = PageScanner::scan(dl, PageScanner::InitialPlayerResponse | PageScanner::PlayerSourcePath);
+
         // get player config JSON
-        auto playerConfig = _extractPlayerConfigFromRawSource(dl, Regexes::PlayerConfigExtractorFromWatchPage_JSONStart);
+        auto playerConfig = _extractPlayerResponse(anchors);
 
         // fetch and check video infos
-        auto videoDetails = playerConfig["videoDetails"];
-            this->_title = videoDetails["title"].get<std::string>();
-            this->_duration = safe_stoi(videoDetails["lengthSeconds"].get<std::string>());
-            auto isLive = videoDetails["isLiveContent"].get<bool>();
+        if (!playerConfig.hasVideoDetails) throw std::logic_error("Video details cannot be found !");
+            this->_title = playerConfig.title;
+            this->_duration = safe_stoi(playerConfig.lengthSeconds);
+            auto isLive = playerConfig.isLiveContent;
 
-        if (isLive) throw std::logic_error("Live streams are not handled for now!");
+        if (isLive) throw UnavailableVideoError(UnavailableVideoError::LiveContent, "Live streams are not handled for now!");
         if (this->_title.empty()) throw std::logic_error("Video title cannot be found !");
         if (!this->_duration) throw std::logic_error("Video length cannot be found !");
 
         // check playability status, throw err
-        auto playabilityStatus = playerConfig["playabilityStatus"];
-        auto pReason = playabilityStatus["reason"];
-        if (!pReason.is_null()) {
-            throw std::logic_error("This video is not available though WatchPage : " + pReason.get<std::string>());
+        if (playerConfig.playabilityReason) {
+            throw UnavailableVideoError(UnavailableVideoError::Unplayable, "This video is not available though WatchPage : " + *playerConfig.playabilityReason);
         }
 
         // get streamingData
-        auto streamingData = playerConfig["streamingData"];
-        if (streamingData.is_null()) {
+        if (!playerConfig.hasStreamingData) {
             throw std::logic_error("An error occured while fetching video infos");
         }
 
         // find expiration
-        auto expiresIn = streamingData["expiresInSeconds"].get<std::string>();
+        const auto &expiresIn = playerConfig.expiresInSeconds;
         if (expiresIn.empty()) {
             throw std::logic_error("An error occured while fetching video infos");
         }
@@ -239,29 +190,24 @@ promise::Promise AudioTube::PlayerConfig::_fillFrom_WatchPageHtml(const Download
         streamsManifest->setSecondsUntilExpiration((unsigned int)ei_cast);
 
         // raw stream infos
-        auto raw_playerResponseStreams = streamingData["adaptiveFormats"];
-        streamsManifest->feedRaw_PlayerResponse(raw_playerResponseStreams, this->_decipherer);
+        streamsManifest->feedRaw_PlayerResponse(playerConfig.audioFormats, this->_decipherer);
 
         // DASH manifest handling
-        std::string dashManifestUrl;
-        auto dmu = streamingData["dashManifestUrl"];
-        if(!dmu.is_null()) dashManifestUrl = dmu.get<std::string>();
+        const auto &dashManifestUrl = playerConfig.dashManifestUrl;
 
         // Extract player source URL
-        auto playerSourceUrl = _extractPlayerSourceURLFromRawSource(dl);
+        auto playerSourceUrl = _extractPlayerSourceURL(anchors);
 
         d.resolve(playerSourceUrl, dashManifestUrl);
     })
     .then([=](const std::string &playerSourceUrl, const std::string &dashManifestUrl){
-        return this->_downloadAndfillFrom_PlayerSource(playerSourceUrl)
+        return this->_downloadAndfillFrom_PlayerSource(playerSourceUrl, deadline)
         .then([=](){
             return dashManifestUrl;
         });
     })
     .then([=](const std::string &dashManifestUrl){
-       auto mayFetchRawDASH = dashManifestUrl.empty() ? promise::resolve() : promise_dl_HTTPS(dashManifestUrl).then([=](const DownloadedUtf8 &dl) {
-            streamsManifest->feedRaw_DASH(dl, this->_decipherer);
-        });
+       auto mayFetchRawDASH = dashManifestUrl.empty() ? promise::resolve() : streamsManifest->promise_feedDASH(dashManifestUrl, this->_decipherer, deadline);
         return mayFetchRawDASH;
     })
     .then([=]() {
@@ -270,18 +216,12 @@ promise::Promise AudioTube::PlayerConfig::_fillFrom_WatchPageHtml(const Download
 }
 
 std::string AudioTube::PlayerConfig::_getSts(const DownloadedUtf8 &dl) {
-    jp::VecNum matches;
-    jp::RegexMatch rm;
-    rm.setRegexObject(&Regexes::STSFinder)
-        .setSubject(&dl)
-        .addModifier("gm")
-        .setNumberedSubstringVector(&matches)
-        .match();
+    auto anchors = PageScanner::scan(dl, PageScanner::SignatureTimestamp);
 
     // check if has STS
-    if (!matches.size())
+    if (anchors.signatureTimestamp.empty())
         throw std::logic_error("STS value cannot be found !");
 
     // returns first one
-    return matches[0][0];
+    return std::string(anchors.signatureTimestamp);
 }
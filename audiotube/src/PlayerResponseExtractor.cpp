@@ -0,0 +1,190 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include <vector>
+#include <stdexcept>
+
+#include "PlayerResponseExtractor.h"
+
+class AudioTube::PlayerResponseExtractor::_Handler {
+ public:
+    explicit _Handler(const Schema &schema) : _schema(schema) {}
+
+    nlohmann::json& result() {
+        return this->_root;
+    }
+
+    // scalars
+    bool null() { return this->_addScalar(nullptr); }
+    bool boolean(bool value) { return this->_addScalar(value); }
+    bool number_integer(nlohmann::json::number_integer_t value) { return this->_addScalar(value); }
+    bool number_unsigned(nlohmann::json::number_unsigned_t value) { return this->_addScalar(value); }
+    bool number_float(nlohmann::json::number_float_t value, const nlohmann::json::string_t&) { return this->_addScalar(value); }
+    bool string(nlohmann::json::string_t &value) {
+        if (this->_skipDepth || !this->_schemaOfNext()) return true;
+        return this->_addScalar(std::move(value));
+    }
+    bool binary(nlohmann::json::binary_t&) { return true; }
+
+    // containers
+    bool start_object(std::size_t) { return this->_startContainer(nlohmann::json::object()); }
+    bool start_array(std::size_t) { return this->_startContainer(nlohmann::json::array()); }
+    bool end_object() { return this->_endContainer(); }
+    bool end_array() { return this->_endContainer(); }
+
+    bool key(nlohmann::json::string_t &key) {
+        if (!this->_skipDepth) this->_key = std::move(key);
+        return true;
+    }
+
+    bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception &e) {
+        throw std::logic_error("PlayerResponseExtractor : Malformed JSON at byte " + std::to_string(position) + " : " + e.what());
+    }
+
+ private:
+    struct _Frame {
+        nlohmann::json* value;
+        const Schema* schema;
+    };
+
+    const Schema &_schema;
+    Schema _whole { true };
+
+    nlohmann::json _root;
+    std::vector<_Frame> _frames;
+    std::string _key;
+    unsigned int _skipDepth = 0;
+
+    // nullptr if next value is to be skipped
+    const Schema* _schemaOfNext() const {
+        if (this->_frames.empty()) return &this->_schema;
+
+        const auto &frame = this->_frames.back();
+        if (frame.schema->whole) return &this->_whole;
+        if (frame.value->is_array()) return frame.schema;
+
+        auto found = frame.schema->fields.find(this->_key);
+        return found == frame.schema->fields.end() ? nullptr : &found->second;
+    }
+
+    nlohmann::json* _insert(nlohmann::json value) {
+        auto parent = this->_frames.back().value;
+        if (parent->is_array()) {
+            parent->push_back(std::move(value));
+            return &parent->back();
+        }
+
+        auto &slot = (*parent)[this->_key];
+        slot = std::move(value);
+        return &slot;
+    }
+
+    // once a value is complete, drop it if its array does not want it
+    void _filterLast() {
+        if (this->_frames.empty()) return;
+
+        const auto &parent = this->_frames.back();
+        if (!parent.value->is_array() || !parent.schema->itemFilter) return;
+        if (!parent.schema->itemFilter(parent.value->back())) parent.value->erase(parent.value->size() - 1);
+    }
+
+    bool _addScalar(nlohmann::json value) {
+        if (this->_skipDepth || this->_frames.empty() || !this->_schemaOfNext()) return true;
+
+        this->_insert(std::move(value));
+        this->_filterLast();
+        return true;
+    }
+
+    bool _startContainer(nlohmann::json value) {
+        if (this->_skipDepth) {
+            this->_skipDepth++;
+            return true;
+        }
+
+        auto schema = this->_schemaOfNext();
+        if (!schema) {
+            this->_skipDepth = 1;
+            return true;
+        }
+
+        if (this->_frames.empty()) {
+            this->_root = std::move(value);
+            this->_frames.push_back({ &this->_root, schema });
+            return true;
+        }
+
+        auto inserted = this->_insert(std::move(value));
+        this->_frames.push_back({ inserted, schema });
+        return true;
+    }
+
+    bool _endContainer() {
+        if (this->_skipDepth) {
+            this->_skipDepth--;
+            return true;
+        }
+
+        this->_frames.pop_back();
+        this->_filterLast();
+        return true;
+    }
+};
+
+const AudioTube::PlayerResponseExtractor::Schema& AudioTube::PlayerResponseExtractor::playerResponseSchema() {
+    static const Schema schema = []() {
+        Schema whole;
+        whole.whole = true;
+
+        // only audio formats
+        Schema audioFormats;
+        audioFormats.whole = true;
+        audioFormats.itemFilter = [](const nlohmann::json &format) {
+            if (!format.is_object()) return false;
+            auto mimeType = format.find("mimeType");
+            return mimeType != format.end() && mimeType->is_string() && mimeType->get_ref<const std::string&>().rfind("audio/", 0) == 0;
+        };
+
+        Schema streamingData;
+        streamingData.fields = {
+            { "expiresInSeconds", whole },
+            { "dashManifestUrl", whole },
+            { "adaptiveFormats", audioFormats }
+        };
+
+        Schema out;
+        out.fields = {
+            { "videoDetails", whole },
+            { "playabilityStatus", whole },
+            { "streamingData", streamingData }
+        };
+        return out;
+    }();
+
+    return schema;
+}
+
+nlohmann::json AudioTube::PlayerResponseExtractor::extract(const std::string_view &json, const Schema &schema) {
+    _Handler handler(schema);
+    nlohmann::json::sax_parse(json.data(), json.data() + json.size(), &handler);
+    return std::move(handler.result());
+}
+
+const nlohmann::json& AudioTube::PlayerResponseExtractor::field(const nlohmann::json &object, const std::string &key) {
+    static const nlohmann::json null;
+    if (!object.is_object()) return null;
+
+    auto found = object.find(key);
+    return found == object.end() ? null : *found;
+}
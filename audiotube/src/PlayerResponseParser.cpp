@@ -0,0 +1,264 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "PlayerResponse.h"
+
+#include <charconv>
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef AUDIOTUBE_WITH_SIMDJSON
+    #include <simdjson.h>
+#endif
+
+#include "PlayerResponseExtractor.h"
+
+AudioTube::PlayerResponseParser::Backend AudioTube::PlayerResponseParser::defaultBackend() {
+    #ifdef AUDIOTUBE_WITH_SIMDJSON
+        return Backend::Simdjson;
+    #else
+        return Backend::Nlohmann;
+    #endif
+}
+
+bool AudioTube::PlayerResponseParser::isAvailable(Backend backend) {
+    #ifdef AUDIOTUBE_WITH_SIMDJSON
+        return true;
+    #else
+        return backend == Backend::Nlohmann;
+    #endif
+}
+
+AudioTube::PlayerResponse AudioTube::PlayerResponseParser::parse(const std::string_view &json, Backend backend) {
+    if (!isAvailable(backend)) throw std::logic_error("PlayerResponseParser : Backend has not been built in !");
+    return backend == Backend::Simdjson ? _parseWithSimdjson(json) : _parseWithNlohmann(json);
+}
+
+AudioTube::PlayerResponse AudioTube::PlayerResponseParser::_parseWithNlohmann(const std::string_view &json) {
+    PlayerResponse out;
+
+    // values of unexpected types are left empty
+    auto stringOf = [](const nlohmann::json &value) {
+        return value.is_string() ? value.get<std::string>() : std::string();
+    };
+    auto numberOf = [](const nlohmann::json &value) -> uint64_t {
+        if (value.is_number_unsigned()) return value.get<uint64_t>();
+        if (value.is_number()) return static_cast<uint64_t>(std::max(0.0, value.get<double>()));
+        if (!value.is_string()) return 0;
+
+        // given as strings
+        return _numberFrom(std::string_view(value.get_ref<const std::string&>()));
+    };
+    auto byteRangeOf = [&numberOf](const nlohmann::json &range) -> std::optional<NetworkHelper::ByteRange> {
+        if (!range.is_object() || !range.contains("start") || !range.contains("end")) return std::nullopt;
+
+        NetworkHelper::ByteRange out;
+        out.first = numberOf(range["start"]);
+        out.last = numberOf(range["end"]);
+        if (out.last < out.first) return std::nullopt;
+        return out;
+    };
+    auto formatOf = [&](const nlohmann::json &format) {
+        PlayerResponse::Format out;
+        if (!format.is_object()) return out;
+
+        out.itag = static_cast<int>(numberOf(PlayerResponseExtractor::field(format, "itag")));
+        out.mimeType = stringOf(PlayerResponseExtractor::field(format, "mimeType"));
+        out.bitrate = numberOf(PlayerResponseExtractor::field(format, "bitrate"));
+        out.url = stringOf(PlayerResponseExtractor::field(format, "url"));
+
+        out.cipher = stringOf(PlayerResponseExtractor::field(format, "cipher"));
+        if (out.cipher.empty()) out.cipher = stringOf(PlayerResponseExtractor::field(format, "signatureCipher"));
+
+        // sizes, given as strings
+        out.contentLength = numberOf(PlayerResponseExtractor::field(format, "contentLength"));
+        out.approxDurationMs = numberOf(PlayerResponseExtractor::field(format, "approxDurationMs"));
+        out.audioSampleRate = static_cast<unsigned int>(numberOf(PlayerResponseExtractor::field(format, "audioSampleRate")));
+
+        out.initRange = byteRangeOf(PlayerResponseExtractor::field(format, "initRange"));
+        out.indexRange = byteRangeOf(PlayerResponseExtractor::field(format, "indexRange"));
+
+        return out;
+    };
+
+    // only what the schema describes is built
+    auto extracted = PlayerResponseExtractor::extract(json);
+
+    const auto &videoDetails = PlayerResponseExtractor::field(extracted, "videoDetails");
+    out.hasVideoDetails = videoDetails.is_object();
+    out.title = stringOf(PlayerResponseExtractor::field(videoDetails, "title"));
+    out.lengthSeconds = stringOf(PlayerResponseExtractor::field(videoDetails, "lengthSeconds"));
+    const auto &isLive = PlayerResponseExtractor::field(videoDetails, "isLiveContent");
+    out.isLiveContent = isLive.is_boolean() && isLive.get<bool>();
+
+    const auto &playabilityStatus = PlayerResponseExtractor::field(extracted, "playabilityStatus");
+    out.playabilityStatus = stringOf(PlayerResponseExtractor::field(playabilityStatus, "status"));
+    const auto &reason = PlayerResponseExtractor::field(playabilityStatus, "reason");
+    if (reason.is_string()) out.playabilityReason = reason.get<std::string>();
+
+    const auto &streamingData = PlayerResponseExtractor::field(extracted, "streamingData");
+    out.hasStreamingData = streamingData.is_object();
+    out.expiresInSeconds = stringOf(PlayerResponseExtractor::field(streamingData, "expiresInSeconds"));
+    out.dashManifestUrl = stringOf(PlayerResponseExtractor::field(streamingData, "dashManifestUrl"));
+
+    // already filtered to audio by the schema
+    const auto &adaptiveFormats = PlayerResponseExtractor::field(streamingData, "adaptiveFormats");
+    if (adaptiveFormats.is_array()) {
+        for (const auto &format : adaptiveFormats) {
+            out.audioFormats.push_back(formatOf(format));
+        }
+    }
+
+    return out;
+}
+
+AudioTube::PlayerResponse AudioTube::PlayerResponseParser::_parseWithSimdjson(const std::string_view &json) {
+#ifdef AUDIOTUBE_WITH_SIMDJSON
+    PlayerResponse out;
+
+    // on-demand reads past the end of input, hence a padded copy; the parser keeps its buffers between calls
+    simdjson::padded_string padded(json);
+    static thread_local simdjson::ondemand::parser parser;
+
+    // values of unexpected types are left empty, as with nlohmann
+    auto stringOf = [](simdjson::ondemand::value value) {
+        std::string_view text;
+        return value.get_string().get(text) ? std::string() : std::string(text);
+    };
+    auto numberOf = [](simdjson::ondemand::value value) -> uint64_t {
+        uint64_t number = 0;
+        if (!value.get_uint64().get(number)) return number;
+
+        double real = 0;
+        if (!value.get_double().get(real)) return static_cast<uint64_t>(std::max(0.0, real));
+
+        // given as strings
+        std::string_view text;
+        if (value.get_string().get(text)) return 0;
+        return _numberFrom(text);
+    };
+    auto byteRangeOf = [&numberOf](simdjson::ondemand::value value) -> std::optional<NetworkHelper::ByteRange> {
+        simdjson::ondemand::object range;
+        if (value.get_object().get(range)) return std::nullopt;
+
+        std::optional<uint64_t> start, end;
+        for (auto field : range) {
+            std::string_view key = field.unescaped_key();
+            if (key == "start") start = numberOf(field.value());
+            else if (key == "end") end = numberOf(field.value());
+        }
+
+        if (!start || !end || *end < *start) return std::nullopt;
+        return NetworkHelper::ByteRange { *start, *end };
+    };
+
+    try {
+        auto document = parser.iterate(padded);
+
+        // fields are visited in document order, anything not read is skipped
+        for (auto field : document.get_object()) {
+            std::string_view key = field.unescaped_key();
+
+            if (key == "videoDetails") {
+                simdjson::ondemand::object videoDetails;
+                if (field.value().get_object().get(videoDetails)) continue;
+                out.hasVideoDetails = true;
+
+                for (auto detail : videoDetails) {
+                    std::string_view detailKey = detail.unescaped_key();
+                    if (detailKey == "title") out.title = stringOf(detail.value());
+                    else if (detailKey == "lengthSeconds") out.lengthSeconds = stringOf(detail.value());
+                    else if (detailKey == "isLiveContent") {
+                        bool isLive = false;
+                        out.isLiveContent = !detail.value().get_bool().get(isLive) && isLive;
+                    }
+                }
+            } else if (key == "playabilityStatus") {
+                simdjson::ondemand::object playabilityStatus;
+                if (field.value().get_object().get(playabilityStatus)) continue;
+
+                for (auto status : playabilityStatus) {
+                    std::string_view statusKey = status.unescaped_key();
+                    if (statusKey == "status") {
+                        out.playabilityStatus = stringOf(status.value());
+                    } else if (statusKey == "reason") {
+                        std::string_view reason;
+                        if (!status.value().get_string().get(reason)) out.playabilityReason = std::string(reason);
+                    }
+                }
+            } else if (key == "streamingData") {
+                simdjson::ondemand::object streamingData;
+                if (field.value().get_object().get(streamingData)) continue;
+                out.hasStreamingData = true;
+
+                for (auto data : streamingData) {
+                    std::string_view dataKey = data.unescaped_key();
+                    if (dataKey == "expiresInSeconds") {
+                        out.expiresInSeconds = stringOf(data.value());
+                    } else if (dataKey == "dashManifestUrl") {
+                        out.dashManifestUrl = stringOf(data.value());
+                    } else if (dataKey == "adaptiveFormats") {
+                        simdjson::ondemand::array adaptiveFormats;
+                        if (data.value().get_array().get(adaptiveFormats)) continue;
+
+                        for (auto item : adaptiveFormats) {
+                            simdjson::ondemand::object entry;
+                            if (item.get_object().get(entry)) continue;
+
+                            PlayerResponse::Format format;
+                            std::string signatureCipher;
+                            for (auto property : entry) {
+                                std::string_view name = property.unescaped_key();
+                                if (name == "itag") format.itag = static_cast<int>(numberOf(property.value()));
+                                else if (name == "mimeType") format.mimeType = stringOf(property.value());
+                                else if (name == "bitrate") format.bitrate = numberOf(property.value());
+                                else if (name == "url") format.url = stringOf(property.value());
+                                else if (name == "cipher") format.cipher = stringOf(property.value());
+                                else if (name == "signatureCipher") signatureCipher = stringOf(property.value());
+                                else if (name == "contentLength") format.contentLength = numberOf(property.value());
+                                else if (name == "approxDurationMs") format.approxDurationMs = numberOf(property.value());
+                                else if (name == "audioSampleRate") format.audioSampleRate = static_cast<unsigned int>(numberOf(property.value()));
+                                else if (name == "initRange") format.initRange = byteRangeOf(property.value());
+                                else if (name == "indexRange") format.indexRange = byteRangeOf(property.value());
+                            }
+
+                            // "cipher" wins over "signatureCipher" whatever their order, as with nlohmann
+                            if (format.cipher.empty()) format.cipher = std::move(signatureCipher);
+
+                            // mimeType may come after the heavier fields, so filtered once the entry is read
+                            if (_isAudio(format.mimeType)) out.audioFormats.push_back(std::move(format));
+                        }
+                    }
+                }
+            }
+        }
+    } catch (const simdjson::simdjson_error &e) {
+        throw std::logic_error(std::string("PlayerResponseParser : Malformed JSON : ") + e.what());
+    }
+
+    return out;
+#else
+    throw std::logic_error("PlayerResponseParser : Built without simdjson !");
+#endif
+}
+
+bool AudioTube::PlayerResponseParser::_isAudio(const std::string_view &mimeType) {
+    return mimeType.substr(0, 6) == "audio/";
+}
+
+uint64_t AudioTube::PlayerResponseParser::_numberFrom(const std::string_view &value) {
+    uint64_t out = 0;
+    auto result = std::from_chars(value.data(), value.data() + value.size(), out);
+    return result.ec == std::errc() ? out : 0;
+}
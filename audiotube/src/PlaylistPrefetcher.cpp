@@ -0,0 +1,180 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+#include "PlaylistPrefetcher.h"
+#include "NetworkFetcher.h"
+
+AudioTube::PlaylistPrefetcher::PlaylistPrefetcher() : PlaylistPrefetcher(Settings()) {}
+
+AudioTube::PlaylistPrefetcher::PlaylistPrefetcher(const Settings &settings) : _settings(settings) {
+    this->_worker = std::thread(&PlaylistPrefetcher::_run, this);
+}
+
+AudioTube::PlaylistPrefetcher::~PlaylistPrefetcher() {
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_stopRequested = true;
+    }
+    this->_changed.notify_all();
+
+    if (this->_worker.joinable()) this->_worker.join();
+}
+
+void AudioTube::PlaylistPrefetcher::setPlaylist(const std::vector<VideoMetadata*> &playlist) {
+    // worker stops after the track being warmed
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_dirty = true;
+    }
+    this->_changed.notify_all();
+
+    std::lock_guard<std::mutex> work(this->_workMutex);
+
+    // release previous playlist before caller may delete it
+    this->_releaseOutOf({}, this->_currentMetadata());
+
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_playlist = playlist;
+        this->_current = 0;
+        this->_dirty = true;
+    }
+    this->_changed.notify_all();
+}
+
+void AudioTube::PlaylistPrefetcher::setCurrent(size_t index) {
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_current = index;
+        this->_dirty = true;
+    }
+    this->_changed.notify_all();
+}
+
+size_t AudioTube::PlaylistPrefetcher::effectiveLookAhead() const {
+    if (!this->_settings.bytesPerTrack) return this->_settings.lookAhead;
+    return std::min(this->_settings.lookAhead, this->_settings.memoryBudget / this->_settings.bytesPerTrack);
+}
+
+AudioTube::VideoMetadata* AudioTube::PlaylistPrefetcher::_currentMetadata() {
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    return this->_current < this->_playlist.size() ? this->_playlist[this->_current] : nullptr;
+}
+
+bool AudioTube::PlaylistPrefetcher::_interrupted() const {
+    return this->_stopRequested || this->_dirty;
+}
+
+std::vector<AudioTube::VideoMetadata*> AudioTube::PlaylistPrefetcher::_window() {
+    std::vector<VideoMetadata*> window;
+
+    for (auto i = this->_current + 1; i <= this->_current + this->effectiveLookAhead() && i < this->_playlist.size(); i++) {
+        window.push_back(this->_playlist[i]);
+    }
+
+    return window;
+}
+
+void AudioTube::PlaylistPrefetcher::_releaseOutOf(const std::vector<VideoMetadata*> &window, VideoMetadata* current) {
+    for (auto it = this->_warmed.begin(); it != this->_warmed.end();) {
+        auto metadata = *it;
+        auto inWindow = std::find(window.begin(), window.end(), metadata) != window.end();
+        if (inWindow) {
+            it++;
+            continue;
+        }
+
+        // current one now belongs to consumer
+        if (metadata != current) metadata->prefetch()->stop();
+        it = this->_warmed.erase(it);
+    }
+}
+
+bool AudioTube::PlaylistPrefetcher::_waitForegroundIdle() {
+    std::unique_lock<std::mutex> lock(this->_mutex);
+
+    while (NetworkFetcher::pendingRefreshes()) {
+        if (this->_interrupted()) return false;
+        this->_changed.wait_for(lock, this->_settings.yieldInterval);
+    }
+
+    return !this->_interrupted();
+}
+
+void AudioTube::PlaylistPrefetcher::_warm(VideoMetadata* metadata, size_t* budgetLeft) {
+    // resolve, if never done or expired
+    NetworkFetcher::refreshMetadataInBackground(metadata);
+    if (!metadata->ranOnce() || metadata->hasFailed()) return;
+
+    // already warm, possibly from NetworkFetcher itself with its own size
+    auto prefetch = metadata->prefetch();
+    if (prefetch->isStarted() && prefetch->capacity() > *budgetLeft) {
+        spdlog::debug("PlaylistPrefetcher : Prefetch of [{}] exceeds budget, shrinking it...", metadata->id());
+        prefetch->stop();
+    }
+
+    if (!prefetch->isStarted()) {
+        if (this->_settings.bytesPerTrack > *budgetLeft) return;
+
+        spdlog::debug("PlaylistPrefetcher : Warming [{}]...", metadata->id());
+        prefetch->start(metadata->audioStreams()->preferedUrl(), this->_settings.bytesPerTrack);
+    }
+
+    *budgetLeft -= std::min(*budgetLeft, prefetch->capacity());
+    this->_warmed.insert(metadata);
+}
+
+void AudioTube::PlaylistPrefetcher::_run() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(this->_mutex);
+            this->_changed.wait_for(lock, this->_settings.recheckInterval, [this]() { return this->_interrupted(); });
+            if (this->_stopRequested) break;
+        }
+
+        // playlist cannot be replaced during a pass
+        std::lock_guard<std::mutex> work(this->_workMutex);
+
+        std::vector<VideoMetadata*> window;
+        VideoMetadata* current = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(this->_mutex);
+            this->_dirty = false;
+            window = this->_window();
+            if (this->_current < this->_playlist.size()) current = this->_playlist[this->_current];
+        }
+
+        this->_releaseOutOf(window, current);
+
+        // nearest first, every started buffer counting against budget
+        auto budgetLeft = this->_settings.memoryBudget;
+        for (auto metadata : window) {
+            if (!this->_waitForegroundIdle()) break;
+
+            try {
+                this->_warm(metadata, &budgetLeft);
+            } catch(const std::exception &e) {
+                spdlog::debug("PlaylistPrefetcher : Cannot warm [{}] : {}", metadata->id(), e.what());
+            }
+        }
+    }
+
+    // release everything but current
+    std::lock_guard<std::mutex> work(this->_workMutex);
+    this->_releaseOutOf({}, this->_currentMetadata());
+}
@@ -0,0 +1,228 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+#include "PrefetchBuffer.h"
+
+AudioTube::PrefetchBuffer::PrefetchBuffer() {}
+
+AudioTube::PrefetchBuffer::~PrefetchBuffer() {
+    this->stop();
+}
+
+void AudioTube::PrefetchBuffer::start(const std::string &url, size_t capacity, const Deadline::Timeouts &timeouts) {
+    this->stop();
+
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    this->_url = url;
+    this->_ring.assign(std::max<size_t>(1, capacity), 0);
+    this->_started = true;
+    this->_reading = true;
+
+    this->_worker = std::thread(&PrefetchBuffer::_run, this, timeouts, this->_cancellation.token());
+}
+
+void AudioTube::PrefetchBuffer::stop() {
+    // aborts pending I/O, closing the connection
+    this->_cancellation.cancel();
+    this->_join();
+
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    this->_url.clear();
+    this->_ring.clear();
+    this->_readPos = 0;
+    this->_size = 0;
+    this->_consumed = 0;
+    this->_connection.reset();
+    this->_started = false;
+    this->_stopRequested = false;
+    this->_finished = false;
+    this->_reading = false;
+    this->_error.clear();
+}
+
+void AudioTube::PrefetchBuffer::_join() {
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_stopRequested = true;
+    }
+    this->_changed.notify_all();
+
+    if (this->_worker.joinable()) this->_worker.join();
+}
+
+bool AudioTube::PrefetchBuffer::isStarted() {
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    return this->_started;
+}
+
+size_t AudioTube::PrefetchBuffer::buffered() {
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    return this->_size;
+}
+
+size_t AudioTube::PrefetchBuffer::capacity() {
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    return this->_started ? this->_ring.size() : 0;
+}
+
+void AudioTube::PrefetchBuffer::_run(const Deadline::Timeouts &timeouts, const CancellationToken &token) {
+    std::string url;
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        url = this->_url;
+    }
+
+    try {
+        auto connection = HTTPStream::open(url, Deadline(timeouts, token));
+
+        auto statusCode = connection->head().statusCode;
+        if (statusCode != 200 && statusCode != 206) {
+            throw std::runtime_error("Unexpected status " + std::to_string(statusCode));
+        }
+
+        auto stream = connection.get();
+        {
+            std::lock_guard<std::mutex> lock(this->_mutex);
+            this->_url = connection->url();
+            this->_connection = std::move(connection);
+            this->_reading = false;
+        }
+        this->_changed.notify_all();
+
+        std::vector<char> chunk(16 * 1024);
+        while (true) {
+            // wait for room
+            size_t room;
+            {
+                std::unique_lock<std::mutex> lock(this->_mutex);
+                this->_changed.wait(lock, [this]() { return this->_stopRequested || this->_size < this->_ring.size(); });
+                if (this->_stopRequested) return;
+                room = std::min(chunk.size(), this->_ring.size() - this->_size);
+                this->_reading = true;
+            }
+
+            // each read is bounded on its own, stream might last longer than any total timeout
+            auto count = stream->read(chunk.data(), room, Deadline(timeouts, token));
+
+            {
+                std::lock_guard<std::mutex> lock(this->_mutex);
+                this->_reading = false;
+                this->_push(chunk.data(), count);
+            }
+            this->_changed.notify_all();
+            if (!count) break;
+        }
+
+        spdlog::debug("PrefetchBuffer : [{}] fully received", url);
+    } catch(const CancelledError &) {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_connection.reset();
+    } catch(const std::exception &e) {
+        spdlog::debug("PrefetchBuffer : Prefetching [{}] failed : {}", url, e.what());
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_error = e.what();
+        this->_connection.reset();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_reading = false;
+        this->_finished = true;
+    }
+    this->_changed.notify_all();
+}
+
+void AudioTube::PrefetchBuffer::_push(const char* data, size_t count) {
+    auto writePos = (this->_readPos + this->_size) % this->_ring.size();
+    auto firstPart = std::min(count, this->_ring.size() - writePos);
+
+    std::copy(data, data + firstPart, this->_ring.begin() + writePos);
+    std::copy(data + firstPart, data + count, this->_ring.begin());
+
+    this->_size += count;
+}
+
+size_t AudioTube::PrefetchBuffer::_pop(char* out, size_t maxBytes) {
+    auto count = std::min(maxBytes, this->_size);
+    auto firstPart = std::min(count, this->_ring.size() - this->_readPos);
+
+    std::copy(this->_ring.begin() + this->_readPos, this->_ring.begin() + this->_readPos + firstPart, out);
+    std::copy(this->_ring.begin(), this->_ring.begin() + (count - firstPart), out + firstPart);
+
+    this->_readPos = (this->_readPos + count) % this->_ring.size();
+    this->_size -= count;
+    this->_consumed += count;
+
+    return count;
+}
+
+size_t AudioTube::PrefetchBuffer::read(char* out, size_t maxBytes, const CancellationToken &token) {
+    size_t count = 0;
+
+    {
+        std::unique_lock<std::mutex> lock(this->_mutex);
+        if (!this->_started) throw std::logic_error("PrefetchBuffer : Not started");
+
+        // wake up regularly to check for cancellation
+        while (!this->_size && !this->_finished && !this->_stopRequested) {
+            if (token.isCancelled()) throw CancelledError("PrefetchBuffer : Read cancelled");
+            this->_changed.wait_for(lock, std::chrono::milliseconds(50));
+        }
+
+        if (!this->_size && !this->_error.empty()) {
+            throw std::runtime_error("PrefetchBuffer : " + this->_error);
+        }
+
+        count = this->_pop(out, maxBytes);
+    }
+
+    // room available
+    this->_changed.notify_all();
+    return count;
+}
+
+AudioTube::PrefetchBuffer::Handoff AudioTube::PrefetchBuffer::takeOver(std::chrono::milliseconds grace) {
+    // worker stops after its current read, leaving the connection open
+    {
+        std::unique_lock<std::mutex> lock(this->_mutex);
+        this->_stopRequested = true;
+        this->_changed.notify_all();
+
+        // stalled upstream, abort the read through the connection, which is lost
+        if (!this->_changed.wait_for(lock, grace, [this]() { return !this->_reading; })) {
+            spdlog::debug("PrefetchBuffer : [{}] stalled, dropping connection on takeover", this->_url);
+            this->_cancellation.cancel();
+        }
+    }
+    this->_join();
+
+    Handoff handoff;
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        if (!this->_started) throw std::logic_error("PrefetchBuffer : Not started");
+
+        handoff.url = this->_url;
+        handoff.offset = this->_consumed;
+        handoff.bytes.resize(this->_size);
+        this->_pop(handoff.bytes.data(), handoff.bytes.size());
+        handoff.connection = std::move(this->_connection);
+    }
+
+    this->stop();
+    return handoff;
+}
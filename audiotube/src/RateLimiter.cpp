@@ -0,0 +1,132 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include <spdlog/spdlog.h>
+
+#include <thread>
+#include <algorithm>
+
+#include "RateLimiter.h"
+
+AudioTube::RateLimiter::RateLimiter() : _rng(std::random_device{}()) {}
+
+void AudioTube::RateLimiter::setSettings(const Settings &settings) {
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    this->_settings = settings;
+}
+
+AudioTube::RateLimiter::Settings AudioTube::RateLimiter::settings() {
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    return this->_settings;
+}
+
+AudioTube::RateLimiter::_Bucket& AudioTube::RateLimiter::_bucketOf(const std::string &host, const Clock::time_point &now) {
+    auto found = this->_buckets.find(host);
+
+    // new host, full bucket
+    if (found == this->_buckets.end()) {
+        _Bucket bucket;
+        bucket.tokens = this->_settings.burst;
+        bucket.refilledAt = now;
+        return this->_buckets.emplace(host, bucket).first->second;
+    }
+
+    // refill
+    auto &bucket = found->second;
+    std::chrono::duration<double> elapsed = now - bucket.refilledAt;
+    bucket.tokens = std::min(this->_settings.burst, bucket.tokens + elapsed.count() * this->_settings.requestsPerSecond);
+    bucket.refilledAt = now;
+
+    return bucket;
+}
+
+void AudioTube::RateLimiter::acquire(const std::string &host, const Deadline &deadline) {
+    while (true) {
+        deadline.throwIfOver("RateLimiter : Waiting for [" + host + "]");
+        Clock::duration wait;
+
+        {
+            std::lock_guard<std::mutex> lock(this->_mutex);
+            auto now = Clock::now();
+            auto &bucket = this->_bucketOf(host, now);
+
+            if (now < bucket.blockedUntil) {
+                // upstream asked to wait
+                wait = bucket.blockedUntil - now;
+            } else if (bucket.tokens >= 1) {
+                // allowed
+                bucket.tokens -= 1;
+                bucket.requests++;
+                return;
+            } else {
+                // wait for next token
+                std::chrono::duration<double> untilNextToken((1 - bucket.tokens) / this->_settings.requestsPerSecond);
+                wait = std::chrono::duration_cast<Clock::duration>(untilNextToken);
+            }
+        }
+
+        // wake up regularly to check deadline
+        std::this_thread::sleep_for(std::min<Clock::duration>(wait, std::chrono::milliseconds(100)));
+    }
+}
+
+void AudioTube::RateLimiter::penalize(const std::string &host, const std::chrono::milliseconds &delay) {
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    auto now = Clock::now();
+    auto &bucket = this->_bucketOf(host, now);
+
+    bucket.throttled++;
+    bucket.blockedUntil = std::max(bucket.blockedUntil, now + delay);
+
+    // restart slowly once unblocked
+    bucket.tokens = 0;
+}
+
+void AudioTube::RateLimiter::countRetry(const std::string &host) {
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    this->_bucketOf(host, Clock::now()).retries++;
+}
+
+std::chrono::milliseconds AudioTube::RateLimiter::nextBackoff(const std::chrono::milliseconds &previous) {
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    auto base = this->_settings.backoffBase.count();
+    auto upper = std::max(base, previous.count() * 3);
+
+    std::uniform_int_distribution<std::chrono::milliseconds::rep> between(base, upper);
+    return std::min(this->_settings.backoffCap, std::chrono::milliseconds(between(this->_rng)));
+}
+
+std::vector<AudioTube::RateLimiter::Metrics> AudioTube::RateLimiter::metrics() {
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    auto now = Clock::now();
+
+    std::vector<Metrics> out;
+    for (auto &[host, unused] : this->_buckets) {
+        auto &bucket = this->_bucketOf(host, now);
+
+        Metrics m;
+        m.host = host;
+        m.availableTokens = bucket.tokens;
+        m.requests = bucket.requests;
+        m.throttled = bucket.throttled;
+        m.retries = bucket.retries;
+        if (now < bucket.blockedUntil) {
+            m.blockedFor = std::chrono::duration_cast<std::chrono::milliseconds>(bucket.blockedUntil - now);
+        }
+
+        out.push_back(m);
+    }
+
+    return out;
+}
@@ -0,0 +1,188 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include <spdlog/spdlog.h>
+
+#include "RefreshScheduler.h"
+#include "NetworkFetcher.h"
+
+AudioTube::RefreshScheduler::RefreshScheduler() : RefreshScheduler(Settings()) {}
+
+AudioTube::RefreshScheduler::RefreshScheduler(const Settings &settings) :
+    _settings(settings),
+    _workGuard(asio::make_work_guard(_ioContext)),
+    _timer(_ioContext),
+    _rng(std::random_device{}()) {
+    this->_worker = std::thread([this]() {
+        this->_ioContext.run();
+    });
+}
+
+AudioTube::RefreshScheduler::~RefreshScheduler() {
+    asio::post(this->_ioContext, [this]() {
+        this->_timer.cancel();
+    });
+    this->_workGuard.reset();
+    this->_ioContext.stop();
+    if (this->_worker.joinable()) this->_worker.join();
+}
+
+void AudioTube::RefreshScheduler::track(VideoMetadata* metadata, Priority priority) {
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_entries[metadata] = { priority, Clock::time_point::max() };
+    }
+
+    // due date is computed on worker, as its manifest might be being refreshed there
+    asio::post(this->_ioContext, [this, metadata]() {
+        {
+            std::lock_guard<std::mutex> lock(this->_mutex);
+            auto found = this->_entries.find(metadata);
+            if (found != this->_entries.end()) found->second.dueAt = this->_dueDateOf(metadata);
+        }
+
+        this->_rearm();
+    });
+}
+
+void AudioTube::RefreshScheduler::untrack(VideoMetadata* metadata) {
+    std::unique_lock<std::mutex> lock(this->_mutex);
+    this->_entries.erase(metadata);
+
+    // make sure metadata is not being refreshed anymore, so caller can safely delete it
+    if (std::this_thread::get_id() == this->_worker.get_id()) return;
+    this->_refreshDone.wait(lock, [=]() {
+        return this->_refreshing != metadata;
+    });
+}
+
+void AudioTube::RefreshScheduler::setPriority(VideoMetadata* metadata, Priority priority) {
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        auto found = this->_entries.find(metadata);
+        if (found == this->_entries.end()) return;
+        found->second.priority = priority;
+    }
+
+    asio::post(this->_ioContext, [this]() { this->_rearm(); });
+}
+
+size_t AudioTube::RefreshScheduler::trackedCount() {
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    return this->_entries.size();
+}
+
+AudioTube::RefreshScheduler::Clock::time_point AudioTube::RefreshScheduler::_dueDateOf(VideoMetadata* metadata) {
+    auto now = Clock::now();
+
+    // never fetched, ASAP
+    auto validUntil = metadata->audioStreams()->validUntil();
+    if (validUntil == -1) return now;
+
+    // remaining time before the played stream expires, minus margin and random jitter
+    auto secsLeft = validUntil - std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::uniform_int_distribution<std::chrono::milliseconds::rep> jitter(0, this->_settings.maxJitter.count());
+    auto dueIn = std::chrono::seconds(secsLeft)
+                    - this->_settings.refreshMargin
+                    - std::chrono::milliseconds(jitter(this->_rng));
+
+    if (dueIn.count() <= 0) return now;
+    return now + std::chrono::duration_cast<Clock::duration>(dueIn);
+}
+
+AudioTube::VideoMetadata* AudioTube::RefreshScheduler::_nextDue(const Clock::time_point &now, Clock::time_point* nextDueAt) {
+    VideoMetadata* elected = nullptr;
+    const _Entry* electedEntry = nullptr;
+    *nextDueAt = Clock::time_point::max();
+
+    for (const auto &[metadata, entry] : this->_entries) {
+        // not due yet, keep closest due date
+        if (entry.dueAt > now) {
+            *nextDueAt = std::min(*nextDueAt, entry.dueAt);
+            continue;
+        }
+
+        // highest priority first, then most overdue
+        auto isBetter = !electedEntry
+            || entry.priority > electedEntry->priority
+            || (entry.priority == electedEntry->priority && entry.dueAt < electedEntry->dueAt);
+        if (!isBetter) continue;
+
+        elected = metadata;
+        electedEntry = &entry;
+    }
+
+    return elected;
+}
+
+void AudioTube::RefreshScheduler::_rearm() {
+    auto now = Clock::now();
+    Clock::time_point wakeAt;
+
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        auto due = this->_nextDue(now, &wakeAt);
+        if (due) wakeAt = now;
+    }
+
+    // nothing to track
+    if (wakeAt == Clock::time_point::max()) {
+        this->_timer.cancel();
+        return;
+    }
+
+    // rate limit
+    wakeAt = std::max(wakeAt, this->_lastRefreshAt + this->_settings.minInterval);
+
+    this->_timer.expires_at(wakeAt);
+    this->_timer.async_wait([this](const asio::error_code &ec) {
+        this->_onTimer(ec);
+    });
+}
+
+void AudioTube::RefreshScheduler::_onTimer(const asio::error_code &ec) {
+    if (ec == asio::error::operation_aborted) return;
+
+    auto now = Clock::now();
+    VideoMetadata* toRefresh = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        Clock::time_point unused;
+        toRefresh = this->_nextDue(now, &unused);
+        this->_refreshing = toRefresh;
+    }
+
+    if (toRefresh) {
+        spdlog::debug("RefreshScheduler : Refreshing [{}] ahead of expiration...", toRefresh->id());
+        this->_lastRefreshAt = now;
+
+        NetworkFetcher::refreshMetadata(toRefresh, true);
+
+        std::lock_guard<std::mutex> lock(this->_mutex);
+
+        // reschedule if still tracked
+        auto found = this->_entries.find(toRefresh);
+        if (found != this->_entries.end()) {
+            found->second.dueAt = toRefresh->hasFailed() ?
+                Clock::now() + this->_settings.retryAfterFailure :
+                this->_dueDateOf(toRefresh);
+        }
+
+        this->_refreshing = nullptr;
+        this->_refreshDone.notify_all();
+    }
+
+    this->_rearm();
+}
@@ -14,39 +14,115 @@
 
 #include "Regexes.h"
 
-jp::Regex AudioTube::Regexes::Decipherer_findJSDecipheringOperations(const std::string &obfuscatedDecipheringFunctionName) {
-    return jp::Regex { _Decipherer_generateRegex(_Decipherer_JSDecipheringOperations, obfuscatedDecipheringFunctionName) };
+#ifdef AUDIOTUBE_WITH_CTRE
+    #include <ctre.hpp>
+#endif
+
+std::vector<std::string> AudioTube::Regexes::findYoutubeIds(const std::string &subject) {
+    std::vector<std::string> out;
+
+    #ifdef AUDIOTUBE_WITH_CTRE
+        // matched at compile time, no static initialization
+        static constexpr auto pattern = ctll::fixed_string { R"|((?:youtube\.com|youtu.be).*?(?:v=|embed/)((?:\w|-)+))|" };
+        for (auto match : ctre::search_all<pattern>(subject)) {
+            out.emplace_back(match.get<1>().to_view());
+        }
+    #else
+        for (const auto &match : _allMatches(_YoutubeIdFinder, subject)) {
+            out.push_back(match[1]);
+        }
+    #endif
+
+    return out;
+}
+
+std::vector<std::string> AudioTube::Regexes::findHTTPRequestYTVideoIds(const std::string &subject) {
+    std::vector<std::string> out;
+
+    #ifdef AUDIOTUBE_WITH_CTRE
+        static constexpr auto pattern = ctll::fixed_string { R"|(watch\?v=(.*?)&amp;)|" };
+        for (auto match : ctre::search_all<pattern>(subject)) {
+            out.emplace_back(match.get<1>().to_view());
+        }
+    #else
+        for (const auto &match : _allMatches(_HTTPRequestYTVideoIdExtractor, subject)) {
+            out.push_back(match[1]);
+        }
+    #endif
+
+    return out;
+}
+
+std::vector<std::string> AudioTube::Regexes::Decipherer_findCalledFunctions(const std::string &subject) {
+    std::vector<std::string> out;
+
+    #ifdef AUDIOTUBE_WITH_CTRE
+        static constexpr auto pattern = ctll::fixed_string { R"|(\w+\.(\w+)\()|" };
+        for (auto match : ctre::search_all<pattern>(subject)) {
+            out.emplace_back(match.get<1>().to_view());
+        }
+    #else
+        for (const auto &match : _allMatches(_Decipherer_findCalledFunction, subject)) {
+            out.push_back(match[1]);
+        }
+    #endif
+
+    return out;
 }
 
-// Careful, order is important !
-std::map<AudioTube::CipherOperation, jp::Regex> AudioTube::Regexes::Decipherer_DecipheringOps(const std::string &obfuscatedDecipheringFunctionName) {
-    std::map<CipherOperation, jp::Regex> out;
-    for (auto [co, regStrBase] : _cipherOperationRegexBase) {
-        auto regexAsStr = _Decipherer_generateRegex(regStrBase, obfuscatedDecipheringFunctionName);
-
-        out.emplace(
-            co,
-            jp::Regex { regexAsStr }
-        );
-    }
+std::vector<std::pair<std::string, std::string>> AudioTube::Regexes::Decipherer_findFuncAndArguments(const std::string &subject) {
+    std::vector<std::pair<std::string, std::string>> out;
+
+    #ifdef AUDIOTUBE_WITH_CTRE
+        static constexpr auto pattern = ctll::fixed_string { R"|(\.(\w+)\(\w+,(\d+)\))|" };
+        for (auto match : ctre::search_all<pattern>(subject)) {
+            out.emplace_back(match.get<1>().to_view(), match.get<2>().to_view());
+        }
+    #else
+        for (const auto &match : _allMatches(_Decipherer_findFuncAndArgument, subject)) {
+            out.emplace_back(match[1], match[2]);
+        }
+    #endif
+
     return out;
 }
 
-std::string AudioTube::Regexes::escapeForRegex(const std::string &toEscapeForRegex) {
-    return std::regex_replace(toEscapeForRegex, _specialChars, R"(\$&)");
+std::vector<std::pair<std::string, AudioTube::CipherOperation>> AudioTube::Regexes::Decipherer_findHelperOperations(const std::string &subject) {
+    std::vector<std::pair<std::string, CipherOperation>> out;
+
+    #ifdef AUDIOTUBE_WITH_CTRE
+        static constexpr auto pattern = ctll::fixed_string { R"|((\w+):function\(\w+(?:,\w+)?\)\{(?:(?:return\s+)?\w+\.(splice|slice)\(|(var\s+c=)|\w+\.(reverse)\())|" };
+        for (auto match : ctre::search_all<pattern>(subject)) {
+            out.emplace_back(match.get<1>().to_view(), _operationOf(match.get<2>().to_view(), match.get<3>().to_view(), match.get<4>().to_view()));
+        }
+    #else
+        for (const auto &match : _allMatches(_Decipherer_findHelperOperations, subject)) {
+            // trailing unset groups are not reported
+            auto group = [&match](size_t i) { return i < match.size() ? std::string_view(match[i]) : std::string_view(); };
+            out.emplace_back(match[1], _operationOf(group(2), group(3), group(4)));
+        }
+    #endif
+
+    return out;
 }
 
-std::string AudioTube::Regexes::_Decipherer_generateRegex(std::string rawRegexAsString, const std::string &obfuscatedDecipheringFunctionName) {
-    std::string toReplace = "%1";
-    auto escaped = escapeForRegex(obfuscatedDecipheringFunctionName);
+AudioTube::CipherOperation AudioTube::Regexes::_operationOf(const std::string_view &slice, const std::string_view &swap, const std::string_view &reverse) {
+    if (!slice.empty()) return CipherOperation::Slice;
+    if (!swap.empty()) return CipherOperation::Swap;
+    if (!reverse.empty()) return CipherOperation::Reverse;
+    return CipherOperation::CO_Unknown;
+}
 
-    // replace
-    rawRegexAsString.replace(
-        rawRegexAsString.find(toReplace),
-        toReplace.length(),
-        escaped
-    );
+#ifndef AUDIOTUBE_WITH_CTRE
+jp::VecNum AudioTube::Regexes::_allMatches(const jp::Regex &regex, const std::string &subject) {
+    jp::VecNum matches;
+    jp::RegexMatch rm;
+    rm.setRegexObject(&regex)
+        .setSubject(&subject)
+        .addModifier("gm")
+        .setNumberedSubstringVector(&matches)
+        .match();
 
-    // as std::string
-    return std::string { rawRegexAsString };
+    return matches;
 }
+#endif
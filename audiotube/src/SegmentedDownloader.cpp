@@ -0,0 +1,246 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include <spdlog/spdlog.h>
+
+#include <thread>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <exception>
+
+#include "SegmentedDownloader.h"
+
+AudioTube::SegmentedDownloader::SegmentedDownloader(const std::string &url) : SegmentedDownloader(url, Settings()) {}
+
+AudioTube::SegmentedDownloader::SegmentedDownloader(const std::string &url, const Settings &settings) : _url(url), _settings(settings) {}
+
+void AudioTube::SegmentedDownloader::setTotalSize(uint64_t totalSize) {
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    this->_totalSize = totalSize;
+    this->_segmentsDone.clear();
+}
+
+void AudioTube::SegmentedDownloader::setCache(ChunkCache* cache, const std::string &videoId, int itag) {
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    this->_cache = cache;
+    this->_videoId = videoId;
+    this->_itag = itag;
+    this->_settings.segmentSize = cache->chunkSize();
+    this->_segmentsDone.clear();
+}
+
+uint64_t AudioTube::SegmentedDownloader::totalSize(const Deadline &deadline) {
+    std::string url;
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        if (this->_totalSize) return this->_totalSize;
+        url = this->_url;
+    }
+
+    // probe first byte
+    auto response = downloadRange(url, { 0, 0 }, deadline);
+    if (response.statusCode != 206) {
+        throw std::runtime_error("SegmentedDownloader : Byte ranges are not supported for [" + url + "]");
+    }
+
+    auto totalSize = contentRangeTotal(response);
+    if (!totalSize) throw std::runtime_error("SegmentedDownloader : Cannot determine size of [" + url + "]");
+
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    this->_totalSize = totalSize;
+
+    // skip redirects for next requests
+    if (!response.redirectUrl.empty()) this->_url = response.redirectUrl;
+
+    return totalSize;
+}
+
+AudioTube::NetworkHelper::ByteRange AudioTube::SegmentedDownloader::_rangeOf(size_t segmentIndex) const {
+    ByteRange range;
+    range.first = segmentIndex * this->_settings.segmentSize;
+    range.last = std::min(range.first + this->_settings.segmentSize, this->_totalSize) - 1;
+    return range;
+}
+
+AudioTube::SegmentedDownloader::Progress AudioTube::SegmentedDownloader::progress() {
+    std::lock_guard<std::mutex> lock(this->_mutex);
+
+    Progress out;
+    out.totalSize = this->_totalSize;
+    out.downloadedBytes = this->_downloadedBytes;
+    out.segmentsCount = this->_segmentsDone.size();
+    out.segmentsDone = std::count(this->_segmentsDone.begin(), this->_segmentsDone.end(), true);
+
+    return out;
+}
+
+bool AudioTube::SegmentedDownloader::isComplete() {
+    auto current = this->progress();
+    return current.segmentsCount && current.segmentsDone == current.segmentsCount;
+}
+
+void AudioTube::SegmentedDownloader::_prepareSegments(const CancellationToken &token) {
+    auto totalSize = this->totalSize(Deadline(this->_settings.timeouts, token));
+    auto segmentsCount = (totalSize + this->_settings.segmentSize - 1) / this->_settings.segmentSize;
+
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    if (this->_segmentsDone.size() != segmentsCount) {
+        this->_segmentsDone.assign(segmentsCount, false);
+    }
+}
+
+std::string AudioTube::SegmentedDownloader::_downloadSegment(size_t segmentIndex, const CancellationToken &token) {
+    std::string url;
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        url = this->_url;
+    }
+
+    auto range = this->_rangeOf(segmentIndex);
+    auto expectedSize = range.last - range.first + 1;
+
+    // already cached
+    ChunkCache::Key cacheKey { this->_videoId, this->_itag, segmentIndex };
+    if (this->_cache) {
+        if (auto cached = this->_cache->get(cacheKey); cached && cached->size() == expectedSize) {
+            return std::string(cached->data(), cached->size());
+        }
+    }
+
+    for (unsigned int attempt = 1;; attempt++) {
+        try {
+            auto response = downloadRange(url, range, Deadline(this->_settings.timeouts, token));
+
+            if (response.statusCode != 206) {
+                throw std::runtime_error("Unexpected status " + std::to_string(response.statusCode) + " for segment " + std::to_string(segmentIndex));
+            }
+            if (response.messageBody.size() != expectedSize) {
+                throw std::runtime_error("Truncated segment " + std::to_string(segmentIndex));
+            }
+
+            if (this->_cache) this->_cache->put(cacheKey, response.messageBody.data(), response.messageBody.size());
+            return response.messageBody;
+        } catch(const CancelledError &) {
+            throw;
+        } catch(const std::exception &e) {
+            if (attempt >= this->_settings.attemptsPerSegment) throw;
+            spdlog::debug("SegmentedDownloader : {}, retrying ({}/{})...", e.what(), attempt, this->_settings.attemptsPerSegment);
+        }
+    }
+}
+
+void AudioTube::SegmentedDownloader::_downloadSegments(const SegmentWriter &writer, const std::function<void(size_t)> &onSegmentDone, const CancellationToken &token) {
+    size_t nextSegment = 0;
+    std::exception_ptr firstError;
+    std::atomic<bool> aborted { false };
+
+    auto worker = [&]() {
+        while (!aborted) {
+            // pick next missing segment
+            size_t segmentIndex;
+            {
+                std::lock_guard<std::mutex> lock(this->_mutex);
+                while (nextSegment < this->_segmentsDone.size() && this->_segmentsDone[nextSegment]) nextSegment++;
+                if (nextSegment >= this->_segmentsDone.size()) return;
+                segmentIndex = nextSegment++;
+            }
+
+            try {
+                auto data = this->_downloadSegment(segmentIndex, token);
+                writer(this->_rangeOf(segmentIndex).first, data);
+
+                {
+                    std::lock_guard<std::mutex> lock(this->_mutex);
+                    this->_segmentsDone[segmentIndex] = true;
+                }
+
+                this->_downloadedBytes += data.size();
+                onSegmentDone(segmentIndex);
+            } catch(...) {
+                // stop every worker, keep what was done for resuming
+                std::lock_guard<std::mutex> lock(this->_mutex);
+                if (!firstError) firstError = std::current_exception();
+                aborted = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < std::max(1u, this->_settings.connections); i++) {
+        workers.emplace_back(worker);
+    }
+    for (auto &thread : workers) thread.join();
+
+    if (firstError) std::rethrow_exception(firstError);
+}
+
+void AudioTube::SegmentedDownloader::downloadTo(std::vector<char>* buffer, const CancellationToken &token) {
+    this->_prepareSegments(token);
+    buffer->resize(this->_totalSize);
+
+    spdlog::debug("SegmentedDownloader : Downloading {} bytes into memory...", this->_totalSize);
+
+    // segments never overlap, no lock needed
+    auto data = buffer->data();
+    this->_downloadSegments([data](uint64_t offset, const std::string &segment) {
+        std::memcpy(data + offset, segment.data(), segment.size());
+    }, [](size_t) {}, token);
+}
+
+void AudioTube::SegmentedDownloader::downloadTo(const std::string &filePath, const CancellationToken &token) {
+    this->_prepareSegments(token);
+
+    auto partsPath = filePath + ".parts";
+    std::error_code ec;
+    auto hasPreallocatedFile = std::filesystem::exists(filePath, ec) && std::filesystem::file_size(filePath, ec) == this->_totalSize;
+
+    if (hasPreallocatedFile && std::filesystem::exists(partsPath, ec)) {
+        // resume from previous run
+        std::ifstream parts(partsPath);
+        size_t segmentIndex;
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        while (parts >> segmentIndex) {
+            if (segmentIndex < this->_segmentsDone.size()) this->_segmentsDone[segmentIndex] = true;
+        }
+    } else if (!hasPreallocatedFile || !this->isComplete()) {
+        // start over
+        {
+            std::lock_guard<std::mutex> lock(this->_mutex);
+            this->_segmentsDone.assign(this->_segmentsDone.size(), false);
+        }
+
+        std::ofstream(filePath, std::ios::binary | std::ios::trunc);
+        std::filesystem::resize_file(filePath, this->_totalSize);
+        std::ofstream(partsPath, std::ios::trunc);
+    }
+
+    spdlog::debug("SegmentedDownloader : Downloading {} bytes into [{}]...", this->_totalSize, filePath);
+
+    std::mutex partsMutex;
+    this->_downloadSegments([&filePath](uint64_t offset, const std::string &segment) {
+        std::fstream fh(filePath, std::ios::binary | std::ios::in | std::ios::out);
+        fh.seekp(offset);
+        fh.write(segment.data(), segment.size());
+        if (!fh) throw std::runtime_error("SegmentedDownloader : Cannot write into [" + filePath + "]");
+    }, [&](size_t segmentIndex) {
+        std::lock_guard<std::mutex> lock(partsMutex);
+        std::ofstream parts(partsPath, std::ios::app);
+        parts << segmentIndex << "\n";
+    }, token);
+
+    // done, no need to keep track of parts
+    std::filesystem::remove(partsPath, ec);
+}
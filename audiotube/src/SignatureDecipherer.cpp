@@ -15,6 +15,7 @@
 #include <spdlog/spdlog.h>
 
 #include "SignatureDecipherer.h"
+#include "PageScanner.h"
 
 void AudioTube::SignatureDecipherer::printOperations() const {
     auto copyOfOperations = this->_operations;
@@ -100,14 +101,22 @@ std::string AudioTube::SignatureDecipherer::decipher(const std::string &signatur
 }
 
 AudioTube::SignatureDecipherer* AudioTube::SignatureDecipherer::create(const std::string &clientPlayerUrl, const std::string &ytPlayerSourceCode) {
-    auto newDecipher = new SignatureDecipherer(ytPlayerSourceCode);
+    // concurrent creations for the same player share a single analysis
+    return _inflightCreations.run(clientPlayerUrl, [&]() {
+        // might have been created by a previous leader
+        if (auto cached = fromCache(clientPlayerUrl)) return cached;
 
-     _cache.emplace(clientPlayerUrl, newDecipher);
+        auto newDecipher = new SignatureDecipherer(ytPlayerSourceCode);
 
-    return newDecipher;
+        std::lock_guard<std::mutex> lock(_cacheMutex);
+        _cache.emplace(clientPlayerUrl, newDecipher);
+
+        return newDecipher;
+    });
 }
 
 AudioTube::SignatureDecipherer* AudioTube::SignatureDecipherer::fromCache(const std::string &clientPlayerUrl) {
+    std::lock_guard<std::mutex> lock(_cacheMutex);
     if (auto found = _cache.find(clientPlayerUrl); found != _cache.end()) {
         return found->second;
     }
@@ -131,21 +140,14 @@ AudioTube::SignatureDecipherer::YTClientMethod AudioTube::SignatureDecipherer::_
 }
 
 std::vector<std::string> AudioTube::SignatureDecipherer::_findJSDecipheringOperations(const std::string &ytPlayerSourceCode, const YTClientMethod &obfuscatedDecipheringFunctionName) {
-    // get the body of the function
-    jp::VecNum matches;
-    jp::RegexMatch rm;
-
-    auto regex = Regexes::Decipherer_findJSDecipheringOperations(obfuscatedDecipheringFunctionName);
-    rm.setRegexObject(&regex)
-        .setSubject(&ytPlayerSourceCode)
-        .addModifier("gm")
-        .setNumberedSubstringVector(&matches)
-        .match();
-
-    if (matches.size() == 0) throw std::runtime_error("[Decipherer] No function body found !");
+    // get the body of the function, eg. Xy=function(a){a=a.split("");...;return a.join("")}
+    auto declaration = _findDeclaration(ytPlayerSourceCode, obfuscatedDecipheringFunctionName, "=function(");
+    auto bodyStart = declaration == std::string::npos ? std::string::npos : ytPlayerSourceCode.find("){", declaration);
+    auto bodyEnd = bodyStart == std::string::npos ? std::string::npos : ytPlayerSourceCode.find('}', bodyStart);
+    if (bodyEnd == std::string::npos) throw std::runtime_error("[Decipherer] No function body found !");
 
     // calls
-    auto functionBody = matches[0][1];  // take first
+    auto functionBody = ytPlayerSourceCode.substr(bodyStart + 2, bodyEnd - bodyStart - 2);
     auto javascriptFunctionCalls = AudioTube::splitString(functionBody, ';');
 
     return javascriptFunctionCalls;
@@ -156,50 +158,43 @@ std::unordered_map<AudioTube::CipherOperation, AudioTube::SignatureDecipherer::Y
     // define out
     std::unordered_map<CipherOperation, YTClientMethod> functionNamesByOperation;
 
-    // find subjacent functions names used by decipherer
+    // find subjacent functions names used by decipherer, and the object holding them
     std::set<std::string> uniqueOperations;
+    std::string helperObjectName;
     for (const auto &call : javascriptDecipheringOperations) {
         // find function name in method call
-        jp::VecNum matches;
-        jp::RegexMatch rm;
-        rm.setRegexObject(&Regexes::Decipherer_findCalledFunction)
-            .setSubject(&call)
-            .addModifier("gm")
-            .setNumberedSubstringVector(&matches)
-            .match();
+        auto calledFunctions = Regexes::Decipherer_findCalledFunctions(call);
+        if (calledFunctions.size() != 1) continue;
 
-        if (matches.size() != 1) continue;
-
-        auto calledFunctionName = matches[0][1];
+        auto &calledFunctionName = calledFunctions[0];
 
         // add to set
         uniqueOperations.insert(calledFunctionName);
+
+        // eg. Xy.Ab(a,3), not a.split("")
+        if (!helperObjectName.empty() || Regexes::Decipherer_findFuncAndArguments(call).empty()) continue;
+        auto objectEnd = call.find("." + calledFunctionName + "(");
+        auto objectStart = objectEnd;
+        while (objectStart > 0 && _isIdentifierChar(call[objectStart - 1])) objectStart--;
+        helperObjectName = call.substr(objectStart, objectEnd - objectStart);
     }
 
-    // iterate through unique operations
-    for (const auto &calledFunctionName : uniqueOperations) {
-        // custom regexes to determine associated decipherer method
-        auto customRegexes = Regexes::Decipherer_DecipheringOps(calledFunctionName);
-
-        // find...
-        for (auto [co, regex] : customRegexes) {
-            // if already found, skip
-            if (functionNamesByOperation.find(co) != functionNamesByOperation.end()) continue;
-
-            // check with regex
-            jp::VecNum matches;
-            jp::RegexMatch rm;
-            rm.setRegexObject(&regex)
-                .setSubject(&ytPlayerSourceCode)
-                .addModifier("gm")
-                .setNumberedSubstringVector(&matches)
-                .match();
-
-            if (matches.size()) {
-                functionNamesByOperation.emplace(co, calledFunctionName);
-                break;  // found, break
-            }
-        }
+    if (helperObjectName.empty()) {
+        throw std::runtime_error("[Decipherer] No helper object called !");
+    }
+
+    // find helper object, eg. var Xy={Ab:function(a){a.reverse()},...}
+    auto opening = _findDeclaration(ytPlayerSourceCode, helperObjectName, "={");
+    auto closing = opening == std::string::npos ? std::string::npos : PageScanner::closingBrace(ytPlayerSourceCode, opening - 1);
+    if (closing == std::string::npos) {
+        throw std::runtime_error("[Decipherer] No helper object found !");
+    }
+
+    // classify all its functions at once
+    auto helperObject = ytPlayerSourceCode.substr(opening, closing - opening);
+    for (const auto &[functionName, co] : Regexes::Decipherer_findHelperOperations(helperObject)) {
+        if (co == CipherOperation::CO_Unknown || !uniqueOperations.count(functionName)) continue;
+        functionNamesByOperation.emplace(co, functionName);
     }
 
     if (!functionNamesByOperation.size()) {
@@ -218,18 +213,11 @@ AudioTube::SignatureDecipherer::YTDecipheringOperations AudioTube::SignatureDeci
     // iterate
     for (const auto &call : javascriptOperations) {
         // find which function is called
-        jp::VecNum matches;
-        jp::RegexMatch rm;
-        rm.setRegexObject(&Regexes::Decipherer_findFuncAndArgument)
-                .setSubject(&call)
-                .addModifier("gm")
-                .setNumberedSubstringVector(&matches)
-                .match();
-
-        if (matches.size() != 1) continue;
+        auto funcAndArguments = Regexes::Decipherer_findFuncAndArguments(call);
+        if (funcAndArguments.size() != 1) continue;
 
-        auto calledFunctionName = matches[0][1];
-        auto arg = safe_stoi(matches[0][2]);
+        auto &calledFunctionName = funcAndArguments[0].first;
+        auto arg = safe_stoi(funcAndArguments[0].second);
 
         // find associated operation type
         auto operationTypeFound = std::find_if(
@@ -286,3 +274,18 @@ AudioTube::SignatureDecipherer::SignatureDecipherer(const std::string &ytPlayerS
     // copy operation to object
     this->_operations = operations;
 }
+
+size_t AudioTube::SignatureDecipherer::_findDeclaration(const std::string &ytPlayerSourceCode, const std::string &name, const std::string &suffix) {
+    auto declaration = name + suffix;
+    for (auto found = ytPlayerSourceCode.find(declaration); found != std::string::npos; found = ytPlayerSourceCode.find(declaration, found + 1)) {
+        // skip longer identifiers ending with name
+        if (found && _isIdentifierChar(ytPlayerSourceCode[found - 1])) continue;
+        return found + declaration.size();
+    }
+
+    return std::string::npos;
+}
+
+bool AudioTube::SignatureDecipherer::_isIdentifierChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '$';
+}
@@ -0,0 +1,185 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <thread>
+
+#include "StreamProber.h"
+
+AudioTube::StreamProber::StreamProber() : StreamProber(4) {}
+
+AudioTube::StreamProber::StreamProber(size_t maxIdlePerHost) : _maxIdlePerHost(maxIdlePerHost) {
+    this->_sslContext.set_default_verify_paths();
+}
+
+AudioTube::StreamProber::~StreamProber() {
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    this->_idle.clear();
+}
+
+size_t AudioTube::StreamProber::idleConnections() const {
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    return this->_idle.size();
+}
+
+AudioTube::StreamProber::Result AudioTube::StreamProber::probe(const std::string &url, const Deadline &deadline) {
+    Result result;
+    result.url = url;
+
+    try {
+        for (unsigned int redirects = 0; redirects <= MaxRedirects; redirects++) {
+            UrlParser parsed(result.url);
+            _rateLimiter.acquire(parsed.host(), deadline);
+
+            // a kept-alive connection might have been closed by server meanwhile, then try another one
+            NetworkHelper::Response response;
+            while (true) {
+                auto connection = this->_acquire(parsed, deadline);
+                auto reused = connection->reused;
+
+                try {
+                    bool reusable = false;
+                    response = this->_request(connection.get(), parsed, deadline, &reusable);
+                    if (reusable) this->_release(parsed, std::move(connection));
+                    break;
+                } catch(const asio::system_error &e) {
+                    if (!reused) throw;
+                    spdlog::debug("StreamProber : Stale connection to [{}] dropped ({})", parsed.host(), e.what());
+                }
+            }
+
+            if (!response.redirectUrl.empty()) {
+                result.url = response.redirectUrl;
+                continue;
+            }
+
+            result.statusCode = response.statusCode;
+            result.totalSize = contentRangeTotal(response);
+            result.available = response.statusCode == 206 || (response.statusCode == 200 && response.hasContentLengthHeader);
+            return result;
+        }
+
+        spdlog::debug("StreamProber : Too many redirects for [{}]", url);
+    } catch(const std::exception &e) {
+        spdlog::debug("StreamProber : Cannot probe [{}] : {}", url, e.what());
+    }
+
+    return result;
+}
+
+std::vector<AudioTube::StreamProber::Result> AudioTube::StreamProber::probeAll(const std::vector<std::string> &urls, unsigned int concurrency, const Deadline::Timeouts &timeouts) {
+    std::vector<Result> results(urls.size());
+    std::atomic<size_t> next { 0 };
+
+    // each probe fails on its own, no error to propagate
+    auto worker = [&]() {
+        while (true) {
+            auto index = next++;
+            if (index >= urls.size()) return;
+            results[index] = this->probe(urls[index], Deadline(timeouts));
+        }
+    };
+
+    auto workersCount = std::min<size_t>(std::max(1u, concurrency), urls.size());
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < workersCount; i++) {
+        workers.emplace_back(worker);
+    }
+    for (auto &thread : workers) thread.join();
+
+    return results;
+}
+
+std::string AudioTube::StreamProber::_poolKey(const UrlParser &url) {
+    return url.scheme() + "://" + url.host();
+}
+
+std::unique_ptr<AudioTube::StreamProber::_Connection> AudioTube::StreamProber::_acquire(const UrlParser &url, const Deadline &deadline) {
+    // idle one first
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        auto found = this->_idle.find(_poolKey(url));
+        if (found != this->_idle.end()) {
+            auto connection = std::move(found->second);
+            this->_idle.erase(found);
+            connection->reused = true;
+            return connection;
+        }
+    }
+
+    auto connection = std::make_unique<_Connection>();
+    auto socket = _connect(connection->ioContext, url, deadline);
+
+    // plain HTTP, eg. local servers
+    if (url.scheme() == "http") {
+        connection->socket = std::make_unique<tcp::socket>(std::move(socket));
+        return connection;
+    }
+
+    connection->sslStream = std::make_unique<ssl::stream<tcp::socket>>(connection->ioContext, this->_sslContext);
+    connection->sslStream->next_layer() = std::move(socket);
+    _handshake(connection->ioContext, *connection->sslStream, url.hostName(), deadline);
+
+    return connection;
+}
+
+void AudioTube::StreamProber::_release(const UrlParser &url, std::unique_ptr<_Connection> connection) {
+    auto key = _poolKey(url);
+
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    if (this->_idle.count(key) >= this->_maxIdlePerHost) return;
+    this->_idle.emplace(key, std::move(connection));
+}
+
+AudioTube::NetworkHelper::Response AudioTube::StreamProber::_request(_Connection* connection, const UrlParser &url, const Deadline &deadline, bool* reusable) {
+    if (connection->sslStream) return this->_exchangeKeepAlive(connection, *connection->sslStream, url, deadline, reusable);
+    return this->_exchangeKeepAlive(connection, *connection->socket, url, deadline, reusable);
+}
+
+template<typename Stream>
+AudioTube::NetworkHelper::Response AudioTube::StreamProber::_exchangeKeepAlive(_Connection* connection, Stream &stream, const UrlParser &url, const Deadline &deadline, bool* reusable) {
+    std::vector<std::string> rangeHeader { "Range: bytes=0-0" };
+    _sendRequest(connection->ioContext, stream, url, false, deadline, rangeHeader, true);
+
+    asio::streambuf buffer;
+    auto response = _readHead(connection->ioContext, stream, buffer, url.host(), deadline);
+
+    // body must be drained for the connection to serve another request, which requires its length
+    auto connectionHeader = headerValue(response, "Connection");
+    std::transform(connectionHeader.begin(), connectionHeader.end(), connectionHeader.begin(), ::tolower);
+
+    auto contentLength = headerValue(response, "Content-Length");
+    uint64_t bodySize = 0;
+    auto parsed = std::from_chars(contentLength.data(), contentLength.data() + contentLength.size(), bodySize);
+
+    *reusable = false;
+    if (connectionHeader == "close" || contentLength.empty() || parsed.ec != std::errc() || bodySize > _maxDrainedBody) return response;
+
+    while (buffer.size() < bodySize) {
+        _PendingOp reading;
+        asio::async_read(stream, buffer, asio::transfer_at_least(1), reading.handler());
+        _await(connection->ioContext, &reading, deadline.expiresAt(), deadline, "Probing [" + url.host() + "]", _closer(stream));
+        if (reading.ec) return response;
+    }
+
+    // anything past body would be lost with buffer
+    buffer.consume(bodySize);
+    *reusable = !buffer.size();
+
+    return response;
+}
@@ -14,78 +14,156 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <array>
+
 #include "StreamsManifest.h"
+#include "HTTPStream.h"
 
 AudioTube::StreamsManifest::StreamsManifest() {}
 
 void AudioTube::StreamsManifest::feedRaw_DASH(const RawDASHManifest &raw, const SignatureDecipherer* decipherer) {
-    // find streams
-    jp::VecNum matches;
-    jp::RegexMatch rm;
-    rm.setRegexObject(&Regexes::DASHManifestExtractor)
-        .setSubject(&raw)
-        .addModifier("gm")
-        .setNumberedSubstringVector(&matches)
-        .match();
+    MpdParser parser;
+    parser.feed(raw);
+    this->_feedDASH(parser, decipherer);
+}
 
-    // check
-    if (!matches.size()) throw std::logic_error("[DASH] No stream found on manifest");
+promise::Promise AudioTube::StreamsManifest::promise_feedDASH(const std::string &dashManifestUrl, const SignatureDecipherer* decipherer, const Deadline &deadline) {
+    return promise::newPromise([=](promise::Defer d) {
+        auto stream = HTTPStream::open(dashManifestUrl, deadline);
+        if (stream->head().statusCode != 200) {
+            throw std::runtime_error("[DASH] Cannot fetch manifest, status " + std::to_string(stream->head().statusCode));
+        }
 
-    // container
-    AudioStreamUrlByBitrate streams;
+        // parse while downloading
+        MpdParser parser;
+        std::array<char, 16 * 1024> buffer;
+        while (true) {
+            auto read = stream->read(buffer.data(), buffer.size(), deadline);
+            if (!read) break;
+            parser.feed(buffer.data(), read);
+        }
 
-    // iterate through streams
-    for (auto &submatches : matches) {
-        // check
-        if (submatches.size() != 5) throw std::logic_error("[DASH] Expected dataparts are missing from stream");
+        this->_feedDASH(parser, decipherer);
+        d.resolve();
+    });
+}
 
-        // get parts
-        auto itag = safe_stoi(submatches[1]);
-        auto codec = submatches[2];
-        auto bitrate = safe_stoi(submatches[3]);
-        auto url = submatches[4];
+void AudioTube::StreamsManifest::_feedDASH(const MpdParser &parser, const SignatureDecipherer* decipherer) {
+    // check
+    if (!parser.representationsCount()) throw std::logic_error("[DASH] No stream found on manifest");
+
+    // container
+    StreamDescriptors streams;
 
+    // iterate through audio representations
+    for (const auto &representation : parser.representations()) {
         // check codec
-        if (!_isCodecAllowed(codec)) continue;
+        if (!_isCodecAllowed(representation.codecs)) continue;
 
         // fill
-        streams.emplace(bitrate, std::make_pair(itag, url));
-    }
+        StreamDescriptor stream;
+        stream.itag = safe_stoi(representation.id);
+        stream.url = representation.baseUrl;
+        stream.mime = representation.mimeType;
+        stream.codec = representation.codecs;
+        stream.bitrate = representation.bandwidth;
+        stream.audioSampleRate = representation.audioSamplingRate;
+        stream.initRange = representation.initRange;
+        stream.indexRange = representation.indexRange;
+
+        if (!representation.segmentUrls.empty()) {
+            if (!representation.initializationUrl.empty()) stream.segmentUrls.push_back(representation.initializationUrl);
+            stream.segmentUrls.insert(stream.segmentUrls.end(), representation.segmentUrls.begin(), representation.segmentUrls.end());
+        }
 
-    if(!streams.size()) return;
+        if (stream.url.empty() && stream.segmentUrls.empty()) continue;
+        streams.push_back(std::move(stream));
+    }
 
-    // insert in package
-    this->_package.emplace(AudioStreamsSource::DASH, streams);
+    this->_store(AudioStreamsSource::DASH, std::move(streams));
 }
 
 void AudioTube::StreamsManifest::feedRaw_PlayerConfig(const RawPlayerConfigStreams &raw, const SignatureDecipherer* decipherer) {
-    // TODO(amphaal)
+    StreamDescriptors streams;
+
+    // comma separated formats, each of them being a query
+    std::string_view remaining(raw);
+    while (!remaining.empty()) {
+        auto comma = remaining.find(',');
+        auto format = remaining.substr(0, comma);
+        remaining = comma == std::string_view::npos ? std::string_view() : remaining.substr(comma + 1);
+
+        // only point to the fields needed
+        std::string_view type, url, signature, cipheredSignature, signatureParameter;
+        StreamDescriptor stream;
+
+        QueryTokenizer tokenizer(format);
+        QueryTokenizer::Field field;
+        while (tokenizer.next(&field)) {
+            if (field.key == "type") type = field.value;
+            else if (field.key == "url") url = field.value;
+            else if (field.key == "sig") signature = field.value;
+            else if (field.key == "s") cipheredSignature = field.value;
+            else if (field.key == "sp") signatureParameter = field.value;
+            else if (field.key == "itag") stream.itag = static_cast<ITag>(_numberFrom(field.value));
+            else if (field.key == "bitrate") stream.bitrate = static_cast<unsigned int>(_numberFrom(field.value));
+            else if (field.key == "clen") stream.contentLength = _numberFrom(field.value);
+            else if (field.key == "audio_sample_rate") stream.audioSampleRate = static_cast<unsigned int>(_numberFrom(field.value));
+            else if (field.key == "approxDurationMs") stream.approxDurationMs = _numberFrom(field.value);
+            else if (field.key == "init") stream.initRange = byteRangeFrom(field.value);
+            else if (field.key == "index") stream.indexRange = byteRangeFrom(field.value);
+        }
+
+        // check mime, most formats are video ones
+        auto mimeType = QueryTokenizer::decode(type);
+        if (!_isMimeAllowed(mimeType) || url.empty()) continue;
+        _splitMimeType(mimeType, &stream.mime, &stream.codec);
+
+        stream.url = QueryTokenizer::decode(url);
+
+        // signature, given as is or ciphered
+        if (!signature.empty()) {
+            stream.url += "&signature=" + QueryTokenizer::decode(signature);
+        } else if (!cipheredSignature.empty()) {
+            if (!decipherer) {
+                spdlog::debug("PlayerConfig : Skipping ciphered stream [{}], no decipherer", stream.itag);
+                continue;
+            }
+
+            stream.url = _decipheredUrl(
+                decipherer,
+                stream.url,
+                QueryTokenizer::decode(cipheredSignature),
+                QueryTokenizer::decode(signatureParameter)
+            );
+        }
+
+        streams.push_back(std::move(stream));
+    }
+
+    this->_store(AudioStreamsSource::PlayerConfig, std::move(streams));
 }
 
-void AudioTube::StreamsManifest::feedRaw_PlayerResponse(const RawPlayerResponseStreams &raw, const SignatureDecipherer* decipherer) {
-    AudioStreamUrlByBitrate streams;
+void AudioTube::StreamsManifest::feedRaw_PlayerResponse(const PlayerResponseFormats &formats, const SignatureDecipherer* decipherer) {
+    StreamDescriptors streams;
 
     // iterate
-    for (auto itagGroup : raw) {
+    for (const auto &format : formats) {
         // check mime
-        auto mimeType = itagGroup["mimeType"].get<std::string>();
-        if (!_isMimeAllowed(mimeType)) continue;
+        if (!_isMimeAllowed(format.mimeType)) continue;
 
         // find itag + url
-        auto tag = itagGroup["itag"].get<int>();
-        auto bitrate = itagGroup["bitrate"].get<double>();
-        std::string url;
-        auto url_JSON = itagGroup["url"];
+        StreamDescriptor stream;
+        stream.itag = format.itag;
+        stream.bitrate = static_cast<unsigned int>(format.bitrate);
+        _splitMimeType(format.mimeType, &stream.mime, &stream.codec);
 
         // decipher if no url
-        if (url_JSON.is_null()) {
-            // find cipher
-            auto cipherRaw = itagGroup["cipher"];
-            if (cipherRaw.is_null()) cipherRaw = itagGroup["signatureCipher"];
-            if (cipherRaw.is_null()) throw std::logic_error("Cipher data cannot be found !");
+        if (format.url.empty()) {
+            if (format.cipher.empty()) throw std::logic_error("Cipher data cannot be found !");
 
-            auto cipherRawStr = cipherRaw.get<std::string>();
-            UrlQuery cipher(cipherRawStr);
+            UrlQuery cipher(format.cipher);
 
             // find params
             auto cipheredUrl = cipher["url"].percentDecoded();
@@ -93,25 +171,69 @@ void AudioTube::StreamsManifest::feedRaw_PlayerResponse(const RawPlayerResponseS
             auto signatureParameter = cipher["sp"].percentDecoded();
 
             // decipher
-            url = _decipheredUrl(
+            stream.url = _decipheredUrl(
                 decipherer,
                 cipheredUrl,
                 signature,
                 signatureParameter
             );
         } else {
-            url = url_JSON.get<std::string>();
-            spdlog::debug("PlayerResponse : Unciphered URL [{}]", url);
+            stream.url = format.url;
+            spdlog::debug("PlayerResponse : Unciphered URL [{}]", stream.url);
         }
 
-        // add tag / url pair
-        streams.emplace(bitrate, std::make_pair(tag, url));
+        stream.contentLength = format.contentLength;
+        stream.approxDurationMs = format.approxDurationMs;
+        stream.audioSampleRate = format.audioSampleRate;
+
+        // keep byte ranges, for seeking
+        stream.initRange = format.initRange;
+        stream.indexRange = format.indexRange;
+
+        streams.push_back(std::move(stream));
     }
 
+    this->_store(AudioStreamsSource::PlayerResponse, std::move(streams));
+}
+
+void AudioTube::StreamsManifest::_store(AudioStreamsSource source, StreamDescriptors streams) {
     if(!streams.size()) return;
 
+    for (auto &stream : streams) {
+        stream.expiresAt = _expiryFrom(stream.url);
+    }
+
+    // sort once, selection relies on it
+    std::stable_sort(streams.begin(), streams.end(), [](const StreamDescriptor &a, const StreamDescriptor &b) {
+        return a.bitrate < b.bitrate;
+    });
+
     // insert in package
-    this->_package.emplace(AudioStreamsSource::PlayerResponse, streams);
+    this->_package.emplace(source, std::move(streams));
+}
+
+uint64_t AudioTube::StreamsManifest::_numberFrom(const std::string_view &value) {
+    uint64_t out = 0;
+    auto result = std::from_chars(value.data(), value.data() + value.size(), out);
+    return result.ec == std::errc() ? out : 0;
+}
+
+void AudioTube::StreamsManifest::_splitMimeType(const std::string &mimeType, std::string* mime, std::string* codec) {
+    // eg. audio/webm; codecs="opus"
+    auto separator = mimeType.find(';');
+    *mime = mimeType.substr(0, separator);
+    while (!mime->empty() && mime->back() == ' ') mime->pop_back();
+
+    codec->clear();
+    if (separator == std::string::npos) return;
+
+    auto codecs = mimeType.find("codecs=", separator);
+    if (codecs == std::string::npos) return;
+
+    auto begin = codecs + 7;
+    if (begin < mimeType.size() && mimeType[begin] == '"') begin++;
+    auto end = mimeType.find_first_of("\",", begin);
+    *codec = mimeType.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
 }
 
 std::string AudioTube::StreamsManifest::_decipheredUrl(const SignatureDecipherer* decipherer, const std::string &cipheredUrl, std::string signature, std::string sigKey) {
@@ -131,46 +253,131 @@ std::string AudioTube::StreamsManifest::_decipheredUrl(const SignatureDecipherer
     return out;
 }
 
-void AudioTube::StreamsManifest::setRequestedAt(const std::time_t &requestedAt) {
-    this->_requestedAt = requestedAt;
+void AudioTube::StreamsManifest::reset() {
+    this->_package.clear();
+    this->_fallbackValidUntil = -1;
 }
+
 void AudioTube::StreamsManifest::setSecondsUntilExpiration(const unsigned int secsUntilExp) {
-    this->_validUntil = this->_requestedAt + secsUntilExp;
+    auto now = std::chrono::system_clock::to_time_t(
+        std::chrono::system_clock::now()
+    );
+
+    this->_fallbackValidUntil = now + secsUntilExp;
+}
+
+AudioTube::StreamsManifest::SelectionPolicy AudioTube::StreamsManifest::SelectionPolicy::best() {
+    return SelectionPolicy();
 }
 
-std::pair<AudioTube::StreamsManifest::AudioStreamsSource, AudioTube::StreamsManifest::AudioStreamUrlByBitrate> AudioTube::StreamsManifest::preferedStreamSource() const {
+AudioTube::StreamsManifest::SelectionPolicy AudioTube::StreamsManifest::SelectionPolicy::highestUpTo(unsigned int maxBitrate, const std::string &codec) {
+    SelectionPolicy policy;
+    policy.maxBitrate = maxBitrate;
+    policy.codec = codec;
+    return policy;
+}
+
+AudioTube::StreamsManifest::SelectionPolicy AudioTube::StreamsManifest::SelectionPolicy::smallestAtLeast(unsigned int minBitrate, const std::string &codec) {
+    SelectionPolicy policy;
+    policy.minBitrate = minBitrate;
+    policy.codec = codec;
+    policy.highest = false;
+    return policy;
+}
+
+std::pair<AudioTube::StreamsManifest::AudioStreamsSource, const AudioTube::StreamsManifest::StreamDescriptors*> AudioTube::StreamsManifest::preferedStreamSource() const {
     // try to fetch in order of preference (sorted by enum)
-    for (auto [source, ASUBIT] : this->_package) {
-        if (ASUBIT.size()) return { source, ASUBIT };
+    for (const auto &[source, streams] : this->_package) {
+        if (std::any_of(streams.begin(), streams.end(), _isWholeStream)) return { source, &streams };
     }
 
     throw std::logic_error("No audio stream source found !");
 }
 
-std::string AudioTube::StreamsManifest::preferedUrl() const {
+const AudioTube::StreamsManifest::StreamDescriptor* AudioTube::StreamsManifest::select(const SelectionPolicy &policy) const {
     auto source = this->preferedStreamSource();
-    spdlog::debug("Picking stream URL from source : [{}]", AudioStreamsSource_str[source.first]);
+    const auto &streams = *source.second;
+
+    auto matches = [&policy](const StreamDescriptor &stream) {
+        if (!_isWholeStream(stream)) return false;
+        if (stream.bitrate < policy.minBitrate) return false;
+        if (policy.maxBitrate && stream.bitrate > policy.maxBitrate) return false;
+        return policy.codec.empty() || stream.codec == policy.codec;
+    };
+
+    // since bitrates are asc-ordered, first match is either the smallest or the highest
+    if (policy.highest) {
+        auto found = std::find_if(streams.rbegin(), streams.rend(), matches);
+        return found == streams.rend() ? nullptr : &*found;
+    }
 
-    // since bitrates are asc-ordered, take latest for fastest
-    auto last = source.second.end();
-    last--;
+    auto found = std::find_if(streams.begin(), streams.end(), matches);
+    return found == streams.end() ? nullptr : &*found;
+}
 
-    auto url = last->second.second;
-    spdlog::debug(url);
+const AudioTube::StreamsManifest::StreamDescriptor& AudioTube::StreamsManifest::preferedStream() const {
+    auto source = this->preferedStreamSource();
+    spdlog::debug("Picking stream from source : [{}]", AudioStreamsSource_str[source.first]);
 
+    // take latest for fastest
+    const auto &streams = *source.second;
+    return *std::find_if(streams.rbegin(), streams.rend(), _isWholeStream);
+}
+
+std::string AudioTube::StreamsManifest::preferedUrl() const {
+    auto url = this->preferedStream().url;
+    spdlog::debug(url);
     return url;
 }
 
 bool AudioTube::StreamsManifest::isExpired() const {
-    if (this->_validUntil == -1) return true;
+    auto validUntil = this->validUntil();
+    if (validUntil == -1) return true;
 
     auto now = std::chrono::system_clock::to_time_t(
         std::chrono::system_clock::now()
     );
 
-    return now > this->_validUntil;
+    return now > validUntil;
+}
+
+std::time_t AudioTube::StreamsManifest::validUntil() const {
+    // of prefered stream, unless never fed
+    for (const auto &[source, streams] : this->_package) {
+        if (std::any_of(streams.begin(), streams.end(), _isWholeStream)) return this->validUntil(this->preferedStream());
+    }
+
+    return -1;
+}
+
+std::time_t AudioTube::StreamsManifest::validUntil(const StreamDescriptor &stream) const {
+    return stream.expiresAt != -1 ? stream.expiresAt : this->_fallbackValidUntil;
 }
 
+std::time_t AudioTube::StreamsManifest::_expiryFrom(const std::string &url) {
+    std::string value;
+
+    // query parameter, or path segment on DASH urls
+    auto queryStart = url.find('?');
+    if (queryStart != std::string::npos) {
+        UrlQuery query(std::string_view(url).substr(queryStart + 1));
+        value = query["expire"].undecoded();
+    }
+
+    auto pathParam = url.find("/expire/");
+    if (value.empty() && pathParam != std::string::npos) {
+        auto valueStart = pathParam + 8;
+        value = url.substr(valueStart, url.find('/', valueStart) - valueStart);
+    }
+
+    std::time_t expiresAt = -1;
+    auto result = std::from_chars(value.data(), value.data() + value.size(), expiresAt);
+    return result.ec == std::errc() ? expiresAt : -1;
+}
+
+bool AudioTube::StreamsManifest::_isWholeStream(const StreamDescriptor &stream) {
+    return stream.segmentUrls.empty();
+}
 
 bool AudioTube::StreamsManifest::_isCodecAllowed(const std::string &codec) {
     auto opusFound = codec.find("opus");
@@ -0,0 +1,69 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include <spdlog/spdlog.h>
+
+#include "UnavailabilityCache.h"
+
+AudioTube::UnavailableVideoError::UnavailableVideoError(const Reason &reason, const std::string &what) : std::logic_error(what), _reason(reason) {}
+
+AudioTube::UnavailableVideoError::Reason AudioTube::UnavailableVideoError::reason() const {
+    return this->_reason;
+}
+
+void AudioTube::UnavailabilityCache::remember(const VideoId &videoId, const UnavailableVideoError &error) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto &entry = _entries[videoId];
+
+    entry.reason = error.reason();
+    entry.message = error.what();
+    entry.failures++;
+
+    // double TTL on each consecutive failure, up to max
+    auto ttl = _baseTTL;
+    for (unsigned int i = 1; i < entry.failures && ttl < _maxTTL; i++) ttl *= 2;
+    ttl = std::min(ttl, _maxTTL);
+
+    entry.retryAfter = Clock::now() + ttl;
+
+    spdlog::debug("UnavailabilityCache : [{}] considered unavailable for {}s", videoId, ttl.count());
+}
+
+void AudioTube::UnavailabilityCache::forget(const VideoId &videoId) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _entries.erase(videoId);
+}
+
+void AudioTube::UnavailabilityCache::clear() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _entries.clear();
+}
+
+std::optional<AudioTube::UnavailabilityCache::Entry> AudioTube::UnavailabilityCache::find(const VideoId &videoId) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto found = _entries.find(videoId);
+    if (found == _entries.end()) return std::nullopt;
+
+    // expired, allow a new try but keep failures count for backoff
+    if (Clock::now() >= found->second.retryAfter) return std::nullopt;
+
+    return found->second;
+}
+
+void AudioTube::UnavailabilityCache::setBackoff(const std::chrono::seconds &baseTTL, const std::chrono::seconds &maxTTL) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _baseTTL = baseTTL;
+    _maxTTL = maxTTL;
+}
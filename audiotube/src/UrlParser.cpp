@@ -12,6 +12,8 @@
 // MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
 // GNU General Public License for more details.
 
+#include <algorithm>
+
 #include "UrlParser.h"
 
 AudioTube::UrlParser::UrlParser(std::string_view rawUrlView) {
@@ -49,6 +51,18 @@ std::string AudioTube::UrlParser::host() const {
     return std::string { this->_host };
 }
 
+std::string AudioTube::UrlParser::hostName() const {
+    auto portSeparator = this->_host.rfind(':');
+    if (portSeparator == std::string::npos || this->_host.find(']', portSeparator) != std::string::npos) return this->host();
+    return std::string { this->_host.substr(0, portSeparator) };
+}
+
+std::string AudioTube::UrlParser::service() const {
+    auto portSeparator = this->_host.rfind(':');
+    if (portSeparator == std::string::npos || this->_host.find(']', portSeparator) != std::string::npos) return this->scheme();
+    return std::string { this->_host.substr(portSeparator + 1) };
+}
+
 std::string AudioTube::UrlParser::scheme() const {
     return std::string{ this->_scheme };
 }
@@ -137,6 +151,39 @@ std::string AudioTube::UrlQuery::undecoded() const {
     return std::string { this->_wholeQuery };
 }
 
+AudioTube::QueryTokenizer::QueryTokenizer(const std::string_view &query, char separator) : _remaining(query), _separator(separator) {}
+
+bool AudioTube::QueryTokenizer::next(Field* field) {
+    while (!this->_remaining.empty()) {
+        auto end = this->_remaining.find(this->_separator);
+        auto pair = this->_remaining.substr(0, end);
+        this->_remaining = end == std::string_view::npos ? std::string_view() : this->_remaining.substr(end + 1);
+
+        // skip empty pairs, eg. "a=1&&b=2"
+        if (pair.empty()) continue;
+
+        auto equal = pair.find('=');
+        field->key = pair.substr(0, equal);
+        field->value = equal == std::string_view::npos ? std::string_view() : pair.substr(equal + 1);
+        return true;
+    }
+
+    return false;
+}
+
+std::string AudioTube::QueryTokenizer::Field::decoded() const {
+    return QueryTokenizer::decode(this->value);
+}
+
+std::string AudioTube::QueryTokenizer::decode(const std::string_view &value) {
+    // nothing to decode, most values
+    if (value.find_first_of("%+") == std::string_view::npos) return std::string { value };
+
+    std::string plusDecoded { value };
+    std::replace(plusDecoded.begin(), plusDecoded.end(), '+', ' ');
+    return Url::decode(plusDecoded);
+}
+
 std::string AudioTube::Url::decode(const std::string & sSrc) {
     // Note from RFC1630:  "Sequences which start with a percent sign
     // but are not followed by two hexadecimal characters (0-9, A-F) are reserved
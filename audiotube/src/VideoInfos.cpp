@@ -14,111 +14,134 @@
 
 #include "VideoInfos.h"
 
-promise::Promise AudioTube::VideoInfos::fillStreamsManifest(const PlayerConfig::VideoId &videoId, PlayerConfig* playerConfig, StreamsManifest* manifest) {
-    // set request date
-    auto now = std::chrono::system_clock::to_time_t(
-        std::chrono::system_clock::now()
-    );
-    manifest->setRequestedAt(now);
-
+promise::Promise AudioTube::VideoInfos::fillStreamsManifest(const PlayerConfig::VideoId &videoId, PlayerConfig* playerConfig, StreamsManifest* manifest, const Deadline &deadline) {
     // pipeline
-    return _downloadRaw_VideoInfos(videoId, playerConfig->sts())
+    return _downloadRaw_VideoInfos(videoId, playerConfig->sts(), deadline)
             .then([=](const DownloadedUtf8 &dl) {
-                return _fillFrom_VideoInfos(dl, manifest, playerConfig);
+                return _fillFrom_VideoInfos(dl, manifest, playerConfig, deadline);
             });
 }
 
-promise::Promise AudioTube::VideoInfos::_downloadRaw_VideoInfos(const PlayerConfig::VideoId &videoId, const std::string &sts) {
+promise::Promise AudioTube::VideoInfos::_downloadRaw_VideoInfos(const PlayerConfig::VideoId &videoId, const std::string &sts, const Deadline &deadline) {
     auto apiUrl = std::string("https://youtube.googleapis.com/v/") + videoId;
     auto encodedApiUrl = Url::encode(apiUrl);
 
     auto requestUrl = std::string("https://www.youtube.com/get_video_info?video_id=") + videoId + "&el=embedded&eurl=" + encodedApiUrl + "&hl=en&sts=" + sts;
 
-    return promise_dl_HTTPS(requestUrl);
+    return promise_dl_HTTPS(requestUrl, false, deadline);
 }
 
-promise::Promise AudioTube::VideoInfos::_fillFrom_VideoInfos(const DownloadedUtf8 &dl, StreamsManifest* manifest, PlayerConfig *playerConfig) {
-    return promise::newPromise([=](promise::Defer d) {
-        // as string then to query
-        UrlQuery videoInfos(dl);
+promise::Promise AudioTube::VideoInfos::refreshStreamsManifest(const PlayerConfig::VideoId &videoId, const PlayerConfig* playerConfig, StreamsManifest* manifest, const Deadline &deadline) {
+    // pipeline
+    auto decipherer = playerConfig->decipherer();
+    return _downloadRaw_VideoInfos(videoId, playerConfig->sts(), deadline)
+            .then([=](const DownloadedUtf8 &dl) {
+                return _fillStreamsFrom_VideoInfos(dl, manifest, decipherer, deadline);
+            });
+}
 
-        // get player response
-        auto playerResponseAsStr = videoInfos["player_response"].percentDecoded();
-        auto playerResponse = nlohmann::json::parse(playerResponseAsStr);
-        if (playerResponseAsStr.empty() || playerResponse.is_null()) {
-            throw std::logic_error("Player response is missing !");
-        }
+AudioTube::PlayerResponse AudioTube::VideoInfos::_playablePlayerResponse(const UrlQuery &videoInfos) {
+    // get player response
+    auto playerResponseAsStr = videoInfos["player_response"].percentDecoded();
+    if (playerResponseAsStr.empty()) {
+        throw std::logic_error("Player response is missing !");
+    }
 
-        auto videoDetails = playerResponse["videoDetails"];
+    // only keep what is needed
+    auto playerResponse = PlayerResponseParser::parse(playerResponseAsStr);
 
-        // check playability status
-        auto playabilityStatus = playerResponse["playabilityStatus"];
+    // check playability status, reason first to throw soft error
+    if (playerResponse.playabilityReason) {
+        throw std::string("This video is not available though VideoInfo : ") + *playerResponse.playabilityReason;
+    }
 
-        // check reason, throw soft error
-        auto pReason = playabilityStatus["reason"];
-        if (!pReason.is_null()) {
-            throw std::string("This video is not available though VideoInfo : ") + pReason.get<std::string>();
-        }
+    if (playerResponse.playabilityStatus != "OK") {
+        throw std::logic_error("This video is not available !");
+    }
 
-        auto pStatus = playabilityStatus["status"].get<std::string>();
-        if (pStatus != "OK") {
-            throw std::logic_error("This video is not available !");
-        }
+    return playerResponse;
+}
+
+std::string AudioTube::VideoInfos::_fillFrom_StreamingData(const UrlQuery &videoInfos, const PlayerResponse &playerResponse, StreamsManifest* manifest, const SignatureDecipherer* decipherer) {
+    // get streamingData
+    if (!playerResponse.hasStreamingData) {
+        throw std::logic_error("An error occured while fetching video infos");
+    }
+
+    // find expiration
+    const auto &expiresIn = playerResponse.expiresInSeconds;
+    if (expiresIn.empty()) {
+        throw std::logic_error("An error occured while fetching video infos");
+    }
+
+    // set expiration date
+    auto ei_cast = safe_stoi(expiresIn);
+    if (ei_cast < 0) {
+        throw std::logic_error("An error occured while fetching video infos");
+    }
+    manifest->setSecondsUntilExpiration((unsigned int)ei_cast);
+
+    // raw stream infos
+    auto raw_playerConfigStreams = videoInfos["adaptive_fmts"].percentDecoded();
+
+    // feed
+    manifest->feedRaw_PlayerConfig(raw_playerConfigStreams, decipherer);
+    manifest->feedRaw_PlayerResponse(playerResponse.audioFormats, decipherer);
+
+    // DASH manifest handling
+    return playerResponse.dashManifestUrl;
+}
+
+promise::Promise AudioTube::VideoInfos::_mayFetchRaw_DASH(const std::string &dashManifestUrl, StreamsManifest* manifest, const SignatureDecipherer* decipherer, const Deadline &deadline) {
+    if (dashManifestUrl.empty()) return promise::resolve();
+
+    return manifest->promise_feedDASH(dashManifestUrl, decipherer, deadline);
+}
+
+promise::Promise AudioTube::VideoInfos::_fillFrom_VideoInfos(const DownloadedUtf8 &dl, StreamsManifest* manifest, PlayerConfig *playerConfig, const Deadline &deadline) {
+    return promise::newPromise([=](promise::Defer d) {
+        // as string then to query
+        UrlQuery videoInfos(dl);
+        auto playerResponse = _playablePlayerResponse(videoInfos);
 
         // check if is live
-        auto isLiveStream = videoDetails["isLiveContent"].get<bool>();
-        if (isLiveStream) {
-            throw std::logic_error("Live streams are not handled for now!");
+        if (!playerResponse.hasVideoDetails) throw std::logic_error("Video details cannot be found !");
+        if (playerResponse.isLiveContent) {
+            throw UnavailableVideoError(UnavailableVideoError::LiveContent, "Live streams are not handled for now!");
         }
 
         // get title and duration
-        auto title = videoDetails["title"].get<std::string>();
+        auto title = playerResponse.title;
         std::replace(title.begin(), title.end(), '+', ' ');
-        auto duration = safe_stoi(videoDetails["lengthSeconds"].get<std::string>());
+        auto duration = safe_stoi(playerResponse.lengthSeconds);
 
         if (title.empty()) throw std::logic_error("Video title cannot be found !");
         if (duration < 0) throw std::logic_error("Video length cannot be found !");
 
         playerConfig->fillFromVideoInfosDetails(title, duration);
 
-        // get streamingData
-        auto streamingData = playerResponse["streamingData"];
-        if (streamingData.is_null()) {
-            throw std::logic_error("An error occured while fetching video infos");
-        }
-
-        // find expiration
-        auto expiresIn = streamingData["expiresInSeconds"].get<std::string>();
-        if (expiresIn.empty()) {
-            throw std::logic_error("An error occured while fetching video infos");
-        }
-
-        // set expiration date
-        auto ei_cast = safe_stoi(expiresIn);
-        if (ei_cast < 0) {
-            throw std::logic_error("An error occured while fetching video infos");
-        }
-        manifest->setSecondsUntilExpiration((unsigned int)ei_cast);
+        // streams
+        auto dashManifestUrl = _fillFrom_StreamingData(videoInfos, playerResponse, manifest, playerConfig->decipherer());
 
-        // raw stream infos
-        auto raw_playerConfigStreams = videoInfos["adaptive_fmts"].percentDecoded();
-        auto raw_playerResponseStreams = streamingData["adaptiveFormats"];
+        d.resolve(dashManifestUrl);
+    })
+    .then([=](const std::string &dashManifestUrl){
+        return _mayFetchRaw_DASH(dashManifestUrl, manifest, playerConfig->decipherer(), deadline);
+    });
+}
 
-        // feed
-        manifest->feedRaw_PlayerConfig(raw_playerConfigStreams, playerConfig->decipherer());
-        manifest->feedRaw_PlayerResponse(raw_playerResponseStreams, playerConfig->decipherer());
+promise::Promise AudioTube::VideoInfos::_fillStreamsFrom_VideoInfos(const DownloadedUtf8 &dl, StreamsManifest* manifest, const SignatureDecipherer* decipherer, const Deadline &deadline) {
+    return promise::newPromise([=](promise::Defer d) {
+        // as string then to query
+        UrlQuery videoInfos(dl);
+        auto playerResponse = _playablePlayerResponse(videoInfos);
 
-        // DASH manifest handling
-        std::string dashManifestUrl;
-        auto dmu = streamingData["dashManifestUrl"];
-        if(!dmu.is_null()) dashManifestUrl = dmu.get<std::string>();
+        // streams only, details are already known
+        auto dashManifestUrl = _fillFrom_StreamingData(videoInfos, playerResponse, manifest, decipherer);
 
         d.resolve(dashManifestUrl);
     })
     .then([=](const std::string &dashManifestUrl){
-        auto mayFetchRawDASH = dashManifestUrl.empty() ? promise::resolve() : promise_dl_HTTPS(dashManifestUrl).then([=](const DownloadedUtf8 &dl) {
-            manifest->feedRaw_DASH(dl, playerConfig->decipherer());
-        });
-        return mayFetchRawDASH;
+        return _mayFetchRaw_DASH(dashManifestUrl, manifest, decipherer, deadline);
     });
 }
@@ -50,20 +50,14 @@ AudioTube::VideoMetadata::VideoMetadata(const std::string &IdOrUrl, const Instan
     switch (type) {
         case InstantiationType::InstFromUrl: {
             // find id
-            jp::VecNum matches;
-            jp::RegexMatch rm;
-            rm.setRegexObject(&Regexes::YoutubeIdFinder)
-                .setSubject(&IdOrUrl)
-                .addModifier("gm")
-                .setNumberedSubstringVector(&matches)
-                .match();
+            auto ids = Regexes::findYoutubeIds(IdOrUrl);
 
             // returns
-            if (matches.size() != 1) {
+            if (ids.size() != 1) {
                 throw std::invalid_argument("URL is not a valid  URL !");
             }
 
-            this->_videoId = matches[0][1];
+            this->_videoId = ids[0];
             this->_url = IdOrUrl;
         }
         break;
@@ -107,6 +101,14 @@ void AudioTube::VideoMetadata::setPlayerConfig(const PlayerConfig &playerConfig)
     this->_playerConfig = playerConfig;
 }
 
+void AudioTube::VideoMetadata::cancelPendingRefresh() {
+    this->_cancellation.cancel();
+}
+
+AudioTube::CancellationToken AudioTube::VideoMetadata::cancellationToken() const {
+    return this->_cancellation.token();
+}
+
 AudioTube::StreamsManifest* AudioTube::VideoMetadata::audioStreams() {
     return &this->_audioStreams;
 }
@@ -114,3 +116,7 @@ AudioTube::StreamsManifest* AudioTube::VideoMetadata::audioStreams() {
 AudioTube::PlayerConfig* AudioTube::VideoMetadata::playerConfig() {
     return &this->_playerConfig;
 }
+
+AudioTube::PrefetchBuffer* AudioTube::VideoMetadata::prefetch() {
+    return this->_prefetch.get();
+}
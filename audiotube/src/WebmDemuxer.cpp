@@ -0,0 +1,353 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include <stdexcept>
+
+#include "WebmDemuxer.h"
+
+AudioTube::WebmDemuxer::WebmDemuxer(const PacketCallback &onPacket) : _onPacket(onPacket) {}
+
+const std::vector<AudioTube::WebmDemuxer::Track>& AudioTube::WebmDemuxer::tracks() const {
+    return this->_tracks;
+}
+
+const AudioTube::WebmDemuxer::Track* AudioTube::WebmDemuxer::opusTrack() const {
+    for (const auto &track : this->_tracks) {
+        if (track.codecId == "A_OPUS") return &track;
+    }
+    return nullptr;
+}
+
+uint64_t AudioTube::WebmDemuxer::timecodeScale() const {
+    return this->_timecodeScale;
+}
+
+std::optional<double> AudioTube::WebmDemuxer::durationSeconds() const {
+    if (!this->_duration) return std::nullopt;
+    return *this->_duration * this->_timecodeScale / 1e9;
+}
+
+uint64_t AudioTube::WebmDemuxer::position() const {
+    return this->_position;
+}
+
+void AudioTube::WebmDemuxer::seek(uint64_t position) {
+    this->_position = position;
+    this->_skip = 0;
+    this->_carry.clear();
+    this->_carryNeed = 0;
+    this->_clusterTimecode = 0;
+}
+
+bool AudioTube::WebmDemuxer::_isMaster(uint32_t id) {
+    switch (id) {
+        case Segment:
+        case Info:
+        case Tracks:
+        case TrackEntry:
+        case Audio:
+        case Cluster:
+        case BlockGroup:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool AudioTube::WebmDemuxer::_isHandledLeaf(uint32_t id) {
+    switch (id) {
+        case TimecodeScale:
+        case Duration:
+        case TrackNumber:
+        case TrackType:
+        case CodecID:
+        case CodecPrivate:
+        case CodecDelay:
+        case SeekPreRoll:
+        case SamplingFrequency:
+        case Channels:
+        case Timecode:
+        case SimpleBlock:
+        case Block:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool AudioTube::WebmDemuxer::_onHeader(const EbmlReader::Header &header) {
+    // enter masters, their children come next
+    if (_isMaster(header.id)) {
+        if (header.id == Cluster) this->_clusterTimecode = 0;
+        if (header.id == TrackEntry) this->_tracks.emplace_back();
+        return true;
+    }
+
+    if (header.unknownSize) throw std::runtime_error("WebmDemuxer : Unknown size of non-master element");
+
+    // skip whatever we do not need (Cues, SeekHead, Void, Tags...) without buffering it
+    if (!_isHandledLeaf(header.id)) {
+        this->_skip = header.size;
+        return true;
+    }
+
+    if (header.size > _maxLeafSize) throw std::runtime_error("WebmDemuxer : Element too big");
+    return false;
+}
+
+void AudioTube::WebmDemuxer::feed(const char* data, size_t size) {
+    auto p = data;
+    auto end = data + size;
+
+    while (p < end) {
+        auto available = static_cast<uint64_t>(end - p);
+
+        // ignored element body
+        if (this->_skip) {
+            auto n = std::min(this->_skip, available);
+            p += n;
+            this->_skip -= n;
+            this->_position += n;
+            continue;
+        }
+
+        // complete element started in a previous chunk
+        if (!this->_carry.empty()) {
+            if (!this->_carryNeed) {
+                // header first, byte per byte since it is at most 12 bytes long
+                this->_carry.push_back(*p++);
+                auto header = EbmlReader::readHeader(this->_carry.data(), this->_carry.size());
+                if (!header) continue;
+
+                if (this->_onHeader(*header)) {
+                    this->_position += header->length;
+                    this->_carry.clear();
+                    continue;
+                }
+
+                this->_carryNeed = header->length + header->size;
+            } else {
+                auto n = std::min(this->_carryNeed - this->_carry.size(), available);
+                this->_carry.append(p, n);
+                p += n;
+            }
+
+            if (this->_carry.size() == this->_carryNeed) {
+                auto header = EbmlReader::readHeader(this->_carry.data(), this->_carry.size());
+                this->_onLeaf(header->id, std::string_view(this->_carry).substr(header->length));
+
+                this->_position += this->_carryNeed;
+                this->_carry.clear();
+                this->_carryNeed = 0;
+            }
+
+            continue;
+        }
+
+        // zero-copy path
+        auto header = EbmlReader::readHeader(p, available);
+        if (!header) {
+            this->_carry.assign(p, end);
+            this->_carryNeed = 0;
+            break;
+        }
+
+        if (this->_onHeader(*header)) {
+            p += header->length;
+            this->_position += header->length;
+            continue;
+        }
+
+        auto total = header->length + header->size;
+        if (total > available) {
+            this->_carry.assign(p, end);
+            this->_carryNeed = total;
+            break;
+        }
+
+        this->_onLeaf(header->id, std::string_view(p + header->length, header->size));
+        p += total;
+        this->_position += total;
+    }
+}
+
+void AudioTube::WebmDemuxer::_onLeaf(uint32_t id, std::string_view body) {
+    auto track = this->_tracks.empty() ? nullptr : &this->_tracks.back();
+
+    switch (id) {
+        case TimecodeScale: {
+            auto scale = EbmlReader::readUInt(body);
+            if (scale) this->_timecodeScale = scale;
+        }
+        break;
+
+        case Duration:
+            this->_duration = EbmlReader::readFloat(body);
+            break;
+
+        case Timecode:
+            this->_clusterTimecode = EbmlReader::readUInt(body);
+            break;
+
+        case SimpleBlock:
+        case Block:
+            this->_onBlock(body, id == SimpleBlock);
+            break;
+
+        default:
+            break;
+    }
+
+    if (!track) return;
+
+    switch (id) {
+        case TrackNumber: track->number = EbmlReader::readUInt(body); break;
+        case TrackType: track->type = EbmlReader::readUInt(body); break;
+        case CodecID: track->codecId = std::string(body); break;
+        case CodecPrivate: track->codecPrivate = std::string(body); break;
+        case CodecDelay: track->codecDelayNs = EbmlReader::readUInt(body); break;
+        case SeekPreRoll: track->seekPreRollNs = EbmlReader::readUInt(body); break;
+        case SamplingFrequency: track->samplingFrequency = EbmlReader::readFloat(body); break;
+        case Channels: track->channels = EbmlReader::readUInt(body); break;
+        default: break;
+    }
+}
+
+void AudioTube::WebmDemuxer::_onBlock(std::string_view body, bool isSimpleBlock) {
+    // track number, relative timecode, flags
+    auto trackNumber = EbmlReader::readVint(body.data(), body.size(), false);
+    if (!trackNumber || body.size() < trackNumber->second + 3) throw std::runtime_error("WebmDemuxer : Truncated block");
+
+    auto opus = this->opusTrack();
+    if (!opus || opus->number != trackNumber->first) return;
+
+    auto p = trackNumber->second;
+    auto relativeTimecode = static_cast<int16_t>((static_cast<uint8_t>(body[p]) << 8) | static_cast<uint8_t>(body[p + 1]));
+    auto flags = static_cast<uint8_t>(body[p + 2]);
+    auto frames = body.substr(p + 3);
+
+    Packet packet;
+    packet.track = trackNumber->first;
+    packet.timestampNs = (static_cast<int64_t>(this->_clusterTimecode) + relativeTimecode) * static_cast<int64_t>(this->_timecodeScale);
+    packet.keyframe = isSimpleBlock ? (flags & 0x80) != 0 : true;
+
+    // no lacing
+    auto lacing = (flags >> 1) & 0x03;
+    if (!lacing) {
+        packet.data = frames;
+        this->_onPacket(packet);
+        return;
+    }
+
+    if (frames.empty()) throw std::runtime_error("WebmDemuxer : Truncated lace");
+    size_t count = static_cast<uint8_t>(frames[0]) + 1;
+    size_t q = 1;
+    this->_laceSizes.clear();
+
+    switch (lacing) {
+        // Xiph : sizes as sums of bytes, 255 meaning "more to come"
+        case 1: {
+            for (size_t i = 0; i + 1 < count; i++) {
+                size_t size = 0;
+                uint8_t byte;
+                do {
+                    if (q >= frames.size()) throw std::runtime_error("WebmDemuxer : Truncated Xiph lace");
+                    byte = static_cast<uint8_t>(frames[q++]);
+                    size += byte;
+                } while (byte == 255);
+                this->_laceSizes.push_back(size);
+            }
+        }
+        break;
+
+        // fixed : same size for all
+        case 2: {
+            auto remaining = frames.size() - q;
+            if (remaining % count) throw std::runtime_error("WebmDemuxer : Invalid fixed-size lace");
+            this->_laceSizes.assign(count - 1, remaining / count);
+        }
+        break;
+
+        // EBML : first size, then signed differences to previous
+        case 3: {
+            if (count < 2) break;
+
+            auto first = EbmlReader::readVint(frames.data() + q, frames.size() - q, false);
+            if (!first) throw std::runtime_error("WebmDemuxer : Truncated EBML lace");
+            q += first->second;
+
+            int64_t size = first->first;
+            this->_laceSizes.push_back(size);
+
+            for (size_t i = 1; i + 1 < count; i++) {
+                auto raw = EbmlReader::readVint(frames.data() + q, frames.size() - q, false);
+                if (!raw) throw std::runtime_error("WebmDemuxer : Truncated EBML lace");
+                q += raw->second;
+
+                size += static_cast<int64_t>(raw->first) - ((1ll << (7 * raw->second - 1)) - 1);
+                if (size < 0) throw std::runtime_error("WebmDemuxer : Invalid EBML lace");
+                this->_laceSizes.push_back(size);
+            }
+        }
+        break;
+    }
+
+    // last frame takes what remains
+    size_t laced = 0;
+    for (auto size : this->_laceSizes) laced += size;
+    if (q + laced > frames.size()) throw std::runtime_error("WebmDemuxer : Lace sizes exceed block");
+    this->_laceSizes.push_back(frames.size() - q - laced);
+
+    // frames of a lace follow each other in time
+    for (auto size : this->_laceSizes) {
+        packet.data = frames.substr(q, size);
+        this->_onPacket(packet);
+
+        packet.timestampNs += opusPacketDurationNs(packet.data);
+        q += size;
+    }
+}
+
+int64_t AudioTube::WebmDemuxer::opusPacketDurationNs(std::string_view packet) {
+    if (packet.empty()) return 0;
+
+    auto toc = static_cast<uint8_t>(packet[0]);
+    auto config = toc >> 3;
+
+    // frame duration, by mode
+    static constexpr int64_t silk[] = { 10000000, 20000000, 40000000, 60000000 };
+    static constexpr int64_t hybrid[] = { 10000000, 20000000 };
+    static constexpr int64_t celt[] = { 2500000, 5000000, 10000000, 20000000 };
+
+    int64_t frameDuration;
+    if (config < 12) {
+        frameDuration = silk[config % 4];
+    } else if (config < 16) {
+        frameDuration = hybrid[config % 2];
+    } else {
+        frameDuration = celt[config % 4];
+    }
+
+    // frames count
+    switch (toc & 0x03) {
+        case 0:
+            return frameDuration;
+        case 1:
+        case 2:
+            return 2 * frameDuration;
+        default:
+            if (packet.size() < 2) return 0;
+            return (static_cast<uint8_t>(packet[1]) & 0x3F) * frameDuration;
+    }
+}
@@ -0,0 +1,142 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+#include "WebmSeekIndex.h"
+
+AudioTube::WebmSeekIndex AudioTube::WebmSeekIndex::fetch(const std::string &url, const ByteRange &initRange, const ByteRange &indexRange, const Deadline &deadline) {
+    auto fetchRange = [&](const ByteRange &range) {
+        auto response = downloadRange(url, range, deadline);
+        if (response.statusCode != 206 || response.messageBody.size() != range.last - range.first + 1) {
+            throw std::runtime_error("WebmSeekIndex : Cannot fetch range " + std::to_string(range.first) + "-" + std::to_string(range.last));
+        }
+        return response.messageBody;
+    };
+
+    // usually adjacent, one request is enough
+    auto first = std::min(initRange.first, indexRange.first);
+    auto last = std::max(initRange.last, indexRange.last);
+    auto gap = indexRange.first > initRange.last ? indexRange.first - initRange.last - 1 : 0;
+
+    if (gap <= _maxRangesGap) {
+        auto body = fetchRange({ first, last });
+        std::string_view view(body);
+        return parse(
+            view.substr(initRange.first - first, initRange.last - initRange.first + 1),
+            view.substr(indexRange.first - first, indexRange.last - indexRange.first + 1)
+        );
+    }
+
+    auto init = fetchRange(initRange);
+    auto cues = fetchRange(indexRange);
+    return parse(init, cues);
+}
+
+AudioTube::WebmSeekIndex AudioTube::WebmSeekIndex::parse(std::string_view init, std::string_view cues) {
+    WebmSeekIndex index;
+    index._parseInit(init);
+    index._parseCues(cues);
+
+    if (index._seekPoints.empty()) throw std::logic_error("WebmSeekIndex : No cue point found");
+
+    spdlog::debug("WebmSeekIndex : {} cue points", index._seekPoints.size());
+    return index;
+}
+
+void AudioTube::WebmSeekIndex::_parseInit(std::string_view init) {
+    size_t offset = 0;
+
+    while (offset < init.size()) {
+        auto header = EbmlReader::readHeader(init.data() + offset, init.size() - offset);
+        if (!header) break;
+
+        // positions of Cues are relative to Segment data
+        if (header->id == Segment) {
+            this->_segmentDataStart = offset + header->length;
+
+            // Info is among first children, Tracks and others might be cut by init range
+            EbmlReader::forEachChild(init.substr(offset + header->length), [this](uint32_t id, std::string_view body) {
+                if (id != Info) return;
+                EbmlReader::forEachChild(body, [this](uint32_t id, std::string_view body) {
+                    if (id == TimecodeScale && EbmlReader::readUInt(body)) this->_timecodeScale = EbmlReader::readUInt(body);
+                });
+            });
+
+            return;
+        }
+
+        // EBML header
+        offset += header->length + header->size;
+    }
+
+    throw std::logic_error("WebmSeekIndex : No Segment found in init range");
+}
+
+void AudioTube::WebmSeekIndex::_parseCues(std::string_view cues) {
+    auto header = EbmlReader::readHeader(cues.data(), cues.size());
+    if (!header || header->id != Cues) throw std::logic_error("WebmSeekIndex : Index range is not a Cues element");
+
+    EbmlReader::forEachChild(cues.substr(header->length), [this](uint32_t id, std::string_view cuePoint) {
+        if (id != CuePoint) return;
+
+        std::optional<uint64_t> time, clusterPosition;
+        EbmlReader::forEachChild(cuePoint, [&](uint32_t id, std::string_view body) {
+            if (id == CueTime) time = EbmlReader::readUInt(body);
+            if (id != CueTrackPositions || clusterPosition) return;
+
+            // single audio track, first position is enough
+            EbmlReader::forEachChild(body, [&](uint32_t id, std::string_view body) {
+                if (id == CueClusterPosition) clusterPosition = EbmlReader::readUInt(body);
+            });
+        });
+
+        if (!time || !clusterPosition) return;
+
+        SeekPoint point;
+        point.seconds = static_cast<double>(*time) * this->_timecodeScale / 1e9;
+        point.byteOffset = this->_segmentDataStart + *clusterPosition;
+        this->_seekPoints.push_back(point);
+    });
+
+    std::sort(this->_seekPoints.begin(), this->_seekPoints.end(), [](const SeekPoint &a, const SeekPoint &b) {
+        return a.seconds < b.seconds;
+    });
+}
+
+AudioTube::WebmSeekIndex::SeekPoint AudioTube::WebmSeekIndex::seekPointFor(double seconds) const {
+    if (this->_seekPoints.empty()) throw std::logic_error("WebmSeekIndex : Empty index");
+
+    // last one starting before
+    auto after = std::upper_bound(this->_seekPoints.begin(), this->_seekPoints.end(), seconds, [](double seconds, const SeekPoint &point) {
+        return seconds < point.seconds;
+    });
+    if (after == this->_seekPoints.begin()) return this->_seekPoints.front();
+
+    return *std::prev(after);
+}
+
+uint64_t AudioTube::WebmSeekIndex::byteOffsetFor(double seconds) const {
+    return this->seekPointFor(seconds).byteOffset;
+}
+
+const std::vector<AudioTube::WebmSeekIndex::SeekPoint>& AudioTube::WebmSeekIndex::seekPoints() const {
+    return this->_seekPoints;
+}
+
+uint64_t AudioTube::WebmSeekIndex::segmentDataStart() const {
+    return this->_segmentDataStart;
+}
@@ -14,40 +14,288 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+
 #include "_NetworkHelper.h"
 
-AudioTube::NetworkHelper::Response AudioTube::NetworkHelper::downloadHTTPS(const std::string &downloadUrl, bool head) {
-    // decompose url
-    UrlParser url_decomposer(downloadUrl);
-    auto serverName = url_decomposer.host();
-    auto scheme = url_decomposer.scheme();
+AudioTube::RateLimiter& AudioTube::NetworkHelper::rateLimiter() {
+    return _rateLimiter;
+}
 
-    auto getCommand = url_decomposer.pathAndQuery();
+AudioTube::NetworkHelper::Response AudioTube::NetworkHelper::downloadHTTPS(const std::string &downloadUrl, bool head, const Deadline &deadline, const std::vector<std::string> &extraHeaders) {
+    auto host = UrlParser(downloadUrl).host();
+    auto settings = _rateLimiter.settings();
+    auto backoff = settings.backoffBase;
 
-    // setup service
-    asio::io_service io_service;
+    for (unsigned int attempt = 0;; attempt++) {
+        _rateLimiter.acquire(host, deadline);
 
-    // setup SSL
-    ssl::context ssl_ctx(ssl::context::sslv23);
-    ssl_ctx.set_default_verify_paths();
-    asio::ssl::stream<tcp::socket> ssl_sock(io_service, ssl_ctx);
+        auto response = _downloadHTTPS_once(downloadUrl, head, deadline, extraHeaders);
+        if (!_isThrottled(response)) return response;
+
+        // give up
+        if (attempt >= settings.maxRetries) {
+            throw std::runtime_error("HTTPSDownloader : Throttled by [" + host + "], giving up after " + std::to_string(attempt) + " retries");
+        }
+
+        // wait at least what upstream asked for, pausing the whole host
+        backoff = _rateLimiter.nextBackoff(backoff);
+        auto delay = std::max(backoff, _retryAfter(response));
+        _rateLimiter.penalize(host, delay);
+        _rateLimiter.countRetry(host);
+
+        spdlog::warn("HTTPSDownloader : Throttled by [{}] ({}), retrying in {}ms...", host, response.statusCode, delay.count());
+    }
+}
+
+bool AudioTube::NetworkHelper::_isThrottled(const NetworkHelper::Response &response) {
+    return response.statusCode == 429 || response.statusCode == 503;
+}
+
+std::chrono::milliseconds AudioTube::NetworkHelper::_retryAfter(const NetworkHelper::Response &response) {
+    // only delta-seconds form is handled, HTTP-date falls back to backoff
+    auto seconds = safe_stoi(headerValue(response, "Retry-After"));
+    if (seconds < 0) return std::chrono::milliseconds(0);
+    return std::chrono::seconds(seconds);
+}
+
+std::string AudioTube::NetworkHelper::headerValue(const NetworkHelper::Response &response, const std::string_view &headerName) {
+    auto toLower = [](std::string str) {
+        std::transform(str.begin(), str.end(), str.begin(), ::tolower);
+        return str;
+    };
+    auto expected = toLower(std::string(headerName)) + ":";
+
+    for (const auto &header : response.headers) {
+        if (header.size() < expected.size()) continue;
+
+        // case insensitive name
+        if (toLower(header.substr(0, expected.size())) != expected) continue;
+
+        return trimmed(header.substr(expected.size()));
+    }
+
+    return std::string();
+}
+
+uint64_t AudioTube::NetworkHelper::contentRangeTotal(const NetworkHelper::Response &response) {
+    auto contentRange = headerValue(response, "Content-Range");
+    auto slash = contentRange.find('/');
+    if (slash == std::string::npos) return 0;
+
+    uint64_t totalSize = 0;
+    auto result = std::from_chars(contentRange.data() + slash + 1, contentRange.data() + contentRange.size(), totalSize);
+    return result.ec == std::errc() ? totalSize : 0;
+}
+
+std::optional<AudioTube::NetworkHelper::ByteRange> AudioTube::NetworkHelper::byteRangeFrom(const std::string_view &range) {
+    auto dash = range.find('-');
+    if (dash == std::string_view::npos) return std::nullopt;
+
+    ByteRange out;
+    auto first = std::from_chars(range.data(), range.data() + dash, out.first);
+    auto last = std::from_chars(range.data() + dash + 1, range.data() + range.size(), out.last);
+    if (first.ec != std::errc() || last.ec != std::errc() || out.last < out.first) return std::nullopt;
+    return out;
+}
+
+AudioTube::NetworkHelper::Response AudioTube::NetworkHelper::downloadRange(const std::string &downloadUrl, const ByteRange &range, const Deadline &deadline) {
+    std::vector<std::string> rangeHeader {
+        "Range: bytes=" + std::to_string(range.first) + "-" + std::to_string(range.last)
+    };
+
+    auto url = downloadUrl;
+    for (unsigned int redirects = 0; redirects <= MaxRedirects; redirects++) {
+        auto response = downloadHTTPS(url, false, deadline, rangeHeader);
+        if (response.redirectUrl.empty()) {
+            if (url != downloadUrl) response.redirectUrl = url;
+            return response;
+        }
+
+        url = trimmed(response.redirectUrl);
+    }
+
+    throw std::runtime_error("HTTPSDownloader : Too many redirects for [" + downloadUrl + "]");
+}
+
+void AudioTube::NetworkHelper::_await(asio::io_context &ioContext, _PendingOp* op, const Deadline::Clock::time_point &limit,
+                                        const Deadline &deadline, const std::string &what, const std::function<void()> &abort) {
+    ioContext.restart();
+
+    while (!op->done) {
+        auto now = Deadline::Clock::now();
+        auto cancelled = deadline.isCancelled();
+
+        if (cancelled || now >= limit) {
+            // abort pending operation and let its handler complete
+            abort();
+            ioContext.run();
+
+            if (cancelled) throw CancelledError("HTTPSDownloader : " + what + " cancelled");
+            throw DeadlineExceededError("HTTPSDownloader : " + what + " timed out");
+        }
+
+        // wake up regularly to check for cancellation
+        ioContext.run_one_for(std::min<Deadline::Clock::duration>(limit - now, _cancellationPollInterval));
+    }
+}
+
+std::vector<tcp::endpoint> AudioTube::NetworkHelper::_connectionOrder(const std::vector<tcp::endpoint> &resolved) {
+    // interleave address families, IPv6 first
+    std::vector<tcp::endpoint> v6, v4, ordered;
+    for (const auto &endpoint : resolved) {
+        (endpoint.address().is_v6() ? v6 : v4).push_back(endpoint);
+    }
+    for (size_t i = 0; i < std::max(v6.size(), v4.size()); i++) {
+        if (i < v6.size()) ordered.push_back(v6[i]);
+        if (i < v4.size()) ordered.push_back(v4[i]);
+    }
+
+    return ordered;
+}
+
+tcp::socket AudioTube::NetworkHelper::_raceConnect(asio::io_context &ioContext, const std::vector<tcp::endpoint> &resolved,
+                                                    const Deadline::Clock::time_point &limit, const Deadline &deadline, const std::string &serverName) {
+    auto ordered = _connectionOrder(resolved);
+    if (ordered.empty()) throw std::runtime_error("HTTPSDownloader : No endpoint found for [" + serverName + "]");
+
+    // race state
+    std::vector<std::unique_ptr<tcp::socket>> attempts;
+    std::optional<size_t> winner;
+    auto aborted = false;
+    size_t failures = 0;
+    asio::error_code lastError;
+    asio::steady_timer stagger(ioContext);
+    _PendingOp racing;
+
+    auto closeAllBut = [&](const std::optional<size_t> &spared) {
+        stagger.cancel();
+        for (size_t i = 0; i < attempts.size(); i++) {
+            if (spared && i == *spared) continue;
+            asio::error_code ignored;
+            attempts[i]->close(ignored);
+        }
+    };
+
+    // start next attempt, and schedule the one after if this one is too slow
+    std::function<void()> startNext = [&]() {
+        if (aborted || winner || attempts.size() == ordered.size()) return;
+
+        auto index = attempts.size();
+        attempts.push_back(std::make_unique<tcp::socket>(ioContext));
+        attempts[index]->async_connect(ordered[index], [&, index](const asio::error_code &ec) {
+            if (aborted || winner || racing.done) return;
+
+            // failed, try next one right away
+            if (ec) {
+                lastError = ec;
+                failures++;
+                if (failures == ordered.size()) {
+                    racing.handler()(lastError);
+                } else {
+                    startNext();
+                }
+                return;
+            }
+
+            // won, cancel others
+            winner = index;
+            closeAllBut(winner);
+            racing.handler()(ec);
+        });
+
+        stagger.expires_after(_connectionAttemptDelay);
+        stagger.async_wait([&](const asio::error_code &ec) {
+            if (!ec && !aborted) startNext();
+        });
+    };
+
+    startNext();
+    // once aborted, attempts completing with operation_aborted must not start new ones
+    _await(ioContext, &racing, limit, deadline, "Connecting to [" + serverName + "]", [&]() {
+        aborted = true;
+        closeAllBut(std::nullopt);
+    });
+
+    // let cancelled attempts complete before state goes out of scope
+    ioContext.restart();
+    ioContext.run();
+
+    if (!winner) throw asio::system_error(lastError);
+
+    spdlog::debug("HTTPSDownloader : Connected to [{}] through {}", serverName, ordered[*winner].address().to_string());
+    return std::move(*attempts[*winner]);
+}
+
+tcp::socket AudioTube::NetworkHelper::_connect(asio::io_context &io_context, const UrlParser &url, const Deadline &deadline) {
+    auto serverName = url.hostName();
 
     // setup Resolver
-    tcp::resolver resolver(io_service);
-    tcp::resolver::query query(serverName, scheme);
-    tcp::resolver::iterator endpoint_iterator = resolver.resolve(query);
-    tcp::resolver::iterator end;
+    auto connectLimit = deadline.phaseLimit(Deadline::Phase::Connect);
+    tcp::resolver resolver(io_context);
+    tcp::resolver::results_type endpoints;
+
+    _PendingOp resolving;
+    resolver.async_resolve(serverName, url.service(), [&](const asio::error_code &ec, const tcp::resolver::results_type &results) {
+        endpoints = results;
+        resolving.handler()(ec);
+    });
+    _await(io_context, &resolving, connectLimit, deadline, "Resolving [" + serverName + "]", [&resolver]() { resolver.cancel(); });
+    if (resolving.ec) throw asio::system_error(resolving.ec);
 
     // Connect to host
-    asio::connect(ssl_sock.lowest_layer(), resolver.resolve(query));
-    ssl_sock.lowest_layer().set_option(tcp::no_delay(true));
+    std::vector<tcp::endpoint> resolved;
+    for (const auto &entry : endpoints) resolved.push_back(entry.endpoint());
+    auto socket = _raceConnect(io_context, resolved, connectLimit, deadline, serverName);
+    socket.set_option(tcp::no_delay(true));
+    return socket;
+}
 
+void AudioTube::NetworkHelper::_handshake(asio::io_context &io_context, ssl::stream<tcp::socket> &ssl_sock, const std::string &serverName, const Deadline &deadline) {
     // Perform SSL handshake and verify the remote host's certificate.
     // TODO(amphaal) might need to implement https://stackoverflow.com/questions/39772878/reliable-way-to-get-root-ca-certificates-on-windows
     // ssl_sock.set_verify_mode(ssl::verify_peer);
     // ssl_sock.set_verify_callback(ssl::rfc2818_verification(serverName));
     ssl_sock.set_verify_mode(ssl::verify_none);
-    ssl_sock.handshake(ssl::stream<tcp::socket>::client);
+
+    _PendingOp handshaking;
+    ssl_sock.async_handshake(ssl::stream<tcp::socket>::client, handshaking.handler());
+    _await(io_context, &handshaking, deadline.phaseLimit(Deadline::Phase::TLS), deadline, "TLS handshake with [" + serverName + "]", [&ssl_sock]() {
+        asio::error_code ignored;
+        ssl_sock.lowest_layer().close(ignored);
+    });
+    if (handshaking.ec) throw asio::system_error(handshaking.ec);
+}
+
+AudioTube::NetworkHelper::Response AudioTube::NetworkHelper::_downloadHTTPS_once(const std::string &downloadUrl, bool head, const Deadline &deadline, const std::vector<std::string> &extraHeaders) {
+    // decompose url
+    UrlParser url_decomposer(downloadUrl);
+
+    // setup service
+    asio::io_context io_context;
+    auto socket = _connect(io_context, url_decomposer, deadline);
+
+    // plain HTTP, eg. local servers
+    if (url_decomposer.scheme() == "http") {
+        return _exchange(io_context, socket, url_decomposer, head, deadline, extraHeaders);
+    }
+
+    // setup SSL
+    ssl::context ssl_ctx(ssl::context::sslv23);
+    ssl_ctx.set_default_verify_paths();
+    asio::ssl::stream<tcp::socket> ssl_sock(io_context, ssl_ctx);
+    ssl_sock.next_layer() = std::move(socket);
+    _handshake(io_context, ssl_sock, url_decomposer.hostName(), deadline);
+
+    return _exchange(io_context, ssl_sock, url_decomposer, head, deadline, extraHeaders);
+}
+
+template<typename Stream>
+void AudioTube::NetworkHelper::_sendRequest(asio::io_context &io_context, Stream &stream, const UrlParser &url,
+                                                bool head, const Deadline &deadline, const std::vector<std::string> &extraHeaders, bool keepAlive) {
+    auto serverName = url.host();
 
     // start writing
     asio::streambuf request;
@@ -55,19 +303,26 @@ AudioTube::NetworkHelper::Response AudioTube::NetworkHelper::downloadHTTPS(const
 
     auto method = head ? "HEAD" : "GET";
 
-    request_stream << method << " " << getCommand << " HTTP/1.0\r\n";
+    request_stream << method << " " << url.pathAndQuery() << (keepAlive ? " HTTP/1.1\r\n" : " HTTP/1.0\r\n");
     request_stream << "Host: " << serverName << "\r\n";
     request_stream << "Accept: */*\r\n";
-    request_stream << "Connection: close\r\n\r\n";
+    for (const auto &header : extraHeaders) request_stream << header << "\r\n";
+    request_stream << (keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n");
 
-    if(!head) spdlog::debug("HTTPSDownloader : Downloading [{}]...", downloadUrl);
-
-    // Send the request.
-    asio::write(ssl_sock, request);
+    _PendingOp writing;
+    asio::async_write(stream, request, writing.handler());
+    _await(io_context, &writing, deadline.phaseLimit(Deadline::Phase::FirstByte), deadline, "Sending request to [" + serverName + "]", _closer(stream));
+    if (writing.ec) throw asio::system_error(writing.ec);
+}
 
-    // Read the response status line.
-    asio::streambuf response;
-    asio::read_until(ssl_sock, response, "\r\n");
+template<typename Stream>
+AudioTube::NetworkHelper::Response AudioTube::NetworkHelper::_readHead(asio::io_context &io_context, Stream &stream, asio::streambuf &response,
+                                                                        const std::string &serverName, const Deadline &deadline) {
+    // read the response status line.
+    _PendingOp readingStatus;
+    asio::async_read_until(stream, response, "\r\n", readingStatus.handler());
+    _await(io_context, &readingStatus, deadline.phaseLimit(Deadline::Phase::FirstByte), deadline, "Waiting for [" + serverName + "]", _closer(stream));
+    if (readingStatus.ec) throw asio::system_error(readingStatus.ec);
 
         // Check that response is OK.
         std::istream response_stream(&response);
@@ -85,32 +340,50 @@ AudioTube::NetworkHelper::Response AudioTube::NetworkHelper::downloadHTTPS(const
         std::getline(response_stream, status_message);
 
     // Read the response headers, which are terminated by a blank line.
-    asio::read_until(ssl_sock, response, "\r\n\r\n");
+    _PendingOp readingHeaders;
+    asio::async_read_until(stream, response, "\r\n\r\n", readingHeaders.handler());
+    _await(io_context, &readingHeaders, deadline.expiresAt(), deadline, "Reading headers from [" + serverName + "]", _closer(stream));
+    if (readingHeaders.ec) throw asio::system_error(readingHeaders.ec);
 
     // Process the response headers.
     std::string headerTmp;
-    std::vector<std::string> headers;
-    bool hasContentLengthHeader = false;
-    std::string redirectUrl;
+    AudioTube::NetworkHelper::Response outResponse;
+    outResponse.statusCode = status_code;
 
     // iterate to get headers
     while (std::getline(response_stream, headerTmp) && headerTmp != "\r") {
-        headers.push_back(headerTmp);
+        outResponse.headers.push_back(headerTmp);
 
         //
-        if (!hasContentLengthHeader) {
-            hasContentLengthHeader = headerTmp.find("Content-Length") != std::string::npos;
+        if (!outResponse.hasContentLengthHeader) {
+            outResponse.hasContentLengthHeader = headerTmp.find("Content-Length") != std::string::npos;
         }
 
         // find redirection url
-        if(status_code == 302 && redirectUrl.empty()) {
+        if(status_code == 302 && outResponse.redirectUrl.empty()) {
             auto found = headerTmp.find(LocationTag);
             if(found == std::string::npos) continue;
-            redirectUrl = headerTmp.substr(found + LocationTag.size());
+            outResponse.redirectUrl = trimmed(headerTmp.substr(found + LocationTag.size()));
         }
     }
 
-    if(!headers.size()) throw std::logic_error("HTTPSDownloader : Response have no headers !");
+    if(!outResponse.headers.size()) throw std::logic_error("HTTPSDownloader : Response have no headers !");
+
+    return outResponse;
+}
+
+template<typename Stream>
+AudioTube::NetworkHelper::Response AudioTube::NetworkHelper::_exchange(asio::io_context &io_context, Stream &stream, const UrlParser &url,
+                                                                        bool head, const Deadline &deadline, const std::vector<std::string> &extraHeaders) {
+    auto downloadUrl = url.scheme() + "://" + url.host() + url.pathAndQuery();
+
+    if(!head) spdlog::debug("HTTPSDownloader : Downloading [{}]...", downloadUrl);
+
+    // Send the request, then read the response status line and headers
+    _sendRequest(io_context, stream, url, head, deadline, extraHeaders);
+
+    asio::streambuf response;
+    auto outResponse = _readHead(io_context, stream, response, url.host(), deadline);
 
     // if not HEAD, read body message
     std::ostringstream output_stream;
@@ -120,30 +393,54 @@ AudioTube::NetworkHelper::Response AudioTube::NetworkHelper::downloadHTTPS(const
             output_stream << &response;
         }
         // Read until EOF, writing data to output as we go.
-        asio::error_code error;
-        while (asio::read(ssl_sock, response, asio::transfer_at_least(1), error)) {
+        while (true) {
+            _PendingOp readingBody;
+            asio::async_read(stream, response, asio::transfer_at_least(1), readingBody.handler());
+            _await(io_context, &readingBody, deadline.expiresAt(), deadline, "Downloading [" + downloadUrl + "]", _closer(stream));
+            if (readingBody.ec) break;
             output_stream << &response;
         }
     }
 
     spdlog::debug("HTTPSDownloader : Finished downloading [{}]", downloadUrl);
 
-    AudioTube::NetworkHelper::Response outResponse {
-        output_stream.str(),
-        headers,
-        hasContentLengthHeader,
-        status_code,
-        redirectUrl
-    };
+    outResponse.messageBody = output_stream.str();
 
     spdlog::debug("HTTPSDownloader : Response length {}, headers {}", outResponse.messageBody.size(), outResponse.headers.size());
 
     return outResponse;
 }
 
-promise::Promise AudioTube::NetworkHelper::promise_dl_HTTPS(const std::string &downloadUrl, bool head) {
+// used by HTTPStream
+template void AudioTube::NetworkHelper::_sendRequest(asio::io_context&, tcp::socket&, const UrlParser&, bool, const Deadline&, const std::vector<std::string>&, bool);
+template void AudioTube::NetworkHelper::_sendRequest(asio::io_context&, ssl::stream<tcp::socket>&, const UrlParser&, bool, const Deadline&, const std::vector<std::string>&, bool);
+template AudioTube::NetworkHelper::Response AudioTube::NetworkHelper::_readHead(asio::io_context&, tcp::socket&, asio::streambuf&, const std::string&, const Deadline&);
+template AudioTube::NetworkHelper::Response AudioTube::NetworkHelper::_readHead(asio::io_context&, ssl::stream<tcp::socket>&, asio::streambuf&, const std::string&, const Deadline&);
+
+promise::Promise AudioTube::NetworkHelper::promise_dl_HTTPS(const std::string &downloadUrl, bool head, const Deadline &deadline) {
     return promise::newPromise([=](promise::Defer d) {
-        auto response = downloadHTTPS(downloadUrl, head);
+        if (head) {
+            d.resolve(downloadHTTPS(downloadUrl, head, deadline).messageBody);
+            return;
+        }
+
+        // identical in-flight GETs share the same download
+        auto coalesced = [=]() {
+            return _inflightDownloads.run(downloadUrl, [=]() { return downloadHTTPS(downloadUrl, false, deadline); }, deadline);
+        };
+
+        // shared download might have been cancelled by someone else or run out of its time, retry on our own if we did not
+        NetworkHelper::Response response;
+        try {
+            response = coalesced();
+        } catch(const CancelledError &) {
+            if (deadline.isOver()) throw;
+            response = coalesced();
+        } catch(const DeadlineExceededError &) {
+            if (deadline.isOver()) throw;
+            response = coalesced();
+        }
+
         d.resolve(response.messageBody);
     });
 }
@@ -0,0 +1,98 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Parsing time of recorded player responses (ytInitialPlayerResponse JSON, one per file),
+// for each JSON backend built in.
+// usage : audiotube_bench_player_response <response.json>... [iterations]
+
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+#include <audiotube/PlayerResponse.h>
+
+int main(int argc, char** argv) {
+    std::vector<std::string> responses;
+    size_t iterations = 200;
+
+    for (int i = 1; i < argc; i++) {
+        std::ifstream file(argv[i], std::ios::binary);
+        if (!file) {
+            // trailing number is the iteration count
+            iterations = std::strtoul(argv[i], nullptr, 10);
+            continue;
+        }
+
+        std::stringstream content;
+        content << file.rdbuf();
+        responses.push_back(content.str());
+    }
+
+    if (responses.empty() || !iterations) {
+        spdlog::error("usage : audiotube_bench_player_response <response.json>... [iterations]");
+        return 1;
+    }
+
+    size_t totalBytes = 0;
+    for (const auto &response : responses) totalBytes += response.size();
+    spdlog::info("{} response(s), {:.1f} KiB, {} iterations", responses.size(), totalBytes / 1024.0, iterations);
+
+    using Backend = AudioTube::PlayerResponseParser::Backend;
+    std::vector<std::pair<Backend, const char*>> backends {
+        { Backend::Nlohmann, "nlohmann SAX" },
+        { Backend::Simdjson, "simdjson On-Demand" }
+    };
+
+    // reference results, to check backends agree
+    std::vector<AudioTube::PlayerResponse> expected;
+    for (const auto &response : responses) {
+        expected.push_back(AudioTube::PlayerResponseParser::parse(response, Backend::Nlohmann));
+    }
+
+    for (const auto &[backend, name] : backends) {
+        if (!AudioTube::PlayerResponseParser::isAvailable(backend)) {
+            spdlog::info("{} : not built in", name);
+            continue;
+        }
+
+        size_t formats = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            for (const auto &response : responses) {
+                formats += AudioTube::PlayerResponseParser::parse(response, backend).audioFormats.size();
+            }
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        auto agrees = true;
+        for (size_t i = 0; i < responses.size(); i++) {
+            auto parsed = AudioTube::PlayerResponseParser::parse(responses[i], backend);
+            agrees &= parsed.title == expected[i].title
+                && parsed.expiresInSeconds == expected[i].expiresInSeconds
+                && parsed.audioFormats.size() == expected[i].audioFormats.size();
+        }
+
+        auto perResponse = elapsed.count() * 1e6 / (iterations * responses.size());
+        spdlog::info("{} : {:.1f} MiB/s, {:.1f} us per response ({} formats){}",
+            name, totalBytes * iterations / (1024.0 * 1024.0) / elapsed.count(), perResponse, formats / iterations, agrees ? "" : " [MISMATCH]");
+        if (!agrees) return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,99 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Throughput of SegmentedDownloader against a local range-capable server,
+// which throttles each connection like a streaming CDN would.
+// usage : audiotube_bench_segmented [payloadMiB] [perConnectionKiBps]
+
+#include <asio.hpp>
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+#include <thread>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+
+#include <audiotube/SegmentedDownloader.h>
+
+#include "sub/server.hpp"
+
+// answers "Range: bytes=first-last" GETs over payload, body throttled on each connection
+server_test::LocalServer::Handler throttledRanges(const std::vector<char> &payload, size_t bytesPerSecond) {
+    return [&payload, bytesPerSecond](asio::ip::tcp::socket &socket, const std::string &headers) {
+        uint64_t first = 0, last = payload.size() - 1;
+        auto rangePos = headers.find("Range: bytes=");
+        if (rangePos != std::string::npos) {
+            std::sscanf(headers.c_str() + rangePos, "Range: bytes=%llu-%llu",
+                reinterpret_cast<unsigned long long*>(&first), reinterpret_cast<unsigned long long*>(&last));
+        }
+        last = std::min<uint64_t>(last, payload.size() - 1);
+
+        auto head = std::string("HTTP/1.0 206 Partial Content\r\n")
+            + "Content-Length: " + std::to_string(last - first + 1) + "\r\n"
+            + "Content-Range: bytes " + std::to_string(first) + "-" + std::to_string(last) + "/" + std::to_string(payload.size()) + "\r\n"
+            + "Connection: close\r\n\r\n";
+        if (!server_test::reply(socket, head)) return false;
+
+        // throttled body, in 10ms slices
+        asio::error_code ec;
+        auto slice = std::max<size_t>(1, bytesPerSecond / 100);
+        for (auto offset = first; offset <= last && !ec; offset += slice) {
+            auto length = std::min<uint64_t>(slice, last - offset + 1);
+            asio::write(socket, asio::buffer(payload.data() + offset, length), ec);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        return false;
+    };
+}
+
+int main(int argc, char** argv) {
+    size_t payloadMiB = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 32;
+    size_t perConnectionKiBps = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 4096;
+
+    std::vector<char> payload(payloadMiB * 1024 * 1024);
+    for (size_t i = 0; i < payload.size(); i++) payload[i] = static_cast<char>(i * 31 + (i >> 13));
+
+    server_test::LocalServer server(throttledRanges(payload, perConnectionKiBps * 1024));
+    auto url = server.url("/audio.webm");
+
+    // local server, do not throttle ourselves
+    auto limits = AudioTube::NetworkHelper::rateLimiter().settings();
+    limits.requestsPerSecond = 1000;
+    limits.burst = 1000;
+    AudioTube::NetworkHelper::rateLimiter().setSettings(limits);
+
+    spdlog::info("Payload : {} MiB, {} KiB/s per connection", payloadMiB, perConnectionKiBps);
+
+    for (auto connections : { 1u, 2u, 4u, 8u }) {
+        AudioTube::SegmentedDownloader::Settings settings;
+        settings.connections = connections;
+
+        AudioTube::SegmentedDownloader downloader(url, settings);
+        std::vector<char> buffer;
+
+        auto start = std::chrono::steady_clock::now();
+        downloader.downloadTo(&buffer);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        auto intact = buffer == payload;
+        spdlog::info("{} connection(s) : {:.2f} MiB/s ({:.2f}s){}",
+            connections, payloadMiB / elapsed.count(), elapsed.count(), intact ? "" : " [CORRUPTED]");
+        if (!intact) return 1;
+    }
+
+    return 0;
+}
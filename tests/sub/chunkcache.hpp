@@ -0,0 +1,107 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <audiotube/ChunkCache.h>
+
+#include <filesystem>
+#include <string>
+
+#include <catch2/catch.hpp>
+
+TEST_CASE("Chunk cache - LRU eviction and persistence", "[cache]") {
+  using AudioTube::ChunkCache;
+
+  auto directory = (std::filesystem::temp_directory_path() / "audiotube_chunkcache_test").string();
+  std::filesystem::remove_all(directory);
+
+  ChunkCache::Settings settings;
+  settings.directory = directory;
+  settings.chunkSize = 16;
+  settings.diskBudget = 64;  // 4 chunks
+  settings.chunksPerSegment = 2;
+
+  {
+    ChunkCache cache(settings);
+    REQUIRE(cache.put({"MnoajJelaAo", 251, 0}, "0123456789abcdef", 16));
+    REQUIRE(cache.put({"MnoajJelaAo", 251, 1}, "xyz", 3));
+    REQUIRE(cache.put({"bWm2M6gk2bE", 251, 0}, "b0", 2));
+    REQUIRE(cache.put({"bWm2M6gk2bE", 251, 1}, "b1", 2));
+
+    // too big
+    REQUIRE_FALSE(cache.put({"bWm2M6gk2bE", 251, 2}, "0123456789abcdefg", 17));
+
+    // served from mapping, and now most recent
+    {
+      auto view = cache.get({"MnoajJelaAo", 251, 0});
+      REQUIRE(view);
+      REQUIRE(std::string(view->data(), view->size()) == "0123456789abcdef");
+    }
+
+    // full, least recent goes away
+    REQUIRE(cache.put({"wvHEYLk4IbE", 251, 0}, "c0", 2));
+    REQUIRE_FALSE(cache.contains({"MnoajJelaAo", 251, 1}));
+    REQUIRE(cache.contains({"MnoajJelaAo", 251, 0}));
+    REQUIRE(cache.stats().evictions == 1);
+  }
+
+  // index survives
+  {
+    ChunkCache cache(settings);
+    REQUIRE(cache.stats().chunks == 4);
+    REQUIRE(cache.contains({"wvHEYLk4IbE", 251, 0}));
+
+    auto view = cache.get({"MnoajJelaAo", 251, 0});
+    REQUIRE(view);
+    REQUIRE(std::string(view->data(), view->size()) == "0123456789abcdef");
+  }
+
+  std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("Chunk cache - never serves overwritten slots after a crash", "[cache]") {
+  using AudioTube::ChunkCache;
+
+  auto directory = (std::filesystem::temp_directory_path() / "audiotube_chunkcache_crash_test").string();
+  std::filesystem::remove_all(directory);
+  auto indexPath = std::filesystem::path(directory) / "index";
+
+  ChunkCache::Settings settings;
+  settings.directory = directory;
+  settings.chunkSize = 4;
+  settings.diskBudget = 8;  // 2 chunks
+  settings.chunksPerSegment = 2;
+
+  {
+    // never destroyed, as if process crashed
+    auto crashed = new ChunkCache(settings);
+    REQUIRE(crashed->put({"MnoajJelaAo", 251, 0}, "aaaa", 4));
+    REQUIRE(crashed->put({"MnoajJelaAo", 251, 1}, "bbbb", 4));
+    crashed->flush();
+    REQUIRE(std::filesystem::exists(indexPath));
+
+    // reusing a slot invalidates flushed index
+    REQUIRE(crashed->put({"bWm2M6gk2bE", 251, 0}, "cccc", 4));
+    REQUIRE_FALSE(std::filesystem::exists(indexPath));
+  }
+
+  {
+    ChunkCache cache(settings);
+    REQUIRE(cache.stats().chunks == 0);
+    REQUIRE_FALSE(cache.get({"MnoajJelaAo", 251, 0}));
+  }
+
+  std::filesystem::remove_all(directory);
+}
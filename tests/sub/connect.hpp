@@ -0,0 +1,129 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+
+#pragma once
+
+#include <asio.hpp>
+
+#include <audiotube/_NetworkHelper.h>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace connect_test {
+
+// exposes connection racing
+class Racer : public AudioTube::NetworkHelper {
+ public:
+  using AudioTube::NetworkHelper::_connectionOrder;
+  using AudioTube::NetworkHelper::_raceConnect;
+};
+
+// listener whose accept queue is full and never drained : further connection attempts hang
+class Blackhole {
+ public:
+  Blackhole() : _acceptor(_ioContext) {
+    asio::ip::tcp::endpoint endpoint(asio::ip::address_v4::loopback(), 0);
+    this->_acceptor.open(endpoint.protocol());
+    this->_acceptor.bind(endpoint);
+    this->_acceptor.listen(0);
+
+    this->_filler.connect(this->endpoint());
+  }
+
+  asio::ip::tcp::endpoint endpoint() const {
+    return this->_acceptor.local_endpoint();
+  }
+
+ private:
+  asio::io_context _ioContext;
+  asio::ip::tcp::acceptor _acceptor;
+  asio::ip::tcp::socket _filler { _ioContext };
+};
+
+// port nothing listens on anymore
+inline asio::ip::tcp::endpoint refusedEndpoint() {
+  asio::io_context ioContext;
+  asio::ip::tcp::acceptor acceptor(ioContext, asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0));
+  return acceptor.local_endpoint();
+}
+
+inline AudioTube::Deadline connectDeadline(int connectMs, const AudioTube::CancellationToken &token = AudioTube::CancellationToken()) {
+  AudioTube::Deadline::Timeouts timeouts;
+  timeouts.connect = std::chrono::milliseconds(connectMs);
+  return AudioTube::Deadline(timeouts, token);
+}
+
+}  // namespace connect_test
+
+TEST_CASE("Connection attempts alternate address families, IPv6 first", "[connect]") {
+  auto v4 = [](int port) { return asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), port); };
+  auto v6 = [](int port) { return asio::ip::tcp::endpoint(asio::ip::address_v6::loopback(), port); };
+
+  auto ordered = connect_test::Racer::_connectionOrder({ v4(1), v4(2), v4(3), v6(4) });
+  std::vector<asio::ip::tcp::endpoint> expected { v6(4), v4(1), v4(2), v4(3) };
+  REQUIRE(ordered == expected);
+}
+
+TEST_CASE("Connection race falls back on next endpoint", "[connect]") {
+  asio::io_context ioContext;
+  asio::ip::tcp::acceptor listener(ioContext, asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0));
+  connect_test::Blackhole blackhole;
+
+  std::vector<asio::ip::tcp::endpoint> endpoints { connect_test::refusedEndpoint(), blackhole.endpoint(), listener.local_endpoint() };
+  auto deadline = connect_test::connectDeadline(5000);
+
+  auto socket = connect_test::Racer::_raceConnect(ioContext, endpoints, deadline.phaseLimit(AudioTube::Deadline::Phase::Connect), deadline, "localhost");
+  REQUIRE(socket.is_open());
+  REQUIRE(socket.remote_endpoint() == listener.local_endpoint());
+}
+
+TEST_CASE("Connection race stops once timed out", "[connect]") {
+  asio::io_context ioContext;
+  connect_test::Blackhole blackhole;
+  std::vector<asio::ip::tcp::endpoint> endpoints(20, blackhole.endpoint());
+  auto deadline = connect_test::connectDeadline(300);
+
+  auto start = std::chrono::steady_clock::now();
+  REQUIRE_THROWS_AS(
+    connect_test::Racer::_raceConnect(ioContext, endpoints, deadline.phaseLimit(AudioTube::Deadline::Phase::Connect), deadline, "localhost"),
+    AudioTube::DeadlineExceededError);
+  REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(2));
+}
+
+TEST_CASE("Connection race stops once cancelled", "[connect]") {
+  asio::io_context ioContext;
+  connect_test::Blackhole blackhole;
+  std::vector<asio::ip::tcp::endpoint> endpoints(20, blackhole.endpoint());
+
+  AudioTube::CancellationSource source;
+  auto deadline = connect_test::connectDeadline(60000, source.token());
+  std::thread canceller([&source]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    source.cancel();
+  });
+
+  auto start = std::chrono::steady_clock::now();
+  REQUIRE_THROWS_AS(
+    connect_test::Racer::_raceConnect(ioContext, endpoints, deadline.phaseLimit(AudioTube::Deadline::Phase::Connect), deadline, "localhost"),
+    AudioTube::CancelledError);
+  REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(2));
+
+  canceller.join();
+}
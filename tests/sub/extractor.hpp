@@ -0,0 +1,154 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <audiotube/PlayerResponseExtractor.h>
+#include <audiotube/PlayerResponse.h>
+
+#include <catch2/catch.hpp>
+
+TEST_CASE("Player response selective extraction", "[json]") {
+  using AudioTube::PlayerResponseExtractor;
+
+  auto extracted = PlayerResponseExtractor::extract(R"({
+    "responseContext": { "serviceTrackingParams": [ { "service": "GFEEDBACK", "params": [ { "key": "k", "value": "v" } ] } ] },
+    "playabilityStatus": { "status": "OK", "miniplayer": { "miniplayerRenderer": { "playbackMode": "PLAYBACK_MODE_ALLOW" } } },
+    "streamingData": {
+      "expiresInSeconds": "21540",
+      "formats": [ { "itag": 18, "mimeType": "video/mp4" } ],
+      "adaptiveFormats": [
+        { "itag": 248, "mimeType": "video/webm; codecs=\"vp9\"", "bitrate": 2000000 },
+        { "itag": 251, "mimeType": "audio/webm; codecs=\"opus\"", "bitrate": 141000, "initRange": { "start": "0", "end": "265" } },
+        { "bitrate": 1 },
+        { "itag": 140, "mimeType": "audio/mp4; codecs=\"mp4a.40.2\"", "bitrate": 130000 }
+      ],
+      "dashManifestUrl": "https://host/dash"
+    },
+    "videoDetails": { "title": "T", "lengthSeconds": "212", "isLiveContent": false, "keywords": [ "a", "b" ], "thumbnail": { "thumbnails": [ { "url": "u" } ] } },
+    "microformat": { "playerMicroformatRenderer": { "title": { "simpleText": "T" } } }
+  })");
+
+  // only what schema asked for
+  REQUIRE(extracted.size() == 3);
+  REQUIRE_FALSE(extracted.contains("responseContext"));
+  REQUIRE_FALSE(extracted.contains("microformat"));
+
+  REQUIRE(extracted["playabilityStatus"]["status"] == "OK");
+  REQUIRE(extracted["playabilityStatus"]["miniplayer"]["miniplayerRenderer"]["playbackMode"] == "PLAYBACK_MODE_ALLOW");
+
+  const auto &videoDetails = PlayerResponseExtractor::field(extracted, "videoDetails");
+  REQUIRE(videoDetails["title"] == "T");
+  REQUIRE(videoDetails["isLiveContent"] == false);
+  REQUIRE(videoDetails["keywords"].size() == 2);
+  REQUIRE(videoDetails["thumbnail"]["thumbnails"][0]["url"] == "u");
+
+  const auto &streamingData = PlayerResponseExtractor::field(extracted, "streamingData");
+  REQUIRE(streamingData.size() == 3);
+  REQUIRE(streamingData["expiresInSeconds"] == "21540");
+  REQUIRE(streamingData["dashManifestUrl"] == "https://host/dash");
+
+  // audio formats only
+  const auto &formats = streamingData["adaptiveFormats"];
+  REQUIRE(formats.size() == 2);
+  REQUIRE(formats[0]["itag"] == 251);
+  REQUIRE(formats[0]["initRange"]["end"] == "265");
+  REQUIRE(formats[1]["itag"] == 140);
+
+  REQUIRE(PlayerResponseExtractor::field(extracted, "missing").is_null());
+  REQUIRE(PlayerResponseExtractor::field(formats, "itag").is_null());
+
+  REQUIRE_THROWS(PlayerResponseExtractor::extract(R"({ "videoDetails": { "title": )"));
+}
+
+TEST_CASE("Player response backends agree", "[json]") {
+  using AudioTube::PlayerResponseParser;
+
+  auto raw = R"({
+    "responseContext": { "serviceTrackingParams": [ { "service": "GFEEDBACK" } ] },
+    "videoDetails": { "title": "T \u00e9", "lengthSeconds": "212", "isLiveContent": false, "keywords": [ "a" ] },
+    "playabilityStatus": { "status": "LOGIN_REQUIRED", "reason": "Sign in" },
+    "streamingData": {
+      "expiresInSeconds": "21540",
+      "adaptiveFormats": [
+        { "itag": 248, "mimeType": "video/webm; codecs=\"vp9\"", "bitrate": 2000000 },
+        { "itag": 251, "bitrate": 141000, "url": "https://host/251", "contentLength": "3433514",
+          "initRange": { "start": "0", "end": "265" }, "indexRange": { "start": "266", "end": "627" }, "mimeType": "audio/webm; codecs=\"opus\"" },
+        { "itag": 140, "mimeType": "audio/mp4; codecs=\"mp4a.40.2\"", "signatureCipher": "s=abc&url=https%3A%2F%2Fhost%2F140",
+          "audioSampleRate": "44100", "approxDurationMs": "212091", "initRange": { "start": "10", "end": "2" } }
+      ],
+      "dashManifestUrl": "https://host/dash"
+    }
+  })";
+
+  for (auto backend : { PlayerResponseParser::Backend::Nlohmann, PlayerResponseParser::Backend::Simdjson }) {
+    if (!PlayerResponseParser::isAvailable(backend)) {
+      REQUIRE_THROWS(PlayerResponseParser::parse(raw, backend));
+      continue;
+    }
+
+    auto parsed = PlayerResponseParser::parse(raw, backend);
+
+    REQUIRE(parsed.hasVideoDetails);
+    REQUIRE(parsed.title == "T \xc3\xa9");
+    REQUIRE(parsed.lengthSeconds == "212");
+    REQUIRE_FALSE(parsed.isLiveContent);
+
+    REQUIRE(parsed.playabilityStatus == "LOGIN_REQUIRED");
+    REQUIRE(parsed.playabilityReason.value_or("") == "Sign in");
+
+    REQUIRE(parsed.hasStreamingData);
+    REQUIRE(parsed.expiresInSeconds == "21540");
+    REQUIRE(parsed.dashManifestUrl == "https://host/dash");
+
+    // audio formats only, in document order
+    REQUIRE(parsed.audioFormats.size() == 2);
+    const auto &opus = parsed.audioFormats[0];
+    REQUIRE(opus.itag == 251);
+    REQUIRE(opus.bitrate == 141000);
+    REQUIRE(opus.url == "https://host/251");
+    REQUIRE(opus.contentLength == 3433514);
+    REQUIRE(opus.initRange->last == 265);
+    REQUIRE(opus.indexRange->first == 266);
+
+    const auto &aac = parsed.audioFormats[1];
+    REQUIRE(aac.url.empty());
+    REQUIRE(aac.cipher == "s=abc&url=https%3A%2F%2Fhost%2F140");
+    REQUIRE(aac.audioSampleRate == 44100);
+    REQUIRE(aac.approxDurationMs == 212091);
+    REQUIRE_FALSE(aac.initRange);
+
+    REQUIRE_THROWS(PlayerResponseParser::parse(R"({ "videoDetails": { "title": )", backend));
+  }
+}
+
+TEST_CASE("Player response backends prefer cipher over signatureCipher", "[json]") {
+  using AudioTube::PlayerResponseParser;
+
+  auto raw = R"({ "streamingData": { "adaptiveFormats": [
+    { "itag": 251, "mimeType": "audio/webm; codecs=\"opus\"", "cipher": "s=first", "signatureCipher": "s=second" },
+    { "itag": 140, "mimeType": "audio/mp4; codecs=\"mp4a.40.2\"", "signatureCipher": "s=second", "cipher": "s=first" }
+  ] } })";
+
+  for (auto backend : { PlayerResponseParser::Backend::Nlohmann, PlayerResponseParser::Backend::Simdjson }) {
+    if (!PlayerResponseParser::isAvailable(backend)) continue;
+
+    auto parsed = PlayerResponseParser::parse(raw, backend);
+
+    // whatever their order
+    REQUIRE(parsed.audioFormats.size() == 2);
+    REQUIRE(parsed.audioFormats[0].cipher == "s=first");
+    REQUIRE(parsed.audioFormats[1].cipher == "s=first");
+  }
+}
@@ -20,6 +20,7 @@
 #include <audiotube/NetworkFetcher.h>
 
 #include <chrono>
+#include <future>
 #include <thread>
 #include <string>
 
@@ -43,9 +44,15 @@ bool youtube_metadata_fetching_succeeded(const std::string &ytId) {
     if (container.hasFailed()) return false;
 
     // check if a stream is working
-    return AudioTube::NetworkFetcher::isStreamAvailable(&container);
+    return AudioTube::NetworkFetcher::isStreamAvailable(&container, false);
 }
 
+// exposes refresh strategy
+class StreamsOnlyProbe : public AudioTube::NetworkFetcher {
+ public:
+    using AudioTube::NetworkFetcher::_canRefreshStreamsOnly;
+};
+
 //
 // Test cases
 //
@@ -86,3 +93,41 @@ TEST_CASE("Restricted viewing - NOK from Embed, OK from Watch Page", "[metadata]
 TEST_CASE("Exact STS required - No DASH Manifest", "[metadata]") {
     REQUIRE(youtube_metadata_fetching_succeeded("lkkHtuTdIj4"));
 }
+
+TEST_CASE("Streams-only refresh, full refresh once failed", "[metadata]") {
+    AudioTube::VideoMetadata container("qyYFF3Eh6lw", AudioTube::VideoMetadata::InstantiationType::InstFromId);
+    REQUIRE_FALSE(StreamsOnlyProbe::_canRefreshStreamsOnly(&container, false));
+
+    AudioTube::NetworkFetcher::refreshMetadata(&container);
+    REQUIRE(container.ranOnce());
+    REQUIRE_FALSE(container.hasFailed());
+
+    // lightweight path only after a successful run
+    REQUIRE(StreamsOnlyProbe::_canRefreshStreamsOnly(&container, false));
+    REQUIRE_FALSE(StreamsOnlyProbe::_canRefreshStreamsOnly(&container, true));
+
+    AudioTube::NetworkFetcher::refreshMetadata(&container, true);
+    REQUIRE_FALSE(container.hasFailed());
+    REQUIRE(AudioTube::NetworkFetcher::isStreamAvailable(&container, false));
+
+    // falls back to whole pipeline
+    container.setFailure(true);
+    AudioTube::NetworkFetcher::refreshMetadata(&container, true);
+    REQUIRE_FALSE(container.hasFailed());
+    REQUIRE(AudioTube::NetworkFetcher::isStreamAvailable(&container, false));
+}
+
+TEST_CASE("Concurrent refreshes of the same video are settled on return", "[metadata]") {
+    AudioTube::VideoMetadata leader("qyYFF3Eh6lw", AudioTube::VideoMetadata::InstantiationType::InstFromId);
+    AudioTube::VideoMetadata follower("qyYFF3Eh6lw", AudioTube::VideoMetadata::InstantiationType::InstFromId);
+
+    // whichever leads, the other one waits for it in its own thread
+    auto first = std::async(std::launch::async, [&]() { AudioTube::NetworkFetcher::refreshMetadata(&leader); });
+    AudioTube::NetworkFetcher::refreshMetadata(&follower);
+    REQUIRE(follower.ranOnce());
+    REQUIRE_FALSE(follower.hasFailed());
+
+    first.get();
+    REQUIRE(leader.ranOnce());
+    REQUIRE_FALSE(leader.hasFailed());
+}
@@ -0,0 +1,200 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+
+#pragma once
+
+#include <asio.hpp>
+
+#include <audiotube/PrefetchBuffer.h>
+#include <audiotube/PlaylistPrefetcher.h>
+#include <audiotube/VideoMetadata.h>
+
+#include <chrono>
+#include <ctime>
+#include <string>
+#include <thread>
+
+#include "server.hpp"
+
+#include <catch2/catch.hpp>
+
+namespace prefetch_test {
+
+// answers every GET with the whole body, then closes connection
+inline server_test::LocalServer::Handler wholeBody(const std::string &body) {
+  return [body](asio::ip::tcp::socket &socket, const std::string &head) {
+    server_test::reply(socket, "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body);
+    return false;
+  };
+}
+
+// announces a body longer than what it sends, then closes connection
+inline server_test::LocalServer::Handler truncated(const std::string &body) {
+  return [body](asio::ip::tcp::socket &socket, const std::string &head) {
+    server_test::reply(socket, "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body.size() * 2) + "\r\n\r\n" + body);
+    return false;
+  };
+}
+
+// announces a body longer than what it sends, then stalls until client goes away
+inline server_test::LocalServer::Handler stalling(const std::string &body) {
+  return [body](asio::ip::tcp::socket &socket, const std::string &head) {
+    server_test::reply(socket, "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body.size() * 2) + "\r\n\r\n" + body);
+
+    char ignored;
+    asio::error_code ec;
+    asio::read(socket, asio::buffer(&ignored, 1), ec);
+    return false;
+  };
+}
+
+// metadata resolved to a stream of server, valid for an hour
+inline void resolveTo(AudioTube::VideoMetadata* metadata, const server_test::LocalServer &server) {
+  auto expire = std::to_string(std::time(nullptr) + 3600);
+  metadata->audioStreams()->feedRaw_DASH(
+    R"(<MPD><Period><AdaptationSet mimeType="audio/webm"><Representation id="251" codecs="opus" bandwidth="160000">)"
+    "<BaseURL>" + server.url("/videoplayback/expire/" + expire + "/itag/251/") + "</BaseURL>"
+    "</Representation></AdaptationSet></Period></MPD>", nullptr);
+  metadata->setRanOnce();
+}
+
+inline std::string someBody(size_t size) {
+  std::string body;
+  for (size_t i = 0; i < size; i++) body += static_cast<char>('a' + i % 26);
+  return body;
+}
+
+}  // namespace prefetch_test
+
+TEST_CASE("Prefetch buffer - reads whole small streams", "[prefetch]") {
+  auto body = prefetch_test::someBody(1000);
+  server_test::LocalServer server(prefetch_test::wholeBody(body));
+
+  AudioTube::PrefetchBuffer prefetch;
+  prefetch.start(server.url("/audio"), 4096);
+  REQUIRE(prefetch.isStarted());
+  REQUIRE(prefetch.capacity() == 4096);
+
+  std::string received;
+  char chunk[256];
+  while (auto count = prefetch.read(chunk, sizeof(chunk))) received.append(chunk, count);
+  REQUIRE(received == body);
+
+  prefetch.stop();
+  REQUIRE_FALSE(prefetch.isStarted());
+  REQUIRE(prefetch.capacity() == 0);
+}
+
+TEST_CASE("Prefetch buffer - hands buffered bytes and connection over", "[prefetch]") {
+  auto body = prefetch_test::someBody(64 * 1024);
+  server_test::LocalServer server(prefetch_test::wholeBody(body));
+
+  AudioTube::PrefetchBuffer prefetch;
+  prefetch.start(server.url("/audio"), 4096);
+
+  // consumer already read some
+  char chunk[100];
+  std::string received;
+  while (received.size() < 100) received.append(chunk, prefetch.read(chunk, 100 - received.size()));
+
+  // let it fill up
+  auto start = std::chrono::steady_clock::now();
+  while (prefetch.buffered() < 4096 && std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  auto handoff = prefetch.takeOver();
+  REQUIRE_FALSE(prefetch.isStarted());
+  REQUIRE(handoff.url == server.url("/audio"));
+  REQUIRE(handoff.offset == 100);
+  REQUIRE(handoff.bytes.size() == 4096);
+  REQUIRE(handoff.connection);
+
+  // connection continues right after buffered bytes
+  received.append(handoff.bytes.begin(), handoff.bytes.end());
+  char rest[4096];
+  while (auto count = handoff.connection->read(rest, sizeof(rest))) received.append(rest, count);
+  REQUIRE(received == body);
+}
+
+TEST_CASE("Prefetch buffer - dropped connection is no end of stream", "[prefetch]") {
+  auto body = prefetch_test::someBody(1000);
+  server_test::LocalServer server(prefetch_test::truncated(body));
+
+  AudioTube::PrefetchBuffer prefetch;
+  prefetch.start(server.url("/audio"), 4096);
+
+  std::string received;
+  char chunk[256];
+  auto readAll = [&]() { while (auto count = prefetch.read(chunk, sizeof(chunk))) received.append(chunk, count); };
+  REQUIRE_THROWS_AS(readAll(), std::runtime_error);
+  REQUIRE(received == body);
+}
+
+TEST_CASE("Prefetch buffer - takeover drops a stalled connection", "[prefetch]") {
+  auto body = prefetch_test::someBody(1000);
+  server_test::LocalServer server(prefetch_test::stalling(body));
+
+  AudioTube::PrefetchBuffer prefetch;
+  prefetch.start(server.url("/audio"), 4096);
+
+  auto start = std::chrono::steady_clock::now();
+  while (prefetch.buffered() < body.size() && std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  // bytes are kept, consumer reconnects from there
+  start = std::chrono::steady_clock::now();
+  auto handoff = prefetch.takeOver(std::chrono::milliseconds(100));
+  REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(2));
+  REQUIRE_FALSE(prefetch.isStarted());
+  REQUIRE(handoff.offset == 0);
+  REQUIRE(std::string(handoff.bytes.begin(), handoff.bytes.end()) == body);
+  REQUIRE_FALSE(handoff.connection);
+}
+
+TEST_CASE("Prefetch buffer - shared by metadata copies", "[prefetch]") {
+  AudioTube::VideoMetadata metadata("MnoajJelaAo", AudioTube::VideoMetadata::InstantiationType::InstFromId);
+  auto copy = metadata;
+
+  REQUIRE(copy.id() == metadata.id());
+  REQUIRE(copy.prefetch() == metadata.prefetch());
+}
+
+TEST_CASE("Playlist prefetcher - releases a replaced playlist before returning", "[prefetch]") {
+  server_test::LocalServer server(prefetch_test::stalling(prefetch_test::someBody(1000)));
+
+  auto current = new AudioTube::VideoMetadata("MnoajJelaAo", AudioTube::VideoMetadata::InstantiationType::InstFromId);
+  auto next = new AudioTube::VideoMetadata("qyYFF3Eh6lw", AudioTube::VideoMetadata::InstantiationType::InstFromId);
+  prefetch_test::resolveTo(current, server);
+  prefetch_test::resolveTo(next, server);
+
+  AudioTube::PlaylistPrefetcher::Settings settings;
+  settings.lookAhead = 1;
+  AudioTube::PlaylistPrefetcher prefetcher(settings);
+  prefetcher.setPlaylist({ current, next });
+
+  auto start = std::chrono::steady_clock::now();
+  while (!next->prefetch()->isStarted() && std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  REQUIRE(next->prefetch()->isStarted());
+
+  // safe to delete right away
+  prefetcher.setPlaylist({});
+  REQUIRE_FALSE(next->prefetch()->isStarted());
+  delete current;
+  delete next;
+}
@@ -0,0 +1,71 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <asio.hpp>
+
+#include <audiotube/StreamProber.h>
+
+#include <string>
+#include <vector>
+
+#include "server.hpp"
+
+#include <catch2/catch.hpp>
+
+namespace prober_test {
+
+// answers every request with 1 byte of partial content, keeping connections alive
+inline bool partialContent(asio::ip::tcp::socket &socket, const std::string &head) {
+  return server_test::reply(socket, "HTTP/1.1 206 Partial Content\r\nContent-Range: bytes 0-0/1000\r\nContent-Length: 1\r\n\r\nx");
+}
+
+}  // namespace prober_test
+
+TEST_CASE("Stream prober reuses kept-alive connections", "[prober]") {
+  server_test::LocalServer server(prober_test::partialContent);
+
+  {
+    AudioTube::StreamProber prober;
+
+    auto result = prober.probe(server.url("/stream"));
+    REQUIRE(result.available);
+    REQUIRE(result.statusCode == 206);
+    REQUIRE(result.totalSize == 1000);
+    REQUIRE(prober.idleConnections() == 1);
+
+    std::vector<std::string> urls(5, server.url("/stream"));
+    auto results = prober.probeAll(urls, 1);
+    REQUIRE(results.size() == 5);
+    for (const auto &probed : results) REQUIRE(probed.available);
+
+    REQUIRE(server.connections() == 1);
+  }
+}
+
+TEST_CASE("Stream prober reports unreachable streams", "[prober]") {
+  AudioTube::StreamProber prober;
+
+  // nothing listens there once server is gone
+  std::string url;
+  {
+    server_test::LocalServer server(prober_test::partialContent);
+    url = server.url("/stream");
+  }
+
+  auto result = prober.probe(url);
+  REQUIRE_FALSE(result.available);
+  REQUIRE(result.statusCode == 0);
+}
@@ -0,0 +1,194 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <asio.hpp>
+
+#include <audiotube/AudioProxyServer.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "server.hpp"
+
+#include <catch2/catch.hpp>
+
+namespace proxy_test {
+
+// answers ranged GETs over a fixed body
+inline server_test::LocalServer::Handler rangesOf(const std::string &body) {
+  return [body](asio::ip::tcp::socket &socket, const std::string &head) {
+    static const std::string rangeTag = "Range: bytes=";
+    auto rangeAt = head.find(rangeTag);
+    if (rangeAt == std::string::npos) return false;
+
+    auto first = std::stoull(head.substr(rangeAt + rangeTag.size()));
+    auto last = std::min<uint64_t>(std::stoull(head.substr(head.find('-', rangeAt) + 1)), body.size() - 1);
+    auto part = body.substr(first, last - first + 1);
+
+    server_test::reply(socket, "HTTP/1.1 206 Partial Content\r\nContent-Type: audio/webm\r\nContent-Range: bytes " + std::to_string(first) + "-"
+                              + std::to_string(last) + "/" + std::to_string(body.size()) + "\r\nContent-Length: " + std::to_string(part.size())
+                              + "\r\nConnection: close\r\n\r\n" + part);
+    return false;
+  };
+}
+
+// proxies any video to a local upstream
+class LocalProxy : public AudioTube::AudioProxyServer {
+ public:
+  LocalProxy(const std::string &upstreamUrl, const Settings &settings) : AudioProxyServer(settings), _upstreamUrl(upstreamUrl) {}
+
+ protected:
+  _Source _locate(const std::string &videoId, _Upstream &upstream, bool forceRefresh) override {
+    return { this->_upstreamUrl, 251 };
+  }
+
+ private:
+  std::string _upstreamUrl;
+};
+
+// whole response to a GET of range through proxy
+inline std::string fetch(unsigned short port, const std::string &videoId, const std::string &range) {
+  asio::io_context ioContext;
+  asio::ip::tcp::socket client(ioContext);
+  client.connect(asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), port));
+
+  std::string request = "GET /" + videoId + " HTTP/1.1\r\nHost: 127.0.0.1\r\nRange: bytes=" + range + "\r\n\r\n";
+  asio::write(client, asio::buffer(request));
+
+  std::string response;
+  asio::error_code ec;
+  asio::read(client, asio::dynamic_buffer(response), ec);
+  return response;
+}
+
+}  // namespace proxy_test
+
+TEST_CASE("Audio proxy - client Range header", "[proxy]") {
+  using AudioTube::AudioProxyServer;
+
+  // bounded
+  auto range = AudioProxyServer::parseRange("bytes=0-499", 1000);
+  REQUIRE(range);
+  REQUIRE(range->first == 0);
+  REQUIRE(range->last == 499);
+
+  // open-ended, and clamped
+  range = AudioProxyServer::parseRange("bytes=500-", 1000);
+  REQUIRE(range);
+  REQUIRE(range->first == 500);
+  REQUIRE(range->last == 999);
+
+  range = AudioProxyServer::parseRange("bytes=900-5000", 1000);
+  REQUIRE(range);
+  REQUIRE(range->last == 999);
+
+  // suffix
+  range = AudioProxyServer::parseRange("bytes=-100", 1000);
+  REQUIRE(range);
+  REQUIRE(range->first == 900);
+  REQUIRE(range->last == 999);
+
+  range = AudioProxyServer::parseRange("bytes=-5000", 1000);
+  REQUIRE(range);
+  REQUIRE(range->first == 0);
+
+  // unsatisfiable or unsupported
+  REQUIRE_FALSE(AudioProxyServer::parseRange("bytes=1000-", 1000));
+  REQUIRE_FALSE(AudioProxyServer::parseRange("bytes=500-100", 1000));
+  REQUIRE_FALSE(AudioProxyServer::parseRange("bytes=0-1,5-9", 1000));
+  REQUIRE_FALSE(AudioProxyServer::parseRange("items=0-1", 1000));
+  REQUIRE_FALSE(AudioProxyServer::parseRange("bytes=-0", 1000));
+}
+
+TEST_CASE("Audio proxy - serves ranges, then shuts down", "[proxy]") {
+  std::string body;
+  for (int i = 0; i < 1000; i++) body += static_cast<char>('a' + i % 26);
+  server_test::LocalServer upstream(proxy_test::rangesOf(body));
+
+  std::string response;
+  auto start = std::chrono::steady_clock::now();
+  {
+    AudioTube::AudioProxyServer::Settings settings;
+    settings.chunkSize = 64;
+    proxy_test::LocalProxy proxy(upstream.url("/audio"), settings);
+
+    asio::io_context ioContext;
+    asio::ip::tcp::socket client(ioContext);
+    client.connect(asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), proxy.port()));
+
+    std::string request = "GET /someVideoId HTTP/1.1\r\nHost: 127.0.0.1\r\nRange: bytes=100-299\r\n\r\n";
+    asio::write(client, asio::buffer(request));
+
+    asio::error_code ec;
+    asio::read(client, asio::dynamic_buffer(response), ec);
+    REQUIRE(ec == asio::error::eof);
+  }
+  REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+
+  auto bodyAt = response.find("\r\n\r\n");
+  REQUIRE(bodyAt != std::string::npos);
+  REQUIRE(response.rfind("HTTP/1.1 206 Partial Content", 0) == 0);
+  REQUIRE(response.find("Content-Range: bytes 100-299/1000") < bodyAt);
+  REQUIRE(response.substr(bodyAt + 4) == body.substr(100, 200));
+}
+
+TEST_CASE("Audio proxy - shuts down while idle", "[proxy]") {
+  auto start = std::chrono::steady_clock::now();
+  {
+    AudioTube::AudioProxyServer proxy;
+    REQUIRE(proxy.port());
+  }
+  REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+}
+
+TEST_CASE("Audio proxy - shuts down while a client is connected", "[proxy]") {
+  asio::io_context ioContext;
+  asio::ip::tcp::socket client(ioContext);
+
+  auto start = std::chrono::steady_clock::now();
+  {
+    AudioTube::AudioProxyServer proxy;
+    client.connect(asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), proxy.port()));
+
+    // request never completes, session waits for the rest
+    asio::write(client, asio::buffer(std::string("GET /someVideoId HTTP/1.1\r\n")));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+}
+
+TEST_CASE("Audio proxy - forgets least recently used videos", "[proxy]") {
+  std::string body(1000, 'x');
+  server_test::LocalServer upstream(proxy_test::rangesOf(body));
+
+  AudioTube::AudioProxyServer::Settings settings;
+  settings.maxUpstreams = 1;
+  proxy_test::LocalProxy proxy(upstream.url("/audio"), settings);
+
+  // resolving probes upstream once, then each chunk is fetched
+  auto requestsFor = [&](const std::string &videoId) {
+    auto before = upstream.requests();
+    auto response = proxy_test::fetch(proxy.port(), videoId, "0-9");
+    REQUIRE(response.rfind("HTTP/1.1 206 Partial Content", 0) == 0);
+    return upstream.requests() - before;
+  };
+
+  REQUIRE(requestsFor("first") == 2);
+  REQUIRE(requestsFor("first") == 1);
+  REQUIRE(requestsFor("second") == 2);
+  REQUIRE(requestsFor("first") == 2);
+}
@@ -0,0 +1,146 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+
+#pragma once
+
+#include <asio.hpp>
+
+#include <audiotube/RateLimiter.h>
+#include <audiotube/_NetworkHelper.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "server.hpp"
+
+#include <catch2/catch.hpp>
+
+namespace ratelimiter_test {
+
+// exposes throttling helpers
+class Throttling : public AudioTube::NetworkHelper {
+ public:
+  using AudioTube::NetworkHelper::_isThrottled;
+  using AudioTube::NetworkHelper::_retryAfter;
+};
+
+// answers "429 Too Many Requests" with a Retry-After of 1 second to first request, then 200 to the next ones
+inline server_test::LocalServer::Handler throttling() {
+  auto answered = std::make_shared<std::atomic<unsigned int>>(0);
+  return [answered](asio::ip::tcp::socket &socket, const std::string &head) {
+    server_test::reply(socket, (*answered)++ ?
+      "HTTP/1.1 200 OK\r\nContent-Length: 2\r\nConnection: close\r\n\r\nok" :
+      "HTTP/1.1 429 Too Many Requests\r\nRetry-After: 1\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+    return false;
+  };
+}
+
+inline AudioTube::RateLimiter::Metrics metricsOf(AudioTube::RateLimiter* limiter, const std::string &host) {
+  for (const auto &metrics : limiter->metrics()) {
+    if (metrics.host == host) return metrics;
+  }
+  return AudioTube::RateLimiter::Metrics();
+}
+
+}  // namespace ratelimiter_test
+
+TEST_CASE("Rate limiter - token bucket", "[ratelimiter]") {
+  AudioTube::RateLimiter limiter;
+  AudioTube::RateLimiter::Settings settings;
+  settings.requestsPerSecond = 10;
+  settings.burst = 3;
+  limiter.setSettings(settings);
+
+  // burst goes through right away
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 3; i++) limiter.acquire("host");
+  REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(50));
+  REQUIRE(ratelimiter_test::metricsOf(&limiter, "host").availableTokens < 1);
+
+  // then one token every 100ms
+  limiter.acquire("host");
+  limiter.acquire("host");
+  REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(150));
+
+  // hosts are independent
+  auto otherStart = std::chrono::steady_clock::now();
+  limiter.acquire("other");
+  REQUIRE(std::chrono::steady_clock::now() - otherStart < std::chrono::milliseconds(50));
+
+  auto metrics = ratelimiter_test::metricsOf(&limiter, "host");
+  REQUIRE(metrics.requests == 5);
+  REQUIRE(metrics.throttled == 0);
+}
+
+TEST_CASE("Rate limiter - penalties block host until over, or deadline", "[ratelimiter]") {
+  AudioTube::RateLimiter limiter;
+
+  limiter.penalize("host", std::chrono::milliseconds(300));
+  auto metrics = ratelimiter_test::metricsOf(&limiter, "host");
+  REQUIRE(metrics.throttled == 1);
+  REQUIRE(metrics.blockedFor > std::chrono::milliseconds(0));
+
+  // deadline comes first
+  AudioTube::Deadline::Timeouts timeouts;
+  timeouts.total = std::chrono::milliseconds(100);
+  REQUIRE_THROWS_AS(limiter.acquire("host", AudioTube::Deadline(timeouts)), AudioTube::DeadlineExceededError);
+
+  auto start = std::chrono::steady_clock::now();
+  limiter.acquire("host");
+  REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(100));
+}
+
+TEST_CASE("Rate limiter - decorrelated backoff stays within bounds", "[ratelimiter]") {
+  AudioTube::RateLimiter limiter;
+  AudioTube::RateLimiter::Settings settings;
+  settings.backoffBase = std::chrono::milliseconds(500);
+  settings.backoffCap = std::chrono::milliseconds(4000);
+  limiter.setSettings(settings);
+
+  auto backoff = settings.backoffBase;
+  for (int i = 0; i < 50; i++) {
+    auto next = limiter.nextBackoff(backoff);
+    REQUIRE(next >= settings.backoffBase);
+    REQUIRE(next <= std::min(settings.backoffCap, backoff * 3));
+    backoff = next;
+  }
+}
+
+TEST_CASE("Rate limiter - Retry-After is honored", "[ratelimiter]") {
+  AudioTube::NetworkHelper::Response response;
+  response.statusCode = 429;
+  response.headers = { "Retry-After: 7" };
+  REQUIRE(ratelimiter_test::Throttling::_isThrottled(response));
+  REQUIRE(ratelimiter_test::Throttling::_retryAfter(response) == std::chrono::seconds(7));
+
+  // HTTP-date form is left to backoff
+  response.headers = { "Retry-After: Wed, 21 Oct 2015 07:28:00 GMT" };
+  REQUIRE(ratelimiter_test::Throttling::_retryAfter(response) == std::chrono::milliseconds(0));
+
+  // through downloads, whole host is paused at least that long
+  server_test::LocalServer server(ratelimiter_test::throttling());
+  auto start = std::chrono::steady_clock::now();
+  auto downloaded = AudioTube::NetworkHelper::downloadHTTPS(server.url());
+  REQUIRE(downloaded.statusCode == 200);
+  REQUIRE(downloaded.messageBody == "ok");
+  REQUIRE(server.requests() == 2);
+  REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::seconds(1));
+
+  auto metrics = ratelimiter_test::metricsOf(&AudioTube::NetworkHelper::rateLimiter(), server.host());
+  REQUIRE(metrics.throttled == 1);
+  REQUIRE(metrics.retries == 1);
+}
@@ -0,0 +1,52 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <audiotube/Regexes.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+TEST_CASE("Fixed patterns, PCRE or compile-time", "[regexes]") {
+  using AudioTube::Regexes;
+
+  REQUIRE(Regexes::findYoutubeIds("https://www.youtube.com/watch?v=XarcApEC5ME") == std::vector<std::string> { "XarcApEC5ME" });
+  REQUIRE(Regexes::findYoutubeIds("https://youtu.be/embed/a-b_c") == std::vector<std::string> { "a-b_c" });
+  REQUIRE(Regexes::findYoutubeIds("https://vimeo.com/1").empty());
+
+  auto ids = Regexes::findHTTPRequestYTVideoIds("<a href=\"/watch?v=abc&amp;list=x\"><a href=\"/watch?v=def&amp;index=2\">");
+  REQUIRE(ids == std::vector<std::string> { "abc", "def" });
+
+  REQUIRE(Regexes::Decipherer_findCalledFunctions("a=Xy.Ab(a,3)") == std::vector<std::string> { "Ab" });
+
+  auto funcAndArguments = Regexes::Decipherer_findFuncAndArguments("Xy.Ab(a,31)");
+  REQUIRE(funcAndArguments.size() == 1);
+  REQUIRE(funcAndArguments[0].first == "Ab");
+  REQUIRE(funcAndArguments[0].second == "31");
+}
+
+TEST_CASE("Decipherer helper operations, in a single pass", "[regexes]") {
+  using AudioTube::Regexes;
+
+  auto helperOperations = Regexes::Decipherer_findHelperOperations(
+    "Ab:function(a){a.reverse()},\nCd:function(a,b){a.splice(0,b)},Ef:function(a,b){var c=a[0];a[0]=a[b%a.length];a[b%a.length]=c}");
+  REQUIRE(helperOperations.size() == 3);
+  REQUIRE(helperOperations[0] == std::make_pair(std::string("Ab"), AudioTube::CipherOperation::Reverse));
+  REQUIRE(helperOperations[1] == std::make_pair(std::string("Cd"), AudioTube::CipherOperation::Slice));
+  REQUIRE(helperOperations[2] == std::make_pair(std::string("Ef"), AudioTube::CipherOperation::Swap));
+}
@@ -0,0 +1,71 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <audiotube/SpscRingBuffer.h>
+
+#include <thread>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+TEST_CASE("SPSC ring buffer - wrap around and concurrent transfer", "[ring]") {
+  using AudioTube::SpscRingBuffer;
+
+  SpscRingBuffer<int> ring(4);
+  REQUIRE(ring.capacity() == 4);
+  REQUIRE(ring.writable() == 4);
+
+  int in[] = { 1, 2, 3, 4, 5 };
+  int out[5] = {};
+
+  // full, extra item refused
+  REQUIRE(ring.write(in, 5) == 4);
+  REQUIRE(ring.readable() == 4);
+  REQUIRE(ring.read(out, 3) == 3);
+  REQUIRE(out[2] == 3);
+
+  // wraps
+  REQUIRE(ring.write(in, 3) == 3);
+  REQUIRE(ring.read(out, 5) == 4);
+  REQUIRE(out[0] == 4);
+  REQUIRE(out[1] == 1);
+  REQUIRE(out[3] == 3);
+  REQUIRE(ring.readable() == 0);
+
+  // every item goes through once, in order
+  SpscRingBuffer<int> shared(64);
+  const size_t count = 100000;
+  std::thread producer([&shared]() {
+    for (size_t next = 0; next < count;) {
+      int batch[16];
+      auto batchSize = std::min<size_t>(16, count - next);
+      for (size_t i = 0; i < batchSize; i++) batch[i] = static_cast<int>(next + i);
+      next += shared.write(batch, batchSize);
+    }
+  });
+
+  std::vector<int> received;
+  while (received.size() < count) {
+    int batch[32];
+    auto got = shared.read(batch, 32);
+    received.insert(received.end(), batch, batch + got);
+  }
+  producer.join();
+
+  bool ordered = true;
+  for (size_t i = 0; i < count; i++) ordered = ordered && received[i] == static_cast<int>(i);
+  REQUIRE(ordered);
+}
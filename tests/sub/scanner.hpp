@@ -0,0 +1,54 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <string>
+
+#include <audiotube/PageScanner.h>
+
+#include <catch2/catch.hpp>
+
+TEST_CASE("Page anchors in a single pass", "[scanner]") {
+  using AudioTube::PageScanner;
+
+  std::string page = R"(<html><head>
+    <script nonce="n">var a = {"ytInitialPlayerResponse": null};</script>
+    <script src="/s/desktop/www-i18n.js"></script>
+    <script src="/s/player/4fbb4d5b/player_ias.vflset/en_US/base.js" nonce="n"></script>
+    <script>window["ytInitialPlayerResponse"] = null; var ytInitialPlayerResponse = {"videoDetails":{"title":"a } \" {"},"x":[{"y":{}}]};var meta = {};</script>
+    <script>ytcfg.set({'PLAYER_CONFIG': {"args":{"sts":"1"}}, "other": 1});</script>
+  </head></html>)";
+
+  auto anchors = PageScanner::scan(page);
+  REQUIRE(anchors.playerSourcePath == "/s/player/4fbb4d5b/player_ias.vflset/en_US/base.js");
+  REQUIRE(anchors.initialPlayerResponse == R"({"videoDetails":{"title":"a } \" {"},"x":[{"y":{}}]})");
+  REQUIRE(anchors.embedPlayerConfig == R"({"args":{"sts":"1"}})");
+  REQUIRE(anchors.signatureTimestamp.empty());
+
+  // only what is asked for
+  auto wanted = PageScanner::scan(page, PageScanner::PlayerSourcePath);
+  REQUIRE_FALSE(wanted.playerSourcePath.empty());
+  REQUIRE(wanted.initialPlayerResponse.empty());
+
+  // player source
+  auto sts = PageScanner::scan("var x=function(){signatureTimestamp:};var y={signatureTimestamp:18970,f:1}", PageScanner::SignatureTimestamp);
+  REQUIRE(sts.signatureTimestamp == "18970");
+  REQUIRE(PageScanner::scan("a.signatureTimestamp=19001;").signatureTimestamp == "19001");
+
+  // unbalanced objects are not reported
+  REQUIRE(PageScanner::scan(R"(var ytInitialPlayerResponse = {"a":{"b":1})").initialPlayerResponse.empty());
+  REQUIRE(PageScanner::closingBrace(R"({"a":"}"})", 0) == 8);
+  REQUIRE(PageScanner::closingBrace("x{}", 0) == std::string::npos);
+}
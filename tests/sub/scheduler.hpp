@@ -0,0 +1,116 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+
+#pragma once
+
+#include <audiotube/RefreshScheduler.h>
+#include <audiotube/VideoMetadata.h>
+
+#include <chrono>
+#include <ctime>
+#include <string>
+
+#include <catch2/catch.hpp>
+
+namespace scheduler_test {
+
+// exposes due date computation
+class Scheduler : public AudioTube::RefreshScheduler {
+ public:
+  using AudioTube::RefreshScheduler::RefreshScheduler;
+  using AudioTube::RefreshScheduler::_dueDateOf;
+  using AudioTube::RefreshScheduler::Clock;
+};
+
+// metadata whose prefered stream expires in that many seconds
+inline void expireIn(AudioTube::VideoMetadata* metadata, std::time_t seconds) {
+  auto expire = std::to_string(std::time(nullptr) + seconds);
+  metadata->audioStreams()->reset();
+  metadata->audioStreams()->feedRaw_DASH(
+    R"(<MPD><Period><AdaptationSet mimeType="audio/webm"><Representation id="251" codecs="opus" bandwidth="160000">)"
+    "<BaseURL>https://host/videoplayback/expire/" + expire + "/itag/251/</BaseURL>"
+    "</Representation></AdaptationSet></Period></MPD>", nullptr);
+}
+
+}  // namespace scheduler_test
+
+TEST_CASE("Refresh scheduler - due dates, ahead of expiration by margin and jitter", "[scheduler]") {
+  using Clock = scheduler_test::Scheduler::Clock;
+
+  AudioTube::RefreshScheduler::Settings settings;
+  settings.refreshMargin = std::chrono::seconds(300);
+  settings.maxJitter = std::chrono::milliseconds(30000);
+  scheduler_test::Scheduler scheduler(settings);
+
+  AudioTube::VideoMetadata metadata("MnoajJelaAo", AudioTube::VideoMetadata::InstantiationType::InstFromId);
+
+  // never fetched, right away
+  auto before = Clock::now();
+  auto dueAt = scheduler._dueDateOf(&metadata);
+  REQUIRE(dueAt >= before);
+  REQUIRE(dueAt <= Clock::now());
+
+  // within margin, right away too
+  scheduler_test::expireIn(&metadata, 200);
+  dueAt = scheduler._dueDateOf(&metadata);
+  REQUIRE(dueAt <= Clock::now());
+
+  // an hour left : margin and at most max jitter ahead, seconds rounding aside
+  scheduler_test::expireIn(&metadata, 3600);
+  auto earliest = Clock::now() + std::chrono::seconds(3600 - 300 - 30 - 2);
+  auto latest = Clock::now() + std::chrono::seconds(3600 - 300 + 2);
+
+  auto jittered = false;
+  auto first = scheduler._dueDateOf(&metadata);
+  for (int i = 0; i < 20; i++) {
+    dueAt = scheduler._dueDateOf(&metadata);
+    REQUIRE(dueAt >= earliest);
+    REQUIRE(dueAt <= latest);
+    if (std::chrono::abs(dueAt - first) > std::chrono::seconds(1)) jittered = true;
+  }
+  REQUIRE(jittered);
+}
+
+TEST_CASE("Refresh scheduler - no jitter when disabled", "[scheduler]") {
+  using Clock = scheduler_test::Scheduler::Clock;
+
+  AudioTube::RefreshScheduler::Settings settings;
+  settings.refreshMargin = std::chrono::seconds(60);
+  settings.maxJitter = std::chrono::milliseconds(0);
+  scheduler_test::Scheduler scheduler(settings);
+
+  AudioTube::VideoMetadata metadata("MnoajJelaAo", AudioTube::VideoMetadata::InstantiationType::InstFromId);
+  scheduler_test::expireIn(&metadata, 600);
+
+  auto dueAt = scheduler._dueDateOf(&metadata);
+  REQUIRE(dueAt >= Clock::now() + std::chrono::seconds(600 - 60 - 2));
+  REQUIRE(dueAt <= Clock::now() + std::chrono::seconds(600 - 60 + 1));
+}
+
+TEST_CASE("Refresh scheduler - untracked before its due date is computed", "[scheduler]") {
+  AudioTube::RefreshScheduler scheduler;
+
+  // far from expiration, never refreshed
+  auto metadata = new AudioTube::VideoMetadata("MnoajJelaAo", AudioTube::VideoMetadata::InstantiationType::InstFromId);
+  scheduler_test::expireIn(metadata, 3600);
+
+  scheduler.track(metadata);
+  REQUIRE(scheduler.trackedCount() == 1);
+
+  // worker must not read it anymore
+  scheduler.untrack(metadata);
+  delete metadata;
+  REQUIRE(scheduler.trackedCount() == 0);
+}
@@ -0,0 +1,126 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+
+#pragma once
+
+#include <asio.hpp>
+
+#include <atomic>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace server_test {
+
+// Local HTTP server on an ephemeral port, each connection served on its own thread.
+// Handler answers a request head on the socket, and returns whether the connection is kept alive for a next request.
+class LocalServer {
+ public:
+  using Handler = std::function<bool(asio::ip::tcp::socket &socket, const std::string &head)>;
+
+  explicit LocalServer(const Handler &handler) : _handler(handler), _acceptor(_ioContext, asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0)) {
+    this->_thread = std::thread([this]() { this->_acceptLoop(); });
+  }
+
+  ~LocalServer() {
+    // wake up accept
+    this->_running = false;
+    asio::io_context ioContext;
+    asio::ip::tcp::socket waker(ioContext);
+    asio::error_code ec;
+    waker.connect(this->_acceptor.local_endpoint(), ec);
+    this->_thread.join();
+
+    // wake up sessions still waiting for their client
+    for (auto &session : this->_sessions) session.socket->shutdown(asio::ip::tcp::socket::shutdown_both, ec);
+    for (auto &session : this->_sessions) session.thread.join();
+  }
+
+  std::string host() const {
+    return "127.0.0.1:" + std::to_string(this->_acceptor.local_endpoint().port());
+  }
+
+  std::string url(const std::string &path = "/") const {
+    return "http://" + this->host() + path;
+  }
+
+  unsigned int connections() const {
+    return this->_connections;
+  }
+
+  unsigned int requests() const {
+    return this->_requests;
+  }
+
+ private:
+  struct _Session {
+    std::unique_ptr<asio::ip::tcp::socket> socket;
+    std::thread thread;
+  };
+
+  Handler _handler;
+  std::atomic<bool> _running { true };
+  std::atomic<unsigned int> _connections { 0 };
+  std::atomic<unsigned int> _requests { 0 };
+  asio::io_context _ioContext;
+  asio::ip::tcp::acceptor _acceptor;
+  std::thread _thread;
+
+  // only touched by accept thread, then by destructor once it is joined
+  std::list<_Session> _sessions;
+
+  void _acceptLoop() {
+    while (true) {
+      auto socket = std::make_unique<asio::ip::tcp::socket>(this->_ioContext);
+      asio::error_code ec;
+      this->_acceptor.accept(*socket, ec);
+      if (ec || !this->_running) return;
+
+      this->_connections++;
+      auto served = socket.get();
+      this->_sessions.push_back({ std::move(socket), std::thread([this, served]() { this->_serve(*served); }) });
+    }
+  }
+
+  void _serve(asio::ip::tcp::socket &socket) {
+    asio::streambuf request;
+    asio::error_code ec;
+
+    while (true) {
+      auto headSize = asio::read_until(socket, request, "\r\n\r\n", ec);
+      if (ec) break;
+
+      std::string head(asio::buffers_begin(request.data()), asio::buffers_begin(request.data()) + headSize);
+      request.consume(headSize);
+
+      this->_requests++;
+      if (!this->_handler(socket, head)) break;
+    }
+
+    // client reads up to end of stream
+    socket.shutdown(asio::ip::tcp::socket::shutdown_both, ec);
+  }
+};
+
+// writes a whole response, false if client went away
+inline bool reply(asio::ip::tcp::socket &socket, const std::string &response) {
+  asio::error_code ec;
+  asio::write(socket, asio::buffer(response), ec);
+  return !ec;
+}
+
+}  // namespace server_test
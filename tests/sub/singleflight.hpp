@@ -0,0 +1,124 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+
+#pragma once
+
+#include <audiotube/Singleflight.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <catch2/catch.hpp>
+
+TEST_CASE("Singleflight - followers share the leader result", "[singleflight]") {
+  AudioTube::Singleflight<std::string, int> inflight;
+  std::atomic<int> works { 0 };
+  std::promise<void> followerStarted;
+
+  // leader holds the key until follower joined
+  auto leader = std::async(std::launch::async, [&]() {
+    return inflight.run("key", [&]() {
+      works++;
+      followerStarted.get_future().wait();
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      return 42;
+    });
+  });
+
+  while (!works) std::this_thread::yield();
+  auto follower = std::async(std::launch::async, [&]() {
+    followerStarted.set_value();
+    return inflight.run("key", [&]() {
+      works++;
+      return 0;
+    });
+  });
+
+  REQUIRE(leader.get() == 42);
+  REQUIRE(follower.get() == 42);
+  REQUIRE(works == 1);
+
+  // key released once done
+  REQUIRE(inflight.run("key", [&]() { works++; return 7; }) == 7);
+  REQUIRE(works == 2);
+}
+
+TEST_CASE("Singleflight - exceptions fan out to every caller", "[singleflight]") {
+  AudioTube::Singleflight<std::string, int> inflight;
+  std::atomic<int> works { 0 };
+  std::promise<void> followerStarted;
+
+  auto leader = std::async(std::launch::async, [&]() {
+    return inflight.run("key", [&]() -> int {
+      works++;
+      followerStarted.get_future().wait();
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      throw std::runtime_error("upstream failed");
+    });
+  });
+
+  while (!works) std::this_thread::yield();
+  auto follower = std::async(std::launch::async, [&]() {
+    followerStarted.set_value();
+    return inflight.run("key", [&]() {
+      works++;
+      return 0;
+    });
+  });
+
+  REQUIRE_THROWS_WITH(leader.get(), "upstream failed");
+  REQUIRE_THROWS_WITH(follower.get(), "upstream failed");
+  REQUIRE(works == 1);
+
+  // failures are not kept either
+  REQUIRE(inflight.run("key", [&]() { return 7; }) == 7);
+}
+
+TEST_CASE("Singleflight - followers give up on their own deadline", "[singleflight]") {
+  AudioTube::Singleflight<std::string, int> inflight;
+  std::atomic<int> works { 0 };
+  std::promise<void> release;
+  auto released = release.get_future().share();
+
+  // leader never ends by itself
+  auto leader = std::async(std::launch::async, [&]() {
+    return inflight.run("key", [&]() {
+      works++;
+      released.wait();
+      return 42;
+    });
+  });
+  while (!works) std::this_thread::yield();
+
+  AudioTube::Deadline::Timeouts timeouts;
+  timeouts.total = std::chrono::milliseconds(100);
+  REQUIRE_THROWS_AS(inflight.run("key", [&]() { return 0; }, AudioTube::Deadline(timeouts)), AudioTube::DeadlineExceededError);
+
+  AudioTube::CancellationSource source;
+  auto token = source.token();
+  auto cancelled = std::async(std::launch::async, [&]() {
+    return inflight.run("key", [&]() { return 0; }, AudioTube::Deadline(AudioTube::Deadline::Timeouts(), token));
+  });
+  source.cancel();
+  REQUIRE_THROWS_AS(cancelled.get(), AudioTube::CancelledError);
+
+  release.set_value();
+  REQUIRE(leader.get() == 42);
+  REQUIRE(works == 1);
+}
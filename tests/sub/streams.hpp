@@ -0,0 +1,226 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <audiotube/StreamsManifest.h>
+#include <audiotube/MpdParser.h>
+#include <audiotube/PlayerResponse.h>
+
+#include <catch2/catch.hpp>
+
+static AudioTube::StreamsManifest streams_test_manifest() {
+  auto raw = R"({ "streamingData": { "adaptiveFormats": [
+    { "itag": 251, "url": "https://host/251?expire=4102444800&ei=x", "mimeType": "audio/webm; codecs=\"opus\"", "bitrate": 141000,
+      "contentLength": "3900000", "approxDurationMs": "215000", "audioSampleRate": "48000",
+      "initRange": { "start": "0", "end": "265" }, "indexRange": { "start": "266", "end": "645" } },
+    { "itag": 140, "url": "https://host/140", "mimeType": "audio/mp4; codecs=\"mp4a.40.2\"", "bitrate": 130000 },
+    { "itag": 249, "url": "https://host/videoplayback/expire/1000/itag/249", "mimeType": "audio/webm; codecs=\"opus\"", "bitrate": 57000, "contentLength": "1500000" },
+    { "itag": 250, "url": "https://host/250", "mimeType": "audio/webm; codecs=\"opus\"", "bitrate": 73000 },
+    { "itag": 248, "url": "https://host/248", "mimeType": "video/webm; codecs=\"vp9\"", "bitrate": 2000000 }
+  ] } })";
+
+  AudioTube::StreamsManifest manifest;
+  manifest.feedRaw_PlayerResponse(AudioTube::PlayerResponseParser::parse(raw).audioFormats, nullptr);
+  return manifest;
+}
+
+TEST_CASE("Stream descriptors are sorted and complete", "[streams]") {
+  auto manifest = streams_test_manifest();
+  auto source = manifest.preferedStreamSource();
+  const auto &streams = *source.second;
+
+  REQUIRE(source.first == AudioTube::StreamsManifest::PlayerResponse);
+  REQUIRE(streams.size() == 3);
+  REQUIRE(streams[0].itag == 249);
+  REQUIRE(streams[2].itag == 251);
+
+  const auto &best = manifest.preferedStream();
+  REQUIRE(best.url == "https://host/251?expire=4102444800&ei=x");
+  REQUIRE(best.mime == "audio/webm");
+  REQUIRE(best.codec == "opus");
+  REQUIRE(best.contentLength == 3900000);
+  REQUIRE(best.approxDurationMs == 215000);
+  REQUIRE(best.audioSampleRate == 48000);
+  REQUIRE(best.initRange->last == 265);
+  REQUIRE(best.indexRange->first == 266);
+  REQUIRE_FALSE(streams[0].initRange);
+}
+
+TEST_CASE("Stream selection policies", "[streams]") {
+  using Policy = AudioTube::StreamsManifest::SelectionPolicy;
+  auto manifest = streams_test_manifest();
+
+  REQUIRE(manifest.select(Policy::best())->itag == 251);
+  REQUIRE(manifest.select(Policy::highestUpTo(100000, "opus"))->itag == 250);
+  REQUIRE(manifest.select(Policy::smallestAtLeast(60000))->itag == 250);
+  REQUIRE(manifest.select(Policy::smallestAtLeast(0))->itag == 249);
+  REQUIRE(manifest.select(Policy::highestUpTo(50000)) == nullptr);
+  REQUIRE(manifest.select(Policy::highestUpTo(0, "vorbis")) == nullptr);
+}
+
+TEST_CASE("Stream expiry comes from its own url", "[streams]") {
+  using Policy = AudioTube::StreamsManifest::SelectionPolicy;
+  auto manifest = streams_test_manifest();
+
+  // prefered stream decides
+  REQUIRE(manifest.preferedStream().expiresAt == 4102444800);
+  REQUIRE(manifest.validUntil() == 4102444800);
+  REQUIRE_FALSE(manifest.isExpired());
+
+  const auto &smallest = *manifest.select(Policy::smallestAtLeast(0));
+  REQUIRE(smallest.expiresAt == 1000);
+  REQUIRE(manifest.validUntil(smallest) == 1000);
+
+  // no expire parameter, fallback if any
+  const auto &unsigned_ = *manifest.select(Policy::smallestAtLeast(60000));
+  REQUIRE(unsigned_.expiresAt == -1);
+  REQUIRE(manifest.validUntil(unsigned_) == -1);
+
+  manifest.setSecondsUntilExpiration(60);
+  REQUIRE(manifest.validUntil(unsigned_) > 1000);
+  REQUIRE(manifest.validUntil() == 4102444800);
+
+  manifest.reset();
+  REQUIRE(manifest.validUntil() == -1);
+  REQUIRE(manifest.isExpired());
+}
+
+TEST_CASE("Streams from player config adaptive formats", "[streams]") {
+  std::string raw =
+    "itag=248&type=video%2Fwebm%3B+codecs%3D%22vp9%22&bitrate=2000000&url=https%3A%2F%2Fhost%2F248,"
+    "itag=251&type=audio%2Fwebm%3B+codecs%3D%22opus%22&bitrate=141000&clen=3900000&init=0-265&index=266-645"
+      "&audio_sample_rate=48000&url=https%3A%2F%2Fhost%2F251%3Fexpire%3D4102444800%26ei%3Dx,"
+    "itag=250&type=audio%2Fwebm%3B+codecs%3D%22opus%22&bitrate=73000&sig=ABC&url=https%3A%2F%2Fhost%2F250%3Fei%3Dy,"
+    "itag=249&type=audio%2Fwebm%3B+codecs%3D%22opus%22&bitrate=57000&s=XYZ&url=https%3A%2F%2Fhost%2F249";
+
+  // no decipherer, ciphered stream is left out
+  AudioTube::StreamsManifest manifest;
+  manifest.feedRaw_PlayerConfig(raw, nullptr);
+
+  auto source = manifest.preferedStreamSource();
+  REQUIRE(source.first == AudioTube::StreamsManifest::PlayerConfig);
+  REQUIRE(source.second->size() == 2);
+
+  const auto &best = manifest.preferedStream();
+  REQUIRE(best.itag == 251);
+  REQUIRE(best.url == "https://host/251?expire=4102444800&ei=x");
+  REQUIRE(best.codec == "opus");
+  REQUIRE(best.contentLength == 3900000);
+  REQUIRE(best.audioSampleRate == 48000);
+  REQUIRE(best.initRange->last == 265);
+  REQUIRE(best.indexRange->last == 645);
+  REQUIRE(best.expiresAt == 4102444800);
+
+  const auto &signed_ = source.second->front();
+  REQUIRE(signed_.itag == 250);
+  REQUIRE(signed_.url == "https://host/250?ei=y&signature=ABC");
+}
+
+static const char* streams_test_mpd = R"(<?xml version="1.0" encoding="UTF-8"?>
+<MPD xmlns="urn:mpeg:DASH:schema:MPD:2011" type="static">
+  <!-- comment with <Representation id="0"> inside -->
+  <BaseURL>https://host/dash/</BaseURL>
+  <Period>
+    <AdaptationSet id="0" mimeType="audio/webm" subsegmentAlignment="true">
+      <Representation id="251" codecs="opus" audioSamplingRate="48000" bandwidth="160000">
+        <BaseURL>https://other/videoplayback/expire/4102444800/itag/251/</BaseURL>
+        <SegmentBase indexRange="266-645"><Initialization range="0-265"/></SegmentBase>
+      </Representation>
+      <Representation id="250" codecs="opus" audioSamplingRate="48000" bandwidth="80000">
+        <BaseURL>itag/250/</BaseURL>
+        <SegmentList><Initialization sourceURL="sq/0"/><SegmentURL media="sq/1"/><SegmentURL media="sq/2"/></SegmentList>
+      </Representation>
+    </AdaptationSet>
+    <AdaptationSet id="1" contentType="audio" mimeType="audio/mp4">
+      <Representation id="140" codecs="mp4a.40.2" bandwidth="144000"><BaseURL>itag/140/?a=1&amp;b=2</BaseURL></Representation>
+    </AdaptationSet>
+    <AdaptationSet id="2" mimeType="video/webm">
+      <Representation id="248" codecs="vp9" bandwidth="2000000"><BaseURL>itag/248/</BaseURL></Representation>
+    </AdaptationSet>
+  </Period>
+</MPD>)";
+
+TEST_CASE("MPD parsing, fed byte per byte", "[streams]") {
+  AudioTube::MpdParser parser;
+  std::string mpd(streams_test_mpd);
+  for (auto c : mpd) parser.feed(&c, 1);
+
+  REQUIRE(parser.isComplete());
+  REQUIRE(parser.representationsCount() == 4);
+
+  const auto &representations = parser.representations();
+  REQUIRE(representations.size() == 3);
+
+  const auto &segmentBase = representations[0];
+  REQUIRE(segmentBase.id == "251");
+  REQUIRE(segmentBase.bandwidth == 160000);
+  REQUIRE(segmentBase.audioSamplingRate == 48000);
+  REQUIRE(segmentBase.mimeType == "audio/webm");
+  REQUIRE(segmentBase.baseUrl == "https://other/videoplayback/expire/4102444800/itag/251/");
+  REQUIRE(segmentBase.initRange->last == 265);
+  REQUIRE(segmentBase.indexRange->first == 266);
+
+  const auto &segmentList = representations[1];
+  REQUIRE(segmentList.baseUrl == "https://host/dash/itag/250/");
+  REQUIRE(segmentList.initializationUrl == "https://host/dash/itag/250/sq/0");
+  REQUIRE(segmentList.segmentUrls.size() == 2);
+  REQUIRE(segmentList.segmentUrls[1] == "https://host/dash/itag/250/sq/2");
+
+  // typed by its set, escaped
+  REQUIRE(representations[2].id == "140");
+  REQUIRE(representations[2].mimeType == "audio/mp4");
+  REQUIRE(representations[2].baseUrl == "https://host/dash/itag/140/?a=1&b=2");
+}
+
+TEST_CASE("Streams from DASH manifest", "[streams]") {
+  AudioTube::StreamsManifest manifest;
+  manifest.feedRaw_DASH(streams_test_mpd, nullptr);
+
+  auto source = manifest.preferedStreamSource();
+  REQUIRE(source.first == AudioTube::StreamsManifest::DASH);
+  REQUIRE(source.second->size() == 2);
+
+  const auto &best = manifest.preferedStream();
+  REQUIRE(best.itag == 251);
+  REQUIRE(best.expiresAt == 4102444800);
+  REQUIRE(best.segmentUrls.empty());
+  REQUIRE(best.indexRange);
+
+  const auto &segmented = source.second->front();
+  REQUIRE(segmented.itag == 250);
+  REQUIRE(segmented.segmentUrls.size() == 3);
+  REQUIRE(segmented.segmentUrls[0] == "https://host/dash/itag/250/sq/0");
+
+  REQUIRE_THROWS(manifest.feedRaw_DASH("<MPD><Period/></MPD>", nullptr));
+}
+
+TEST_CASE("Segmented streams are never picked", "[streams]") {
+  AudioTube::StreamsManifest manifest;
+  manifest.feedRaw_DASH(R"(<MPD><Period><AdaptationSet mimeType="audio/webm"><BaseURL>https://host/dash/</BaseURL>
+    <Representation id="251" codecs="opus" bandwidth="160000"><BaseURL>itag/251/</BaseURL></Representation>
+    <Representation id="250" codecs="opus" bandwidth="320000">
+      <BaseURL>itag/250/</BaseURL>
+      <SegmentList><Initialization sourceURL="sq/0"/><SegmentURL media="sq/1"/></SegmentList>
+    </Representation>
+  </AdaptationSet></Period></MPD>)", nullptr);
+
+  // highest bitrate, but segmented
+  REQUIRE(manifest.preferedStreamSource().second->back().itag == 250);
+
+  REQUIRE(manifest.preferedStream().itag == 251);
+  REQUIRE(manifest.preferedUrl() == "https://host/dash/itag/251/");
+  REQUIRE(manifest.select(AudioTube::StreamsManifest::SelectionPolicy::best())->itag == 251);
+  REQUIRE_FALSE(manifest.select(AudioTube::StreamsManifest::SelectionPolicy::smallestAtLeast(200000)));
+}
@@ -0,0 +1,57 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <audiotube/UnavailabilityCache.h>
+
+#include <chrono>
+
+#include <catch2/catch.hpp>
+
+TEST_CASE("Unavailability cache - exponential backoff", "[cache]") {
+  using AudioTube::UnavailabilityCache;
+  using AudioTube::UnavailableVideoError;
+
+  UnavailabilityCache::clear();
+  UnavailabilityCache::setBackoff(std::chrono::seconds(60), std::chrono::seconds(150));
+
+  UnavailableVideoError error(UnavailableVideoError::Unplayable, "Video unavailable");
+  REQUIRE_FALSE(UnavailabilityCache::find("MnoajJelaAo"));
+
+  // 1st failure, base TTL
+  UnavailabilityCache::remember("MnoajJelaAo", error);
+  auto entry = UnavailabilityCache::find("MnoajJelaAo");
+  REQUIRE(entry);
+  REQUIRE(entry->failures == 1);
+  REQUIRE(entry->reason == UnavailableVideoError::Unplayable);
+  REQUIRE(entry->retryAfter <= UnavailabilityCache::Clock::now() + std::chrono::seconds(60));
+
+  // 2nd failure, doubled TTL
+  UnavailabilityCache::remember("MnoajJelaAo", error);
+  entry = UnavailabilityCache::find("MnoajJelaAo");
+  REQUIRE(entry->failures == 2);
+  REQUIRE(entry->retryAfter > UnavailabilityCache::Clock::now() + std::chrono::seconds(100));
+
+  // 3rd failure, capped
+  UnavailabilityCache::remember("MnoajJelaAo", error);
+  entry = UnavailabilityCache::find("MnoajJelaAo");
+  REQUIRE(entry->retryAfter <= UnavailabilityCache::Clock::now() + std::chrono::seconds(150));
+
+  // success clears
+  UnavailabilityCache::forget("MnoajJelaAo");
+  REQUIRE_FALSE(UnavailabilityCache::find("MnoajJelaAo"));
+
+  UnavailabilityCache::setBackoff(std::chrono::seconds(600), std::chrono::seconds(86400));
+}
@@ -40,3 +40,42 @@ TEST_CASE("URL Parsing - no slash for path", "[URL]") {
   REQUIRE(up.host() == "www.google.com");
   REQUIRE(up.pathAndQuery() == "/");
 }
+
+TEST_CASE("URL Parsing - host and port", "[URL]") {
+  AudioTube::UrlParser up("http://127.0.0.1:8080/dQw4w9WgXcQ");
+  REQUIRE(up.host() == "127.0.0.1:8080");
+  REQUIRE(up.hostName() == "127.0.0.1");
+  REQUIRE(up.service() == "8080");
+
+  AudioTube::UrlParser noPort("https://www.youtube.com/watch?v=XarcApEC5ME");
+  REQUIRE(noPort.hostName() == "www.youtube.com");
+  REQUIRE(noPort.service() == "https");
+}
+
+TEST_CASE("Query tokenizer", "[URL]") {
+  std::string query = "itag=251&&type=audio%2Fwebm%3B+codecs%3D%22opus%22&flag&clen=";
+  AudioTube::QueryTokenizer tokenizer(query);
+  AudioTube::QueryTokenizer::Field field;
+
+  REQUIRE(tokenizer.next(&field));
+  REQUIRE(field.key == "itag");
+  REQUIRE(field.value == "251");
+  REQUIRE(field.value.data() == query.data() + 5);
+
+  // empty pairs skipped, values decoded on demand
+  REQUIRE(tokenizer.next(&field));
+  REQUIRE(field.key == "type");
+  REQUIRE(field.value == "audio%2Fwebm%3B+codecs%3D%22opus%22");
+  REQUIRE(field.decoded() == "audio/webm; codecs=\"opus\"");
+
+  REQUIRE(tokenizer.next(&field));
+  REQUIRE(field.key == "flag");
+  REQUIRE(field.value.empty());
+
+  REQUIRE(tokenizer.next(&field));
+  REQUIRE(field.key == "clen");
+  REQUIRE(field.value.empty());
+
+  REQUIRE_FALSE(tokenizer.next(&field));
+  REQUIRE(AudioTube::QueryTokenizer::decode("a%2Bb+c") == "a+b c");
+}
@@ -0,0 +1,138 @@
+// AudioTube C++
+// C++ fork based on https://github.com/Tyrrrz/YoutubeExplode
+// Copyright (C) 2019-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#pragma once
+
+#include <audiotube/WebmDemuxer.h>
+#include <audiotube/WebmSeekIndex.h>
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#include <catch2/catch.hpp>
+
+namespace webm_test {
+
+// id bytes, then size always coded on 8 bytes
+inline std::string element(const std::string &id, const std::string &body) {
+  std::string out = id + '\x01';
+  for (int shift = 48; shift >= 0; shift -= 8) out += static_cast<char>((body.size() >> shift) & 0xFF);
+  return out + body;
+}
+
+inline std::string block(int16_t relativeTimecode, char flags, const std::string &frames) {
+  return std::string("\x81") + static_cast<char>(relativeTimecode >> 8) + static_cast<char>(relativeTimecode & 0xFF) + flags + frames;
+}
+
+// 20ms CELT frames
+inline std::string frame(char payload, size_t size) {
+  return std::string("\xFC") + std::string(size - 1, payload);
+}
+
+inline std::string stream() {
+  auto a = frame('a', 10), b = frame('b', 300), c = frame('c', 5), d = frame('d', 4), e = frame('e', 4);
+
+  auto tracks = element("\x16\x54\xAE\x6B", element("\xAE",
+    element("\xD7", "\x01") + element("\x83", "\x02") + element("\x86", "A_OPUS")));
+
+  auto cluster = element(std::string("\xE7"), std::string("\x03\xE8", 2))                                   // 1000
+    + element("\xA3", block(0, '\x80', a))                                                                  // no lacing
+    + element("\xA3", block(20, '\x82', std::string("\x01") + std::string("\xFF\x2D", 2) + b + c))         // Xiph, 300 = 255 + 45
+    + element("\xA0", element("\xA1", block(60, '\x06', std::string("\x01\x85", 2) + c + d)))             // EBML
+    + element("\xA3", block(100, '\x84', std::string("\x01") + d + e));                                     // fixed
+
+  std::string segmentUnknownSize("\x18\x53\x80\x67\x01\xFF\xFF\xFF\xFF\xFF\xFF\xFF", 12);
+
+  return element("\x1A\x45\xDF\xA3", "header")
+    + segmentUnknownSize
+    + element("\x15\x49\xA9\x66", element(std::string("\x2A\xD7\xB1"), std::string("\x0F\x42\x40", 3)))  // 1ms
+    + tracks
+    + element("\x1C\x53\xBB\x6B", std::string(64, 'x'))                                                   // Cues, skipped
+    + element("\x1F\x43\xB6\x75", cluster);
+}
+
+}  // namespace webm_test
+
+TEST_CASE("WebM demuxer - laced Opus packets, whole or split input", "[demux]") {
+  using AudioTube::WebmDemuxer;
+
+  auto input = webm_test::stream();
+  std::vector<std::pair<std::string, int64_t>> expected {
+    { webm_test::frame('a', 10), 1000000000 },
+    { webm_test::frame('b', 300), 1020000000 },
+    { webm_test::frame('c', 5), 1040000000 },
+    { webm_test::frame('c', 5), 1060000000 },
+    { webm_test::frame('d', 4), 1080000000 },
+    { webm_test::frame('d', 4), 1100000000 },
+    { webm_test::frame('e', 4), 1120000000 }
+  };
+
+  for (size_t chunkSize : { input.size(), size_t(1), size_t(7) }) {
+    std::vector<std::pair<std::string, int64_t>> packets;
+    WebmDemuxer demuxer([&packets](const WebmDemuxer::Packet &packet) {
+      packets.emplace_back(std::string(packet.data), packet.timestampNs);
+    });
+
+    for (size_t offset = 0; offset < input.size(); offset += chunkSize) {
+      demuxer.feed(input.data() + offset, std::min(chunkSize, input.size() - offset));
+    }
+
+    REQUIRE(demuxer.opusTrack());
+    REQUIRE(demuxer.opusTrack()->number == 1);
+    REQUIRE(demuxer.position() == input.size());
+    REQUIRE(packets == expected);
+  }
+}
+
+TEST_CASE("WebM demuxer - Opus packet duration", "[demux]") {
+  using AudioTube::WebmDemuxer;
+
+  REQUIRE(WebmDemuxer::opusPacketDurationNs(std::string("\xFC", 1)) == 20000000);      // CELT 20ms, 1 frame
+  REQUIRE(WebmDemuxer::opusPacketDurationNs(std::string("\xFD", 1)) == 40000000);      // 2 frames
+  REQUIRE(WebmDemuxer::opusPacketDurationNs(std::string("\x1B\x03", 2)) == 180000000); // SILK 60ms, 3 frames
+  REQUIRE(WebmDemuxer::opusPacketDurationNs(std::string()) == 0);
+}
+
+TEST_CASE("WebM seek index - Cues to byte offsets", "[demux]") {
+  using AudioTube::WebmSeekIndex;
+  using webm_test::element;
+
+  // EBML header, then Segment of known size with Info
+  auto ebmlHeader = element("\x1A\x45\xDF\xA3", "header");
+  std::string segmentHeader("\x18\x53\x80\x67\x01\x00\x00\x00\x00\x0F\x42\x40", 12);
+  auto init = ebmlHeader + segmentHeader
+    + element("\x11\x4D\x9B\x74", std::string(20, 's'))                                                 // SeekHead
+    + element("\x15\x49\xA9\x66", element(std::string("\x2A\xD7\xB1"), std::string("\x0F\x42\x40", 3)))  // 1ms
+    + element("\x16\x54\xAE\x6B", "truncated");
+
+  auto cuePoint = [](const std::string &time, const std::string &position) {
+    return element("\xBB", element("\xB3", time) + element("\xB7", element("\xF7", "\x01") + element("\xF1", position)));
+  };
+  auto cues = element("\x1C\x53\xBB\x6B",
+    cuePoint(std::string("\x00", 1), std::string("\x01\x00", 2))        // 0s at 256
+    + cuePoint(std::string("\x13\x88", 2), std::string("\x10\x00", 2))  // 5s at 4096
+    + cuePoint(std::string("\x27\x10", 2), std::string("\x20\x00", 2))); // 10s at 8192
+
+  auto index = WebmSeekIndex::parse(init, cues);
+  auto dataStart = ebmlHeader.size() + segmentHeader.size();
+
+  REQUIRE(index.segmentDataStart() == dataStart);
+  REQUIRE(index.seekPoints().size() == 3);
+  REQUIRE(index.byteOffsetFor(0) == dataStart + 256);
+  REQUIRE(index.byteOffsetFor(4.99) == dataStart + 256);
+  REQUIRE(index.byteOffsetFor(5) == dataStart + 4096);
+  REQUIRE(index.byteOffsetFor(60) == dataStart + 8192);
+  REQUIRE(index.seekPointFor(7).seconds == 5);
+}
@@ -15,5 +15,20 @@
 #define CATCH_CONFIG_MAIN
 
 // #include "sub/network.hpp"
-// #include "sub/url.hpp"
+#include "sub/url.hpp"
+#include "sub/regexes.hpp"
 #include "sub/metadata.hpp"
+#include "sub/unavailability.hpp"
+#include "sub/proxy.hpp"
+#include "sub/chunkcache.hpp"
+#include "sub/webm.hpp"
+#include "sub/ringbuffer.hpp"
+#include "sub/streams.hpp"
+#include "sub/prober.hpp"
+#include "sub/extractor.hpp"
+#include "sub/scanner.hpp"
+#include "sub/connect.hpp"
+#include "sub/singleflight.hpp"
+#include "sub/prefetch.hpp"
+#include "sub/scheduler.hpp"
+#include "sub/ratelimiter.hpp"